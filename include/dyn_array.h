@@ -224,13 +224,26 @@ size_t dyn_array_data_size(const dyn_array_t *const dyn_array);
 /// compare(x,y) < 0 iff x < y
 /// compare(x,y) = 0 iff x == y
 /// compare(x,y) > 0 iff y > x
-/// Sort is not guaranteed to be stable
+/// The sort is a natural merge sort, so it is stable and input that is already sorted, or made of a few
+///  sorted runs, costs linear time. It falls back to an unstable qsort if its buffer can't be allocated.
+/// The array remembers compare and isn't sorted again by it until it may have changed: any insert other
+///  than insert_sorted with compare, for_each, or a call to front, back or at, whose pointers may be
+///  written through. Read through dyn_array_export to keep the order known. Removals keep it.
 /// \param dyn_array the dynamic array
 /// \param compare the comparison function
 /// \return bool representing success of the operation
 ///
 bool dyn_array_sort(dyn_array_t *const dyn_array, int (*const compare)(const void *, const void *));
 
+///
+/// Checks if the array is in order by compare, comparing each neighbouring pair
+/// unless the array was last sorted by compare and hasn't changed since
+/// \param dyn_array the dynamic array
+/// \param compare the comparison function
+/// \return true if the array is sorted (an empty one is), false if it isn't or on a bad parameter
+///
+bool dyn_array_is_sorted(const dyn_array_t *const dyn_array, int (*const compare)(const void *, const void *));
+
 
 ///
 /// Inserts the given object into the correct sorted position
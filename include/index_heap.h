@@ -0,0 +1,107 @@
+#ifndef INDEX_HEAP_H
+#define INDEX_HEAP_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct index_heap index_heap_t;
+
+/*
+	Index heap notes!
+
+	This is a binary min-heap of small integer ids (array slots, PCB indices, ...),
+	ordered by a caller supplied comparator that looks the keys up itself.
+
+	Because the heap remembers where every id sits, an id can be removed or re-sifted
+	after its key changed in O(log n), not just popped from the top.
+
+	Each id may be in the heap at most once. Memory for the position table grows with the largest id pushed.
+*/
+
+///
+/// Creates a new empty heap
+/// \param capacity Minimum id capacity request (0 is fine if you have no opinion)
+/// \param before Strict ordering, before(a, b, context) is true iff a must come out before b
+/// \param context Passed through to before
+/// \return new heap pointer, NULL on error
+///
+index_heap_t *index_heap_create(const size_t capacity, bool (*before)(size_t, size_t, void *), void *context);
+
+///
+/// Heap destructor
+/// \param heap The heap to destruct
+///
+void index_heap_destroy(index_heap_t *const heap);
+
+///
+/// Adds an id to the heap
+/// \param heap the heap
+/// \param id the id to add, must not already be in the heap
+/// \return bool representing success of the operation
+///
+bool index_heap_push(index_heap_t *const heap, const size_t id);
+
+///
+/// Reads the id that would be popped next without removing it
+/// \param heap the heap
+/// \param id destination for the top id
+/// \return false if the heap is empty (or NULL was given)
+///
+bool index_heap_peek(const index_heap_t *const heap, size_t *const id);
+
+///
+/// Removes the top id
+/// \param heap the heap
+/// \param id destination for the removed id
+/// \return false if the heap is empty (or NULL was given)
+///
+bool index_heap_pop(index_heap_t *const heap, size_t *const id);
+
+///
+/// Removes an id from anywhere in the heap
+/// \param heap the heap
+/// \param id the id to remove
+/// \return false if the id is not in the heap
+///
+bool index_heap_remove(index_heap_t *const heap, const size_t id);
+
+///
+/// Restores heap order after the key of id changed (in either direction)
+/// \param heap the heap
+/// \param id the id whose key changed
+/// \return false if the id is not in the heap
+///
+bool index_heap_update(index_heap_t *const heap, const size_t id);
+
+///
+/// Tests if the id is in the heap
+/// \param heap the heap
+/// \param id the id to look for
+/// \return true if it is, false otherwise
+///
+bool index_heap_contains(const index_heap_t *const heap, const size_t id);
+
+///
+/// Returns number of ids in the heap
+/// \param heap the heap
+/// \return the size of the heap, 0 on error
+///
+size_t index_heap_size(const index_heap_t *const heap);
+
+///
+/// Calls func on every id in the heap, in heap (not sorted) order
+/// \param heap the heap
+/// \param func the function to apply
+/// \param arg passed to func as parameter 2
+///
+void index_heap_for_each(const index_heap_t *const heap, void (*const func)(size_t, void *), void *arg);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
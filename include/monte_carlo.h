@@ -0,0 +1,97 @@
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+	// Monte Carlo sweeps: the chosen configs run on many seeded synthetic workloads, and every metric is
+	// reported as its mean over the workloads with a 95% confidence interval.
+	//
+	// Workloads are generated in memory, one per task, and a task runs every config on its workload through
+	// the simulator in scheduler.h. Tasks are spread over a pool of worker threads that each reuse their own
+	// buffers and share nothing but the next task index, so a sweep scales with the cores. Workload k only
+	// depends on the seed and k, and the means are summed in workload order, so the summaries are the same
+	// for any thread count.
+
+	// Shape of the synthetic workloads
+	typedef struct
+	{
+		size_t pcb_count;				// PCBs per workload
+		double mean_interarrival;		// arrivals are a Poisson process, the first at 0
+		double mean_burst;				// CPU bursts are exponential, at least 1 tick
+		uint32_t priority_levels;		// priorities are uniform over 0 .. priority_levels - 1, 0 gives all 0
+		uint32_t max_io_bursts;			// each PCB gets uniform 0 .. max_io_bursts IO bursts, each followed
+										// by another CPU burst
+		double mean_io_burst;			// IO bursts are exponential, at least 1 tick
+		double deadline_slack;			// deadline is arrival + slack * the PCB's CPU demand, 0 for no deadlines
+	}
+	MonteCarloWorkload_t;
+
+	typedef struct
+	{
+		MonteCarloWorkload_t workload;	// what to generate
+		size_t workloads;				// how many workloads, at least 2
+		uint64_t seed;					// picks the workloads
+		const ScheduleConfig_t *configs;// the policies to compare, traces are not supported
+		size_t config_count;
+		size_t threads;					// worker threads, 0 for one per online CPU
+	}
+	MonteCarloSweep_t;
+
+	// The metrics a sweep reports, read from ScheduleResult_t
+	typedef enum
+	{
+		MONTE_CARLO_WAITING_TIME,
+		MONTE_CARLO_TURNAROUND_TIME,
+		MONTE_CARLO_RUN_TIME,
+		MONTE_CARLO_CPU_UTILIZATION,
+		MONTE_CARLO_IO_UTILIZATION,
+		MONTE_CARLO_THROUGHPUT,
+		MONTE_CARLO_CONTEXT_SWITCHES,
+		MONTE_CARLO_MISSED_DEADLINES,
+		MONTE_CARLO_REJECTED,
+		MONTE_CARLO_DROPPED,
+		MONTE_CARLO_METRIC_COUNT
+	}
+	MonteCarloMetric_t;
+
+	typedef struct
+	{
+		double mean;
+		double half_width;				// the 95% confidence interval is mean +- half_width (Student's t)
+	}
+	MonteCarloEstimate_t;
+
+	typedef struct
+	{
+		MonteCarloEstimate_t metrics[MONTE_CARLO_METRIC_COUNT];
+	}
+	MonteCarloSummary_t;
+
+	// Generates one workload of a sweep, the same one monte_carlo_sweep runs as workload index
+	// \param shape what to generate
+	// \param seed the sweep seed
+	// \param index which workload
+	// \return the workload, free with pcb_workload_destroy, NULL on error or for an empty shape
+	PcbWorkload_t *monte_carlo_workload(const MonteCarloWorkload_t *shape, uint64_t seed, size_t index);
+
+	// Runs a sweep
+	// \param sweep the workloads, the configs and the thread count
+	// \param summaries destination for one summary per config, in config order
+	// \return true if function ran successful else false for an error (including an invalid config)
+	bool monte_carlo_sweep(const MonteCarloSweep_t *sweep, MonteCarloSummary_t *summaries);
+
+	// \return the name of metric for reports, NULL if it is out of range
+	const char *monte_carlo_metric_name(MonteCarloMetric_t metric);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,59 @@
+#ifndef OP_COUNTERS_H
+#define OP_COUNTERS_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+	// Counts of the operations the scheduling code spends its time on, for profiling.
+	//
+	// Every thread has counters of its own that are bumped without any synchronization, so counting
+	// costs an increment and threads running schedules side by side don't contend on them. A thread
+	// reads and resets only its own counters.
+	// Building with OP_COUNTERS_DISABLED defined (cmake -DOP_COUNTERS=OFF) compiles the counting out of the
+	// hot paths altogether, the counters then stay at 0.
+	typedef enum
+	{
+		OP_COMPARISONS,				// comparator calls of dyn_array sorts and sorted inserts, the index heaps and shard merges
+		OP_ARRAY_ACCESSES,			// dyn_array_at calls
+		OP_HEAP_OPERATIONS,			// index heap pushes, removes (pops included) and updates
+		OP_TICKS,					// clock ticks simulated, idle ones included
+		OP_EVENTS,					// simulator steps
+		OP_MEMMOVE_BYTES,			// bytes dyn_array shifts on insert and remove
+		OP_REALLOCS,				// dyn_array capacity growths
+		OP_READ_CALLS,				// read and pread calls loading and streaming PCB files
+		OP_RECORDS_DECODED,			// PCB file records decoded by loads and readers
+		OP_SORT_NANOSECONDS,		// time spent in dyn_array_sort and ordering the simulator's input
+		OP_COUNTER_COUNT
+	}
+	OpCounter_t;
+
+	typedef struct
+	{
+		uint64_t counts[OP_COUNTER_COUNT];
+	}
+	OpCounters_t;
+
+	// Reads the calling thread's counters
+	// \param counters destination for the counts since the thread started or last reset them
+	void op_counters_read(OpCounters_t *counters);
+
+	// Zeroes the calling thread's counters
+	void op_counters_reset(void);
+
+	// \return the name of counter for reports, NULL if it is out of range
+	const char *op_counter_name(OpCounter_t counter);
+
+	// \return false if the counting was compiled out
+	bool op_counters_enabled(void);
+
+	// \return nanoseconds on a monotonic clock, for timing phases against each other
+	uint64_t op_counters_clock(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,31 @@
+#ifndef PCB_SHARDS_H
+#define PCB_SHARDS_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "processing_scheduling.h"
+
+	// Loads a workload that comes split over several PCB files (shards), e.g. one per host or per hour.
+	//
+	// The shards are decoded by a pool of worker threads, each takes the next shard not yet taken, loads it
+	// and sorts it by arrival. The calling thread then merges the sorted shards with a loser tree, which
+	// costs about log2(shards) comparisons per PCB.
+
+	// Loads every shard and merges them into one workload in arrival order
+	// Ties go to the earlier shard, then the earlier record, so the order is that of a stable sort of the
+	// shards laid end to end. Each PCB's pid is its index in the merged workload, and the IO bursts of all
+	// PCBs share one allocation as with load_pcb_workload.
+	// \param paths the shard files, of any layout
+	// \param count the number of shards, at least 1
+	// \param threads worker threads, 0 for one per online CPU, never more than there are shards
+	// \return the merged workload else NULL for an error, including any shard that fails to load
+	PcbWorkload_t *load_pcb_shards(const char *const *paths, size_t count, size_t threads);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
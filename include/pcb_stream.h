@@ -0,0 +1,63 @@
+#ifndef PCB_STREAM_H
+#define PCB_STREAM_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+	// External memory access to PCB files too large to load: the PCBs come back in arrival order, ties in file
+	// order, without ever holding more than a bounded number of them in memory.
+	//
+	// Opening a stream sorts the file with an external merge sort. The file is read in runs of run_pcbs PCBs,
+	// each is sorted in memory and written to a temporary file, and the runs are merged PCB_STREAM_FAN_IN at a
+	// time until few enough are left to merge while reading. A file that fits in one run is never written out.
+	// Temporary files are unlinked as soon as they are created, nothing is left behind on a crash.
+	// Files with IO bursts aren't supported (see pcb_reader_open).
+	typedef struct pcb_stream PcbStream_t;
+
+	// Runs merged by one pass, each holds a read buffer while it is merged
+	#define PCB_STREAM_FAN_IN 64
+
+	// Opens a PCB file and sorts it by arrival
+	// \param input_file the file containing the PCBs
+	// \param run_pcbs PCBs sorted in memory at a time, at least 2
+	// \param temp_dir directory for the runs, NULL for the system's temporary directory
+	// \return the stream positioned at the earliest arrival, NULL on error
+	PcbStream_t *pcb_stream_open(const char *input_file, size_t run_pcbs, const char *temp_dir);
+
+	// Reads the next PCB in arrival order, its pid is its index in the file
+	// \param stream the open stream
+	// \param pcb destination for the PCB
+	// \return true if a PCB was read else false at the end or for an error, see pcb_stream_failed
+	bool pcb_stream_next(PcbStream_t *stream, ProcessControlBlock_t *pcb);
+
+	// \return true if reading a run failed, the PCBs read so far are then incomplete
+	bool pcb_stream_failed(const PcbStream_t *stream);
+
+	// \return the number of PCBs in the file
+	uint64_t pcb_stream_count(const PcbStream_t *stream);
+
+	// \return true if some PCB in the file has a deadline
+	bool pcb_stream_has_deadlines(const PcbStream_t *stream);
+
+	void pcb_stream_close(PcbStream_t *stream);
+
+	// Runs the rest of the stream through the simulator in scheduler.h, submitting each PCB only once the
+	// clock has reached its arrival. Memory follows the PCBs that have arrived and not yet completed, and
+	// the result equals sched_run over the loaded file.
+	// \param stream the open stream
+	// \param config the algorithm and its parameters
+	// \param result used for stat tracking \ref ScheduleResult_t
+	// \return true if function ran successful else false for an error
+	bool pcb_stream_schedule(PcbStream_t *stream, const ScheduleConfig_t *config, ScheduleResult_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
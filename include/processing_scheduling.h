@@ -9,30 +9,197 @@
 #include <stdint.h>
 
 #include "dyn_array.h"
+#include "schedule_trace.h"
 
 	typedef struct
 	{
 		uint32_t remaining_burst_time;// the remaining burst of the pcb
 		uint32_t priority;				// The priority of the task
-		uint32_t arrival;					// Time the process arrived in the ready queue
+		uint64_t arrival;					// Time the process arrived in the ready queue
 		bool started;						// If it has been activated on virtual CPU
+		uint32_t pid;						// Identifies the PCB in schedule traces (the loader uses the record index)
+		uint64_t deadline;					// Time the PCB should complete by, PCB_NO_DEADLINE for none
+		const uint32_t *next_bursts;		// Bursts after the first CPU burst, alternating IO then CPU, NULL for none
+		uint32_t next_burst_count;			// Entries in next_bursts, always even
 	} 
 	ProcessControlBlock_t;
 
 	typedef struct
 	{
-		float average_waiting_time;	// the average waiting time in the ready queue until first schedue on the cpu
-		float average_turnaround_time;// the average completion time of the PCBs
-		unsigned long total_run_time;	// the total time to process all the PCBs in the ready queue
+		double average_waiting_time;	// the average waiting time in the ready queue until first schedue on the cpu
+		double average_turnaround_time;// the average completion time of the PCBs
+		uint64_t total_run_time;		// the total time to process all the PCBs in the ready queue
+		uint64_t missed_deadlines;		// PCBs that completed after their deadline
+		uint64_t total_lateness;		// completion - deadline summed over the PCBs that missed
+		double cpu_utilization;			// fraction of total_run_time the CPUs were running bursts, averaged over the CPUs
+										// (switch overhead excluded)
+		double io_utilization;			// fraction of total_run_time the IO device was busy
+		double throughput;				// PCBs completed per tick of total_run_time
+		uint64_t context_switches;		// dispatches that put a different PCB on the CPU than the one before
+		uint64_t switch_overhead;		// ticks spent on those switches, cache warmup included
+		uint64_t rejected;				// arrivals turned away by a full ready queue
+		uint64_t dropped;				// waiting PCBs evicted to make room for a higher priority arrival
+		uint64_t time_at_capacity;		// ticks the ready queue spent full
 	} 
 	ScheduleResult_t;
 
+	typedef enum
+	{
+		SCHEDULE_FCFS,
+		SCHEDULE_SJF,
+		SCHEDULE_PRIORITY,
+		SCHEDULE_RR,
+		SCHEDULE_SRT,
+		SCHEDULE_PRIORITY_PREEMPTIVE,
+		SCHEDULE_MLFQ,
+		SCHEDULE_CFS,
+		SCHEDULE_EDF,
+		SCHEDULE_EDF_PREEMPTIVE,
+		SCHEDULE_HRRN
+	}
+	ScheduleAlgorithm_t;
+
+	// Which idle CPU a PCB is dispatched to, and which running PCB it displaces when it preempts
+	typedef enum
+	{
+		SCHEDULE_PLACE_FASTEST,			// the fastest CPU, ties to the lowest index
+		SCHEDULE_PLACE_ENERGY,			// the slowest CPU, efficiency cores first
+		SCHEDULE_PLACE_AFFINITY			// the CPU the PCB last ran on (its cache is there), else the fastest
+	}
+	SchedulePlacement_t;
+
+	// What happens to an arrival that finds the ready queue full
+	typedef enum
+	{
+		SCHEDULE_ADMIT_REJECT,			// it is turned away and never runs
+		SCHEDULE_ADMIT_DELAY,			// it waits, in arrival order, until a dispatch frees a place
+		SCHEDULE_ADMIT_DROP_LOWEST		// the lowest priority waiting PCB is evicted for it, unless that is the
+										// arrival itself (ties go against the latest arrival)
+	}
+	ScheduleAdmission_t;
+
+	// Speed of a CPU that runs one tick of burst per tick
+	#define SCHEDULE_SPEED_NOMINAL 1000
+
+	typedef struct
+	{
+		ScheduleAlgorithm_t algorithm;	// the policy to run
+		size_t quantum;					// time slice for SCHEDULE_RR, top level slice for SCHEDULE_MLFQ
+		ScheduleTrace_t *trace;			// optional per-PCB and slice trace sink, NULL to disable
+		uint64_t aging_interval;		// SCHEDULE_PRIORITY_PREEMPTIVE: ticks of waiting that raise a PCB one
+										// priority level, 0 disables aging
+		size_t levels;					// SCHEDULE_MLFQ: number of queues, 1 to SCHEDULE_MLFQ_MAX_LEVELS
+		const uint64_t *level_quanta;	// SCHEDULE_MLFQ: time slice of each level, top first, NULL doubles
+										// quantum at every level down
+		uint64_t boost_interval;		// SCHEDULE_MLFQ: ticks between moving every PCB back to the top level,
+										// 0 disables the boost
+		uint64_t target_latency;		// SCHEDULE_CFS: period in which every runnable PCB gets a slice
+		uint64_t min_granularity;		// SCHEDULE_CFS: smallest share of the period per runnable PCB, and
+										// how far behind an arrival must be to preempt
+		uint64_t switch_cost;			// ticks every context switch costs, for all policies
+		uint64_t warmup_cost;			// extra ticks a PCB switched in with a cold cache needs to refill it
+		uint64_t warmup_decay;			// ticks descheduled after which the cache is fully cold, the penalty
+										// grows linearly up to then; 0 charges the full penalty on every switch
+		size_t cpu_count;				// CPUs sharing the ready queue, 0 is one
+		const uint32_t *cpu_speeds;		// per CPU burst consumed per tick in 1 / SCHEDULE_SPEED_NOMINAL,
+										// NULL runs every CPU at SCHEDULE_SPEED_NOMINAL
+		SchedulePlacement_t placement;	// how PCBs are spread over the CPUs
+		size_t ready_capacity;			// PCBs the ready queue admits, 0 is unbounded. Only arrivals are held
+										// to it: preempted PCBs and PCBs back from IO always get back in
+		ScheduleAdmission_t admission;	// what happens to arrivals once the ready queue is at capacity
+	}
+	ScheduleConfig_t;
+
+	#define SCHEDULE_MLFQ_MAX_LEVELS 64
+
+	#define PCB_NO_DEADLINE 0
+
+	// PCB files come in two layouts, both little-endian:
+	//  v1: uint32_t count, then count records of { uint32_t burst, uint32_t priority, uint32_t arrival }
+	//  v2: uint32_t PCB_FILE_V2_MAGIC, uint32_t flags, uint64_t count,
+	//      then count records of { uint32_t burst, uint32_t priority, uint64_t arrival }
+	//      followed by uint64_t deadline when flags has PCB_FILE_FLAG_DEADLINE
+	//      and when flags has PCB_FILE_FLAG_BURSTS, after the records:
+	//      uint64_t offsets[count + 1], then uint32_t bursts[offsets[count]]
+	//      where PCB i's next_bursts are bursts[offsets[i]] up to bursts[offsets[i + 1]]
+	// v2 lifts the 32-bit limits on the record count and the arrival times. Unknown flags are rejected.
+	// The loader tells them apart by the magic, so a v1 file can't hold exactly 0x32424350 PCBs.
+	#define PCB_FILE_V2_MAGIC 0x32424350u // "PCB2"
+	#define PCB_FILE_FLAG_DEADLINE 0x1u
+	#define PCB_FILE_FLAG_BURSTS 0x2u
+
+	// PCBs loaded along with the storage their next_bursts point into
+	typedef struct
+	{
+		dyn_array_t *pcbs;		// ProcessControlBlock_t
+		uint32_t *bursts;		// every PCB's next_bursts back to back, NULL if no PCB has any
+	}
+	PcbWorkload_t;
+
 	// Reads the PCB values from the binary file into ProcessControlBlock_t
 	// for N number of PCB entries stored in the file
 	// \param input_file the file containing the PCB burst times
 	// \return a populated dyn_array of ProcessControlBlocks if function ran successful else NULL for an error
+	// (including files with IO bursts, those need load_pcb_workload)
 	dyn_array_t *load_process_control_blocks(const char *input_file);
 
+	// Reads a PCB file of any layout, IO bursts included. The bursts of all PCBs share one allocation.
+	// \param input_file the file containing the PCBs
+	// \return the loaded workload if function ran successful else NULL for an error
+	PcbWorkload_t *load_pcb_workload(const char *input_file);
+
+	void pcb_workload_destroy(PcbWorkload_t *workload);
+
+	// Reads a PCB file one PCB at a time, for files too large to load. Files with IO bursts aren't supported,
+	// their bursts come after every record.
+	typedef struct pcb_reader PcbReader_t;
+
+	// Opens a PCB file of either layout and checks its header
+	// \param input_file the file containing the PCBs
+	// \return the reader positioned at the first PCB else NULL for an error (including files with IO bursts)
+	PcbReader_t *pcb_reader_open(const char *input_file);
+
+	// \return the number of PCBs the file's header declares
+	uint64_t pcb_reader_count(const PcbReader_t *reader);
+
+	// Reads the next PCB, its pid is its index in the file as with load_process_control_blocks
+	// \param reader the open reader
+	// \param pcb destination for the PCB
+	// \return true if a PCB was read else false at the end of the file or for an error
+	bool pcb_reader_next(PcbReader_t *reader, ProcessControlBlock_t *pcb);
+
+	void pcb_reader_close(PcbReader_t *reader);
+
+	// Writes a PCB file one PCB at a time, for producers that don't know the count up front.
+	// The header is rewritten with the count on close, so the output must be a regular file.
+	typedef struct pcb_writer PcbWriter_t;
+
+	// Creates or truncates a PCB file
+	// \param output_file the file to write
+	// \param v1 write the v1 layout, else v2 without the deadline column or IO bursts
+	// \return the writer else NULL for an error
+	PcbWriter_t *pcb_writer_open(const char *output_file, bool v1);
+
+	// Appends a PCB, its pid isn't stored
+	// \param writer the open writer
+	// \param pcb the PCB, without a deadline or IO bursts, and with an arrival that fits 32 bits for v1
+	// \return true if the PCB was buffered else false, the file is then incomplete
+	bool pcb_writer_append(PcbWriter_t *writer, const ProcessControlBlock_t *pcb);
+
+	// \return the number of PCBs appended
+	uint64_t pcb_writer_count(const PcbWriter_t *writer);
+
+	// Writes out the buffered PCBs and the final count, then frees the writer
+	// \return true if the whole file was written else false for an error
+	bool pcb_writer_close(PcbWriter_t *writer);
+
+	// Writes the PCBs to a binary file in the v2 layout (see PCB_FILE_V2_MAGIC),
+	// with the deadline column and the IO bursts only if some PCB has them
+	// \param output_file the file to create or truncate
+	// \param pcbs a dyn_array of ProcessControlBlock_t
+	// \return true if the whole file was written else false for an error
+	bool save_process_control_blocks(const char *output_file, const dyn_array_t *pcbs);
+
 	// Runs the First Come First Served Process Scheduling algorithm over the incoming ready_queue
 	// \param ready queue a dyn_array of type ProcessControlBlock_t
 	// that contain be up to N elements
@@ -48,6 +215,14 @@
 	// There is no guarantee that the passed dyn_array_t will be the result of your implementation of load_process_control_blocks
 	bool shortest_job_first(dyn_array_t *ready_queue, ScheduleResult_t *result);
 
+	// Runs the Highest Response Ratio Next algorithm over the incoming ready_queue
+	// Non-preemptive, the next PCB is the one with the highest (wait + burst) / burst, ties by arrival.
+	// Long PCBs age into a high ratio, so unlike Shortest Job First they can't starve.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+	// \param result used for highest response ratio next stat tracking \ref ScheduleResult_t
+	// \return true if function ran successful else false for an error
+	bool highest_response_ratio_next(dyn_array_t *ready_queue, ScheduleResult_t *result);
+
 	// Runs the non-preemptive Priority algorithm over the incoming ready_queue
 	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
 	// \param result used for shortest job first stat tracking \ref ScheduleResult_t
@@ -70,6 +245,70 @@
 	// There is no guarantee that the passed dyn_array_t will be the result of your implementation of load_process_control_blocks
 	bool shortest_remaining_time_first(dyn_array_t *ready_queue, ScheduleResult_t *result);
 
+	// Runs the preemptive Priority algorithm with aging over the incoming ready_queue
+	// A waiting PCB gains one priority level (its value drops by one) per aging_interval ticks spent in the
+	// ready queue, fractions included, and keeps what it gained while it runs. An arrival or an aged PCB
+	// preempts the running one as soon as its value is strictly lower.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+	// \param result used for priority stat tracking \ref ScheduleResult_t
+	// \param aging_interval ticks of waiting per priority level gained, 0 for plain preemptive priority
+	// \return true if function ran successful else false for an error
+	bool priority_preemptive(dyn_array_t *ready_queue, ScheduleResult_t *result, uint64_t aging_interval);
+
+	// Runs the Multi-Level Feedback Queue algorithm over the incoming ready_queue
+	// PCBs arrive in the top level and drop one level each time they use up their level's time slice.
+	// Each level is Round Robin, a lower level only runs while every level above it is empty, and an
+	// arrival preempts a PCB from a lower level (which keeps its level). Every boost_interval ticks all
+	// PCBs go back to the top level. Use schedule_processes for per level time slices.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+	// \param result used for mlfq stat tracking \ref ScheduleResult_t
+	// \param levels the number of levels
+	// \param quantum the top level time slice, doubled at every level down
+	// \param boost_interval ticks between boosts, 0 for none
+	// \return true if function ran successful else false for an error
+	bool multi_level_feedback_queue(dyn_array_t *ready_queue, ScheduleResult_t *result, size_t levels, size_t quantum,
+									uint64_t boost_interval);
+
+	// Runs the Completely Fair Scheduler algorithm over the incoming ready_queue
+	// priority is the nice value + 20 (0 is nice -20, 20 is nice 0, anything above 39 is nice 19) and sets
+	// the PCB's weight. The PCB with the least weighted run time (vruntime) runs next, for its weighted
+	// share of max(target_latency, runnable PCBs * min_granularity). Arrivals start at the least vruntime
+	// in the queue and preempt when the running PCB is more than min_granularity ahead of them.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+	// \param result used for cfs stat tracking \ref ScheduleResult_t
+	// \param target_latency the scheduling period
+	// \param min_granularity the smallest share of the period
+	// \return true if function ran successful else false for an error
+	bool completely_fair_scheduler(dyn_array_t *ready_queue, ScheduleResult_t *result, uint64_t target_latency,
+								   uint64_t min_granularity);
+
+	// Runs the Earliest Deadline First algorithm over the incoming ready_queue
+	// PCBs without a deadline go after every PCB with one, ties go to the earlier arrival.
+	// The preemptive variant switches to an arrival with a strictly earlier deadline.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+	// \param result used for edf stat tracking, see missed_deadlines and total_lateness \ref ScheduleResult_t
+	// \param preemptive whether arrivals may preempt the running PCB
+	// \return true if function ran successful else false for an error
+	bool earliest_deadline_first(dyn_array_t *ready_queue, ScheduleResult_t *result, bool preemptive);
+
+	// Runs the scheduling algorithm chosen by config over the incoming ready_queue
+	// Each algorithm function above is this with a default config.
+	// Every policy runs on the simulator in scheduler.h, which leaves the ready queue as it is.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+	// \param config the algorithm, its parameters and the optional trace sink
+	// \param result used for stat tracking \ref ScheduleResult_t
+	// \return true if function ran successful else false for an error
+	bool schedule_processes(const dyn_array_t *ready_queue, const ScheduleConfig_t *config, ScheduleResult_t *result);
+
+	// Looks up an algorithm by its analysis CLI name (FCFS, SJF, P, RR, SRT, PP, MLFQ, CFS, EDF, EDFP, HRRN)
+	// \param name the CLI name
+	// \param algorithm destination for the matching algorithm
+	// \return true if the name is known else false
+	bool schedule_algorithm_from_name(const char *name, ScheduleAlgorithm_t *algorithm);
+
+	// \return the analysis CLI name of algorithm, NULL if it is out of range
+	const char *schedule_algorithm_name(ScheduleAlgorithm_t algorithm);
+
 	void process_control_block_destruct(void *element);
 
 #ifdef __cplusplus
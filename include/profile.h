@@ -0,0 +1,53 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+	// Process wide measurements for analysis --profile: hardware counters from perf_event and the peak
+	// resident set size. Hardware counters count the calling thread from profile_start on, in user space only,
+	// and are simply missing where the kernel, the CPU or perf_event_paranoid doesn't provide them.
+
+	typedef enum
+	{
+		PROFILE_CYCLES,
+		PROFILE_INSTRUCTIONS,
+		PROFILE_CACHE_MISSES,
+		PROFILE_HARDWARE_COUNT
+	}
+	ProfileHardware_t;
+
+	typedef struct
+	{
+		int fds[PROFILE_HARDWARE_COUNT];	// -1 for a counter that isn't available
+	}
+	Profile_t;
+
+	// Opens and starts whichever hardware counters are available
+	// \param profile the counters to start
+	void profile_start(Profile_t *profile);
+
+	// Reads one hardware counter
+	// \param profile the started counters
+	// \param counter which one
+	// \param value destination for its count
+	// \return false if the counter isn't available
+	bool profile_read(const Profile_t *profile, ProfileHardware_t counter, uint64_t *value);
+
+	// Closes the hardware counters
+	void profile_stop(Profile_t *profile);
+
+	// \return the peak resident set size of the process in KiB, 0 if it isn't known
+	uint64_t profile_peak_rss(void);
+
+	// \return the name of counter for reports, NULL if it is out of range
+	const char *profile_hardware_name(ProfileHardware_t counter);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,72 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+	// On-disk cache of schedule results, addressed by the content of the PCB file and the config it ran under.
+	//
+	// The file is append-only: a header, then fixed size records that each carry a checksum. Any number of
+	// processes, and threads sharing a handle, may look up and store at once. Stores append under an exclusive
+	// fcntl lock; lookups take no file lock, read the file through a shared mapping and skip records whose
+	// checksum doesn't match, so a record still being written or cut short by a crash is never returned.
+	// A handle indexes the records appended since its last lookup in a hash table, so once a cache is open a
+	// lookup costs O(1) plus the records added in the meantime.
+	// Records are in native byte order, and a cache written by a build with other result semantics
+	// (RESULT_CACHE_VERSION) is refused, never misread.
+	typedef struct result_cache ResultCache_t;
+
+	// Bumped whenever a change to the schedulers changes the result of some input and config
+	// 2: every policy runs on the simulator, RR keeps a FIFO and SRT's waiting time is the same on every path
+	#define RESULT_CACHE_VERSION 2
+
+	typedef struct
+	{
+		uint64_t input_hash;		// result_cache_hash_file of the PCB file
+		uint64_t input_size;		// its size in bytes
+		uint64_t config_hash;		// sched_config_hash of the config
+	}
+	ResultCacheKey_t;
+
+	// Opens a cache, creating an empty one if path doesn't exist
+	// \param path the cache file
+	// \return the cache, NULL on error or if path isn't a cache of this RESULT_CACHE_VERSION
+	ResultCache_t *result_cache_open(const char *path);
+
+	void result_cache_close(ResultCache_t *cache);
+
+	// Finds the latest result stored under key
+	// \param cache the cache
+	// \param key the input and config
+	// \param result destination for the result
+	// \param input_flags destination for the flags stored with it, may be NULL
+	// \return true on a hit else false
+	bool result_cache_lookup(ResultCache_t *cache, const ResultCacheKey_t *key, ScheduleResult_t *result,
+							 uint32_t *input_flags);
+
+	// Appends a result, a later store under the same key replaces it
+	// \param cache the cache
+	// \param key the input and config
+	// \param result the result
+	// \param input_flags whatever the caller needs to report the result without reloading the input
+	// \return true if the record was written else false
+	bool result_cache_store(ResultCache_t *cache, const ResultCacheKey_t *key, const ScheduleResult_t *result,
+							uint32_t input_flags);
+
+	// Hashes a file's content with a fast non-cryptographic 64-bit hash
+	// \param path the file
+	// \param hash destination for the hash
+	// \param size destination for the file size
+	// \return true if the whole file was read else false
+	bool result_cache_hash_file(const char *path, uint64_t *hash, uint64_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
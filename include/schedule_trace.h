@@ -0,0 +1,125 @@
+#ifndef SCHEDULE_TRACE_H
+#define SCHEDULE_TRACE_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct schedule_trace ScheduleTrace_t;
+typedef struct schedule_trace_reader ScheduleTraceReader_t;
+
+/*
+	Trace stream notes!
+
+	A trace is a binary stream of what a scheduler actually did, written as the schedule runs.
+	Nothing is kept in memory beyond a write buffer and the slice currently being extended,
+	so tracing a run costs a few bytes per context switch, not per tick.
+
+	Layout (little-endian):
+		uint32_t SCHEDULE_TRACE_MAGIC, uint32_t SCHEDULE_TRACE_VERSION
+		then a sequence of records, each a one byte tag followed by LEB128 varints:
+		SLICE: pid, cpu, gap (start - end of the previous slice on that cpu), length
+		JOB:   pid, arrival, wait (first dispatch - arrival), run (completion - first dispatch), preemptions
+
+	CPUs run side by side, so slices are delta encoded per CPU and only the slices of one CPU
+	are in time order. Consecutive slices of the same pid on the same CPU with no gap between
+	them are merged (run-length encoded), so a policy that steps one tick at a time still
+	produces one slice per dispatch.
+	A JOB record is written when the PCB completes, after its last slice.
+	Version 1 had no cpu field and could only describe a single CPU.
+*/
+
+#define SCHEDULE_TRACE_MAGIC 0x54424350u // "PCBT"
+#define SCHEDULE_TRACE_VERSION 2u
+
+// CPU ids a trace can hold, readers reject anything larger as malformed
+#define SCHEDULE_TRACE_MAX_CPUS 4096u
+
+typedef enum
+{
+	SCHEDULE_TRACE_SLICE = 0x01,
+	SCHEDULE_TRACE_JOB = 0x02
+}
+ScheduleTraceRecordType_t;
+
+typedef struct
+{
+	ScheduleTraceRecordType_t type;
+	uint32_t pid;
+	uint32_t cpu;				// SLICE: CPU the pid ran on
+	uint64_t start;				// SLICE: time the pid was put on the CPU
+	uint64_t length;			// SLICE: ticks it ran for
+	uint64_t arrival;			// JOB: arrival of the PCB
+	uint64_t first_dispatch;	// JOB: first time it ran
+	uint64_t completion;		// JOB: time its burst finished
+	uint64_t preemptions;		// JOB: times it was taken off the CPU before finishing
+}
+ScheduleTraceRecord_t;
+
+///
+/// Creates (or truncates) a trace file and writes the stream header
+/// \param output_file path of the trace file
+/// \return new trace sink, NULL on error
+///
+ScheduleTrace_t *schedule_trace_open(const char *output_file);
+
+///
+/// Flushes the pending slice and write buffer, then closes the sink
+/// \param trace the trace sink (NULL is fine)
+/// \return true if every record made it to the file, false if any write failed
+///
+bool schedule_trace_close(ScheduleTrace_t *trace);
+
+///
+/// Records that pid ran on cpu for length ticks starting at start
+/// Extends the CPU's pending slice when it directly continues it
+/// \param trace the trace sink (NULL disables, so schedulers can call unconditionally)
+/// \param cpu the CPU it ran on, below SCHEDULE_TRACE_MAX_CPUS
+/// \param pid the PCB that ran
+/// \param start first tick of the slice, must not precede the end of the CPU's previous slice
+/// \param length number of ticks
+///
+void schedule_trace_slice(ScheduleTrace_t *trace, const uint32_t cpu, const uint32_t pid, const uint64_t start,
+						  const uint64_t length);
+
+///
+/// Records the lifetime of a completed PCB
+/// \param trace the trace sink (NULL disables)
+/// \param pid the PCB that completed
+/// \param arrival arrival time of the PCB
+/// \param first_dispatch first time the PCB was on the CPU
+/// \param completion time the burst finished
+/// \param preemptions times the PCB was taken off the CPU with burst remaining
+///
+void schedule_trace_job(ScheduleTrace_t *trace, const uint32_t pid, const uint64_t arrival,
+						const uint64_t first_dispatch, const uint64_t completion, const uint64_t preemptions);
+
+///
+/// Opens a trace file for reading and validates the header
+/// \param input_file path of the trace file
+/// \return new reader, NULL on error
+///
+ScheduleTraceReader_t *schedule_trace_reader_open(const char *input_file);
+
+///
+/// Decodes the next record, SLICE starts are returned as absolute times
+/// \param reader the trace reader
+/// \param record destination for the decoded record
+/// \return true if a record was decoded, false at end of stream or on a malformed record
+///
+bool schedule_trace_reader_next(ScheduleTraceReader_t *reader, ScheduleTraceRecord_t *record);
+
+///
+/// Closes the reader
+/// \param reader the trace reader (NULL is fine)
+///
+void schedule_trace_reader_close(ScheduleTraceReader_t *reader);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
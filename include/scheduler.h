@@ -0,0 +1,141 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+	// Stateful, event driven simulator for feeding PCBs as they show up instead of as one complete dyn_array.
+	//
+	// Jobs are submitted with sched_submit, time moves forward with sched_advance_to, and the running
+	// totals can be read at any point with sched_snapshot_metrics. The simulator jumps from event to
+	// event (arrival, completion, end of a time slice) and consumes bursts in whole chunks, scaled by
+	// the CPU speed, so the work per call is proportional to the events it processes (times the CPU count),
+	// never to ticks or to past history.
+	// Slots of completed PCBs are reused, so memory follows the number of live PCBs.
+	//
+	// Semantics shared by every policy run here:
+	//  - the ready queue is ordered by the policy key, ties go to the earlier arrival, then the earlier submission
+	//  - Round Robin keeps a FIFO queue, a PCB arriving at the same tick a slice expires queues ahead of it
+	//  - SRT preempts on arrival only when the new PCB has strictly less remaining time
+	//  - MLFQ preempts on arrival when the running PCB sits in a lower level, its next slice starts afresh
+	//  - CFS preempts on arrival when the running PCB's vruntime leads by more than the minimum granularity
+	//  - preemptive EDF preempts on arrival only when the new PCB has a strictly earlier deadline
+	//  - preemptive Priority preempts once a waiting PCB's aged priority is strictly better than the running one's
+	//  - waiting time is first dispatch - arrival, turnaround is completion - arrival. SRT's waiting time also
+	//    adds turnaround - burst, the time off the CPU, as shortest_remaining_time_first always reported it
+	//  - with several CPUs every CPU takes from the one ready queue; placement picks the idle CPU a PCB
+	//    goes to, and the running PCB an arrival displaces among those the policy would let it preempt.
+	//    A CPU consumes speed / SCHEDULE_SPEED_NOMINAL ticks of burst per tick, bursts still end on whole ticks
+	//  - switching a CPU to a different PCB costs switch_cost plus the cache warmup penalty, during
+	//    which no burst runs and nothing preempts; slices start counting once the switch is done
+	//  - a PCB with next_bursts blocks after each CPU burst for the next IO burst; the single IO device
+	//    serves blocked PCBs first come first served, then the PCB is ready again with its next CPU burst
+	//  - with a ready_capacity an arrival finding the queue full is rejected, delayed or sheds the lowest
+	//    priority waiting PCB; rejected and dropped PCBs never complete and are left out of the averages
+	typedef struct scheduler Scheduler_t;
+
+	typedef struct
+	{
+		uint64_t clock;					// current simulation time
+		uint64_t submitted;				// PCBs accepted by sched_submit
+		uint64_t completed;				// PCBs whose burst has finished
+		uint64_t ready;					// PCBs waiting in the ready queue (the running one excluded)
+		uint64_t pending;				// PCBs submitted with an arrival still in the future
+		uint64_t blocked;				// PCBs waiting for or using the IO device
+		uint64_t busy_time;				// ticks the CPUs spent running PCBs, summed over the CPUs
+		uint64_t io_busy_time;			// ticks the IO device spent on completed IO bursts
+		uint64_t migrations;			// dispatches of a PCB to another CPU than the one it last ran on
+		uint64_t total_waiting_time;	// summed over the completed PCBs
+		uint64_t total_turnaround_time;	// summed over the completed PCBs
+		ScheduleResult_t result;		// averages and deadline misses over the completed PCBs,
+										// total_run_time is the clock
+	}
+	ScheduleMetrics_t;
+
+	// Creates a simulator at time 0
+	// \param config the algorithm and its parameters, the trace sink (if any) must outlive the simulator
+	// \return new simulator, NULL on error or if the config is invalid (e.g. Round Robin without a quantum)
+	Scheduler_t *sched_create(const ScheduleConfig_t *config);
+
+	// Frees the simulator and every PCB still in it
+	void sched_destroy(Scheduler_t *sched);
+
+	// Hands a PCB to the simulator, it is copied and becomes ready at its arrival time
+	// \param sched the simulator
+	// \param pcb the PCB, its arrival must not be earlier than the simulator clock,
+	// its next_bursts (if any) are not copied and must outlive the simulator
+	// \return true if the PCB was accepted else false
+	bool sched_submit(Scheduler_t *sched, const ProcessControlBlock_t *pcb);
+
+	// Simulates up to and including every event at time
+	// \param sched the simulator
+	// \param time the time to stop at, must not be earlier than the simulator clock
+	// \return true if function ran successful else false for an error
+	bool sched_advance_to(Scheduler_t *sched, uint64_t time);
+
+	// Simulates until every submitted PCB has completed (or was rejected or dropped)
+	// \param sched the simulator
+	// \return true if function ran successful else false for an error
+	bool sched_drain(Scheduler_t *sched);
+
+	// Like sched_drain, but stops once the clock reaches time if PCBs are still left
+	// \param sched the simulator
+	// \param time the time to stop at, must not be earlier than the simulator clock
+	// \return true if function ran successful else false for an error
+	bool sched_drain_until(Scheduler_t *sched, uint64_t time);
+
+	// Reads the running totals
+	// \param sched the simulator
+	// \param metrics destination for the totals \ref ScheduleMetrics_t
+	// \return true if function ran successful else false for an error
+	bool sched_snapshot_metrics(const Scheduler_t *sched, ScheduleMetrics_t *metrics);
+
+	// Writes everything needed to carry on later to a checkpoint file: the clock, the accumulators, every
+	// live PCB with its remaining work and IO bursts, the CPUs and the policy's ready queue. The file is
+	// written beside path and renamed over it once complete, so path always holds a whole checkpoint.
+	// Checkpoints are in native byte order, for resuming on the same machine with the same build.
+	// The write, fsync and rename all happen on the calling thread, which blocks until the checkpoint is on
+	// disk; a caller that can't stall should take it from a forked copy of the process, as analysis does.
+	// \param sched the simulator
+	// \param path the checkpoint file
+	// \param input_id identifies the input the PCBs come from, such as a hash of its file, 0 for none
+	// \param pcbs_submitted how many of its input PCBs the caller has submitted, handed back by sched_restore
+	// \return true if the checkpoint was written else false
+	bool sched_checkpoint(const Scheduler_t *sched, const char *path, uint64_t input_id, uint64_t pcbs_submitted);
+
+	// Rebuilds a simulator from a checkpoint, it carries on exactly as the checkpointed one would have.
+	// The IO bursts of the restored PCBs are owned by the simulator.
+	// \param config the config the checkpointed simulator was created with, only the trace sink may differ
+	// \param path the checkpoint file
+	// \param input_id the input_id given to sched_checkpoint
+	// \param pcbs_submitted destination for the PCB count given to sched_checkpoint
+	// \return the restored simulator, NULL on error or if the checkpoint was taken under another config or of
+	// another input
+	Scheduler_t *sched_restore(const ScheduleConfig_t *config, const char *path, uint64_t input_id,
+							   uint64_t *pcbs_submitted);
+
+	// Hashes the config fields that shape a schedule, everything but the trace sink. Equal configs hash
+	// equal, an unset cpu_count the same as 1.
+	// \param config the config
+	// \return the 64-bit FNV-1a hash, the one checkpoints are checked against
+	uint64_t sched_config_hash(const ScheduleConfig_t *config);
+
+	// Runs a whole ready_queue through a fresh simulator, the batch form of the calls above
+	// A ready_queue in arrival order is fed as the clock reaches each arrival, so the simulator only holds
+	// the PCBs in the system at a time, other orders are submitted up front.
+	// \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements, left untouched
+	// \param config the algorithm and its parameters
+	// \param result used for stat tracking \ref ScheduleResult_t
+	// \return true if function ran successful else false for an error
+	bool sched_run(const dyn_array_t *ready_queue, const ScheduleConfig_t *config, ScheduleResult_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
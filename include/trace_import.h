@@ -0,0 +1,51 @@
+#ifndef TRACE_IMPORT_H
+#define TRACE_IMPORT_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "processing_scheduling.h"
+
+	// Turns a Linux scheduler trace into a PCB file, to replay real workloads through the policies.
+	//
+	// The input is the text of `perf sched script` or of an ftrace dump (trace, trace_pipe) with the
+	// sched_switch and sched_wakeup events in their key=value form; every other line is ignored. Each time a
+	// task becomes runnable (a wakeup, or switched in without one) a PCB starts, arriving then. It collects
+	// the time the task runs, preemptions included (prev_state R), until the task is switched out in any
+	// other state, and then is written with that run time as its burst. A task's priority is its kernel prio
+	// less 100, so nice -20 to 19 become 0 to 39 as SCHEDULE_CFS expects, real time tasks 0.
+	// Runnable tasks left at the end of the trace are written with the time they ran up to its last event.
+	// The idle task (pid 0) is never a PCB.
+	//
+	// The text is read in large blocks and parsed in place, so nothing is allocated per line, only the
+	// task table grows with the number of tasks.
+
+	typedef struct
+	{
+		uint64_t lines;			// lines read
+		uint64_t events;		// sched_switch and sched_wakeup events used
+		uint64_t skipped;		// event lines that didn't parse or were too long
+		uint64_t tasks;			// distinct pids seen
+		uint64_t pcbs;			// PCBs written
+	}
+	TraceImportStats_t;
+
+	// Converts a trace to a PCB file
+	// PCBs are written in the order they end, arrivals are ticks since the first event.
+	// \param input the trace text, read to its end
+	// \param output_file the PCB file to create or truncate
+	// \param tick_ns trace nanoseconds per tick, bursts are rounded to the nearest tick but at least 1
+	// \param v1 write the v1 layout (pcb.bin), else v2
+	// \param stats destination for the counts, may be NULL
+	// \return true if the whole file was written else false for an error
+	bool trace_import(FILE *input, const char *output_file, uint64_t tick_ns, bool v1, TraceImportStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,65 @@
+#ifndef WHAT_IF_H
+#define WHAT_IF_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "processing_scheduling.h"
+
+	// Incremental what-if analysis for the non-preemptive FCFS and SJF schedules.
+	//
+	// A baseline workload is loaded once; single PCBs can then be edited, inserted or removed and the
+	// waiting/turnaround totals re-read without rerunning the whole schedule. The PCBs are kept in dispatch
+	// order in a treap whose subtrees carry burst prefix sums and the largest idle gap they contain, which
+	// is enough to recompute every completion time below a node from the completion time entering it.
+	// An edit costs O(log^2 n) expected, reading the result O(log n).
+	//
+	// Results match sched_run over the live PCBs in id order (see scheduler.h for the tie-breaking).
+	// SJF is only a fixed order while every PCB shares one arrival time; while arrivals differ the
+	// SJF result is recomputed in full by the simulator on the next read, then cached until the next edit.
+	// Deadline misses are only reported by that full rerun, the incremental results leave them at 0.
+	// PCBs with IO bursts are not supported, and switches are free (switch_overhead is always 0).
+	typedef struct what_if WhatIf_t;
+
+	// Loads a baseline
+	// \param baseline a dyn_array of type ProcessControlBlock_t, PCB i gets id i
+	// \param algorithm SCHEDULE_FCFS or SCHEDULE_SJF
+	// \return new what-if state, NULL on error, for any other algorithm or if a PCB has IO bursts
+	WhatIf_t *what_if_create(const dyn_array_t *baseline, ScheduleAlgorithm_t algorithm);
+
+	void what_if_destroy(WhatIf_t *what_if);
+
+	// Replaces the burst, arrival and priority of a PCB
+	// \param what_if the what-if state
+	// \param id the PCB to change
+	// \param pcb its new values
+	// \return true if the id is live and the edit was applied else false
+	bool what_if_update(WhatIf_t *what_if, size_t id, const ProcessControlBlock_t *pcb);
+
+	// Adds a PCB
+	// \param what_if the what-if state
+	// \param pcb the new PCB
+	// \param id destination for its id, ids are never reused
+	// \return true if the PCB was added else false
+	bool what_if_insert(WhatIf_t *what_if, const ProcessControlBlock_t *pcb, size_t *id);
+
+	// Removes a PCB
+	// \param what_if the what-if state
+	// \param id the PCB to remove
+	// \return true if the id was live else false
+	bool what_if_remove(WhatIf_t *what_if, size_t id);
+
+	// Reads the schedule totals for the current set of PCBs
+	// \param what_if the what-if state
+	// \param result used for stat tracking \ref ScheduleResult_t
+	// \return true if function ran successful else false for an error (including no live PCBs)
+	bool what_if_result(WhatIf_t *what_if, ScheduleResult_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,98 +1,2599 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "dyn_array.h"
 #include "processing_scheduling.h"
+#include "monte_carlo.h"
+#include "op_counters.h"
+#include "pcb_shards.h"
+#include "pcb_stream.h"
+#include "profile.h"
+#include "result_cache.h"
+#include "trace_import.h"
+#include "scheduler.h"
 
-#define FCFS "FCFS"
-#define P "P"
-#define RR "RR"
-#define SJF "SJF"
-#define SRT "SRT"
+#define TRACE_FLAG "--trace"
+#define LEVELS_FLAG "--levels"
+#define QUANTA_FLAG "--quanta"
+#define BOOST_FLAG "--boost"
+#define GRANULARITY_FLAG "--granularity"
+#define SWITCH_COST_FLAG "--switch-cost"
+#define WARMUP_FLAG "--warmup"
+#define WARMUP_DECAY_FLAG "--warmup-decay"
+#define CPUS_FLAG "--cpus"
+#define PLACEMENT_FLAG "--placement"
+#define CAPACITY_FLAG "--queue-capacity"
+#define ADMISSION_FLAG "--admission"
+#define CHECKPOINT_FLAG "--checkpoint"
+#define CHECKPOINT_EVERY_FLAG "--checkpoint-every"
+#define RESUME_FLAG "--resume"
+#define SWEEP_FLAG "--sweep"
+#define SEED_FLAG "--seed"
+#define THREADS_FLAG "--threads"
+#define SWEEP_PCBS_FLAG "--sweep-pcbs"
+#define MEAN_GAP_FLAG "--mean-gap"
+#define MEAN_BURST_FLAG "--mean-burst"
+#define IO_BURSTS_FLAG "--io-bursts"
+#define SLACK_FLAG "--deadline-slack"
+#define FORMAT_FLAG "--format"
+#define BATCH_FLAG "--batch"
+#define SERVE_FLAG "--serve"
+#define CACHE_FLAG "--cache"
+#define RESULT_CACHE_FLAG "--result-cache"
+#define PROFILE_FLAG "--profile"
+#define EXTERNAL_FLAG "--external"
+#define TEMP_DIR_FLAG "--temp-dir"
+#define SHARDS_FLAG "--shards"
+#define IMPORT_FLAG "--import"
+#define TICK_FLAG "--tick-ns"
+#define V1_FLAG "--v1"
+
+#define MAX_CPUS 64
+
+#define DEFAULT_MLFQ_LEVELS 3
+
+// Ticks of simulated time between checkpoints
+#define DEFAULT_CHECKPOINT_INTERVAL 1000000
+
+// Algorithms a sweep or a batch can compare
+#define MAX_LISTED_ALGORITHMS 16
+
+// Workloads a server keeps loaded, and its limits per request line and on clients waiting to connect
+#define DEFAULT_SERVE_CACHE 64
+#define SERVE_MAX_REQUEST 4096
+#define SERVE_BACKLOG 64
+
+// Synthetic workloads of a sweep: about 80% load, priorities spanning every CFS nice value
+#define DEFAULT_SWEEP_PCBS 1000
+#define DEFAULT_SWEEP_MEAN_GAP 25.0
+#define DEFAULT_SWEEP_MEAN_BURST 20.0
+#define DEFAULT_SWEEP_PRIORITIES 40
+
+// Linux's 6ms / 0.75ms ratio
+#define DEFAULT_CFS_TARGET_LATENCY 24
+#define DEFAULT_CFS_MIN_GRANULARITY 3
+
+static void print_usage(const char *program)
+{
+	printf("Usage: %s <pcb file> <schedule algorithm> [quantum | aging interval | target latency]"
+		   " [" TRACE_FLAG " <trace file>]\n"
+		   "       MLFQ options: [" LEVELS_FLAG " <count>] [" QUANTA_FLAG " <q0,q1,...>] [" BOOST_FLAG " <ticks>]\n"
+		   "       CFS options: [" GRANULARITY_FLAG " <ticks>]\n"
+		   "       Switch costs: [" SWITCH_COST_FLAG " <ticks>] [" WARMUP_FLAG " <ticks>] [" WARMUP_DECAY_FLAG
+		   " <ticks>]\n"
+		   "       CPUs: [" CPUS_FLAG " <speed,speed,...>] [" PLACEMENT_FLAG " fastest|energy|affinity]\n"
+		   "       Admission: [" CAPACITY_FLAG " <count>] [" ADMISSION_FLAG " reject|delay|drop]\n"
+		   "       Checkpoints: [" CHECKPOINT_FLAG " <file>] [" CHECKPOINT_EVERY_FLAG " <ticks>] [" RESUME_FLAG
+		   " <file>]\n"
+		   "       %s " SWEEP_FLAG " <workloads> <algorithm[:quantum | aging interval | target latency],...>"
+		   " [" SEED_FLAG " <seed>] [" THREADS_FLAG " <count>]\n"
+		   "       Sweep workloads: [" SWEEP_PCBS_FLAG " <count>] [" MEAN_GAP_FLAG " <ticks>] [" MEAN_BURST_FLAG
+		   " <ticks>] [" IO_BURSTS_FLAG " <max>] [" SLACK_FLAG " <factor>]\n"
+		   "       %s [options] " BATCH_FLAG " <algorithm[:quantum | aging interval | target latency],...>"
+		   " <pcb file | directory>...\n"
+		   "       Batches: [" THREADS_FLAG " <count>], options go before " BATCH_FLAG "\n"
+		   "       %s [options] " SERVE_FLAG " <socket> [" THREADS_FLAG " <count>] [" CACHE_FLAG " <workloads>]\n"
+		   "       Requests, one per line: <algorithm[:quantum | aging interval | target latency]> <pcb file>\n"
+		   "       Output: [" FORMAT_FLAG " text|json|csv], servers reply json or csv\n"
+		   "       Results: [" RESULT_CACHE_FLAG " <file>] reuses results of runs, batches and servers\n"
+		   "       Profiling: [" PROFILE_FLAG "] reports phase times, peak RSS, hardware and operation counts of a run"
+		   " on stderr\n"
+		   "       Large files: [" EXTERNAL_FLAG " <pcbs per run>] [" TEMP_DIR_FLAG " <dir>] sorts the file on disk"
+		   " and streams it into the simulator\n"
+		   "       Shards: [" SHARDS_FLAG "] [" THREADS_FLAG " <count>] runs the files of the <pcb file> directory"
+		   " merged by arrival\n"
+		   "       %s " IMPORT_FLAG " <perf sched script | ftrace text | -> <pcb file> [" TICK_FLAG " <ns>] [" V1_FLAG
+		   "]\n",
+		   program, program, program, program, program);
+}
+
+typedef enum
+{
+	FORMAT_TEXT,		// the report for people
+	FORMAT_JSON,		// one object per line
+	FORMAT_CSV			// a header, then one row per result
+} output_format_t;
+
+// Only workloads with a deadline column report deadline misses
+static bool has_deadlines(const dyn_array_t *pcbs)
+{
+	for (size_t i = 0; i < dyn_array_size(pcbs); ++i)
+	{
+		if (((const ProcessControlBlock_t *)dyn_array_at(pcbs, i))->deadline != PCB_NO_DEADLINE)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Only workloads with IO bursts report device utilization and throughput
+static bool has_io(const dyn_array_t *pcbs)
+{
+	for (size_t i = 0; i < dyn_array_size(pcbs); ++i)
+	{
+		if (((const ProcessControlBlock_t *)dyn_array_at(pcbs, i))->next_burst_count > 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// What the text report needs to know about a workload, stored with cached results so a hit can be
+// reported without loading the PCB file
+#define INPUT_DEADLINES 0x1u
+#define INPUT_IO 0x2u
+
+static uint32_t input_flags(const dyn_array_t *pcbs)
+{
+	return (has_deadlines(pcbs) ? INPUT_DEADLINES : 0) | (has_io(pcbs) ? INPUT_IO : 0);
+}
+
+// Parses a comma separated list of time slices
+// \return the number of slices, 0 if the list is malformed or too long
+static size_t parse_quanta(const char *list, uint64_t *quanta, size_t capacity)
+{
+	size_t count = 0;
+	const char *cursor = list;
+	while (count < capacity)
+	{
+		char *end;
+		quanta[count++] = strtoull(cursor, &end, 10);
+		if (end == cursor || quanta[count - 1] == 0)
+		{
+			return 0;
+		}
+		if (*end == '\0')
+		{
+			return count;
+		}
+		if (*end != ',')
+		{
+			return 0;
+		}
+		cursor = end + 1;
+	}
+	return 0;
+}
+
+// Parses a comma separated list of CPU speed factors (1 is nominal, 0.5 half speed)
+// \return the number of CPUs, 0 if the list is malformed or too long
+static size_t parse_speeds(const char *list, uint32_t *speeds, size_t capacity)
+{
+	size_t count = 0;
+	const char *cursor = list;
+	while (count < capacity)
+	{
+		char *end;
+		const double factor = strtod(cursor, &end);
+		if (end == cursor || !(factor > 0.0) || factor * SCHEDULE_SPEED_NOMINAL > UINT32_MAX)
+		{
+			return 0;
+		}
+		speeds[count] = (uint32_t)(factor * SCHEDULE_SPEED_NOMINAL + 0.5);
+		if (speeds[count++] == 0)
+		{
+			return 0;
+		}
+		if (*end == '\0')
+		{
+			return count;
+		}
+		if (*end != ',')
+		{
+			return 0;
+		}
+		cursor = end + 1;
+	}
+	return 0;
+}
+
+// The report for one file and algorithm
+static void print_text_result(const char *algorithm, const uint32_t input, const ScheduleConfig_t *config,
+							  const ScheduleResult_t *result)
+{
+	printf("Algorithm: %s\n", algorithm);
+	printf("Average Waiting Time: %.2f\n", result->average_waiting_time);
+	printf("Average Turnaround Time: %.2f\n", result->average_turnaround_time);
+	printf("Total Clock Time: %" PRIu64 "\n", result->total_run_time);
+	if (input & INPUT_DEADLINES)
+	{
+		printf("Missed Deadlines: %" PRIu64 "\n", result->missed_deadlines);
+		printf("Total Lateness: %" PRIu64 "\n", result->total_lateness);
+	}
+	if (config->switch_cost > 0 || config->warmup_cost > 0)
+	{
+		printf("Context Switches: %" PRIu64 "\n", result->context_switches);
+		printf("Switch Overhead: %" PRIu64 "\n", result->switch_overhead);
+	}
+	if ((input & INPUT_IO) || config->cpu_count > 1)
+	{
+		printf("CPU Utilization: %.2f\n", result->cpu_utilization);
+		printf("IO Utilization: %.2f\n", result->io_utilization);
+		printf("Throughput: %.4f\n", result->throughput);
+	}
+	if (config->ready_capacity > 0)
+	{
+		printf("Rejected: %" PRIu64 "\n", result->rejected);
+		printf("Dropped: %" PRIu64 "\n", result->dropped);
+		printf("Time At Capacity: %" PRIu64 "\n", result->time_at_capacity);
+	}
+}
+
+// Columns of the machine readable formats, in order
+static const char *const result_columns[] = {
+	"average_waiting_time", "average_turnaround_time", "total_run_time", "missed_deadlines", "total_lateness",
+	"cpu_utilization", "io_utilization", "throughput", "context_switches", "switch_overhead", "rejected", "dropped",
+	"time_at_capacity"
+};
+
+#define RESULT_COLUMNS (sizeof(result_columns) / sizeof(result_columns[0]))
+
+// Formats the result_columns of result, doubles with enough digits to read back the same value
+static void format_result_values(const ScheduleResult_t *result, char values[RESULT_COLUMNS][32])
+{
+	snprintf(values[0], 32, "%.17g", result->average_waiting_time);
+	snprintf(values[1], 32, "%.17g", result->average_turnaround_time);
+	snprintf(values[2], 32, "%" PRIu64, result->total_run_time);
+	snprintf(values[3], 32, "%" PRIu64, result->missed_deadlines);
+	snprintf(values[4], 32, "%" PRIu64, result->total_lateness);
+	snprintf(values[5], 32, "%.17g", result->cpu_utilization);
+	snprintf(values[6], 32, "%.17g", result->io_utilization);
+	snprintf(values[7], 32, "%.17g", result->throughput);
+	snprintf(values[8], 32, "%" PRIu64, result->context_switches);
+	snprintf(values[9], 32, "%" PRIu64, result->switch_overhead);
+	snprintf(values[10], 32, "%" PRIu64, result->rejected);
+	snprintf(values[11], 32, "%" PRIu64, result->dropped);
+	snprintf(values[12], 32, "%" PRIu64, result->time_at_capacity);
+}
+
+// Growable string the machine readable results are formatted into, for stdout or a socket
+typedef struct
+{
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool failed;					// out of memory, data holds what fit
+} text_t;
+
+static void text_append(text_t *text, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	const int needed = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+	if (needed < 0 || text->failed)
+	{
+		text->failed = true;
+		return;
+	}
+
+	if (text->length + (size_t)needed + 1 > text->capacity)
+	{
+		size_t grown = text->capacity > 0 ? text->capacity : 256;
+		while (grown < text->length + (size_t)needed + 1)
+		{
+			grown *= 2;
+		}
+		char *larger = (char *)realloc(text->data, grown);
+		if (!larger)
+		{
+			text->failed = true;
+			return;
+		}
+		text->data = larger;
+		text->capacity = grown;
+	}
+
+	va_start(args, format);
+	vsnprintf(text->data + text->length, text->capacity - text->length, format, args);
+	va_end(args);
+	text->length += (size_t)needed;
+}
+
+static void append_json_string(text_t *text, const char *value)
+{
+	text_append(text, "\"");
+	for (const unsigned char *c = (const unsigned char *)value; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			text_append(text, "\\%c", *c);
+		}
+		else if (*c < 0x20)
+		{
+			text_append(text, "\\u%04x", *c);
+		}
+		else
+		{
+			text_append(text, "%c", *c);
+		}
+	}
+	text_append(text, "\"");
+}
+
+// Quotes the field only when it holds a separator, a quote or a line break
+static void append_csv_field(text_t *text, const char *value)
+{
+	if (!strpbrk(value, ",\"\r\n"))
+	{
+		text_append(text, "%s", value);
+		return;
+	}
+	text_append(text, "\"");
+	for (const char *c = value; *c; ++c)
+	{
+		if (*c == '"')
+		{
+			text_append(text, "\"");
+		}
+		text_append(text, "%c", *c);
+	}
+	text_append(text, "\"");
+}
+
+static void print_csv_header(void)
+{
+	printf("file,algorithm");
+	for (size_t i = 0; i < RESULT_COLUMNS; ++i)
+	{
+		printf(",%s", result_columns[i]);
+	}
+	putchar('\n');
+}
+
+// Formats a result as a JSON object or a CSV row, with every column and a line break
+static void append_result_line(text_t *text, const output_format_t format, const char *file, const char *algorithm,
+							   const ScheduleResult_t *result)
+{
+	char values[RESULT_COLUMNS][32];
+	format_result_values(result, values);
+	if (format == FORMAT_JSON)
+	{
+		text_append(text, "{\"file\":");
+		append_json_string(text, file);
+		text_append(text, ",\"algorithm\":");
+		append_json_string(text, algorithm);
+		for (size_t i = 0; i < RESULT_COLUMNS; ++i)
+		{
+			text_append(text, ",\"%s\":%s", result_columns[i], values[i]);
+		}
+		text_append(text, "}\n");
+	}
+	else
+	{
+		append_csv_field(text, file);
+		text_append(text, ",");
+		append_csv_field(text, algorithm);
+		for (size_t i = 0; i < RESULT_COLUMNS; ++i)
+		{
+			text_append(text, ",%s", values[i]);
+		}
+		text_append(text, "\n");
+	}
+}
+
+// Prints one result: the text report, a JSON object on a line of its own, or a CSV row.
+// The machine readable formats always have every column, the text only what applies to the run.
+static void print_result(const output_format_t format, const char *file, const char *algorithm,
+						 const uint32_t input, const ScheduleConfig_t *config, const ScheduleResult_t *result)
+{
+	if (format == FORMAT_TEXT)
+	{
+		print_text_result(algorithm, input, config, result);
+		return;
+	}
+
+	text_t line = {NULL, 0, 0, false};
+	append_result_line(&line, format, file, algorithm, result);
+	if (line.data)
+	{
+		fputs(line.data, stdout);
+	}
+	free(line.data);
+}
+
+// PCB index with its arrival, for feeding the simulator in arrival order
+typedef struct
+{
+	uint64_t arrival;
+	size_t index;
+} arrival_order_t;
+
+static int compare_arrival_order(const void *a, const void *b)
+{
+	const arrival_order_t *x = (const arrival_order_t *)a;
+	const arrival_order_t *y = (const arrival_order_t *)b;
+	if (x->arrival != y->arrival)
+	{
+		return x->arrival < y->arrival ? -1 : 1;
+	}
+	return x->index < y->index ? -1 : x->index > y->index;
+}
+
+// Reaps the last checkpoint writer, if one is out
+// \param wait whether to block until it is done
+// \return false while it is still writing (only when not waiting) or if it failed, true otherwise
+static bool reap_writer(pid_t *writer, const char *path, const bool wait)
+{
+	if (*writer <= 0)
+	{
+		return true;
+	}
+	int status;
+	const pid_t reaped = waitpid(*writer, &status, wait ? 0 : WNOHANG);
+	if (reaped == 0)
+	{
+		return false;
+	}
+	*writer = 0;
+	if (reaped < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+	{
+		fprintf(stderr, "Error: Failed to write checkpoint '%s'\n", path);
+		return false;
+	}
+	return true;
+}
+
+// Where a run checkpoints to and resumes from
+typedef struct
+{
+	const char *file;		// checkpoint to write, NULL for none
+	uint64_t interval;		// ticks of simulated time between checkpoints
+	const char *resume;		// checkpoint to carry on from, NULL to start afresh
+	uint64_t input_id;		// hash_checkpoint_input of the PCBs, a checkpoint only resumes the input it was taken of
+} checkpoint_plan_t;
+
+// Writes the checkpoint from a forked copy of the process, whose copy-on-write memory is a consistent
+// snapshot, so the simulation carries on while it is written. Writes in place if fork fails.
+// A checkpoint due while the last one is still being written is skipped, there is a newer one soon.
+static void checkpoint_in_background(const Scheduler_t *sched, const checkpoint_plan_t *plan, const uint64_t fed,
+									 pid_t *writer)
+{
+	reap_writer(writer, plan->file, false);
+	if (*writer > 0)
+	{
+		return;
+	}
+
+	const pid_t pid = fork();
+	if (pid == 0)
+	{
+		_exit(sched_checkpoint(sched, plan->file, plan->input_id, fed) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (pid > 0)
+	{
+		*writer = pid;
+	}
+	else if (!sched_checkpoint(sched, plan->file, plan->input_id, fed))
+	{
+		fprintf(stderr, "Error: Failed to write checkpoint '%s'\n", plan->file);
+	}
+}
+
+// The PCBs of a checkpointed run in arrival order, ties in file order: the loaded file sorted in memory, or
+// a stream sorted on disk, which comes back in the same order
+typedef struct
+{
+	const ProcessControlBlock_t *pcbs;	// the loaded PCBs, unused when streaming
+	const arrival_order_t *order;		// pcbs by arrival
+	size_t count;
+	size_t next;
+	PcbStream_t *stream;				// NULL for the loaded PCBs
+} arrival_feed_t;
+
+// Copies the next PCB in arrival order to pcb
+// \return false once they are used up or if the stream failed
+static bool feed_next(arrival_feed_t *feed, ProcessControlBlock_t *pcb)
+{
+	if (feed->stream)
+	{
+		return pcb_stream_next(feed->stream, pcb);
+	}
+	if (feed->next == feed->count)
+	{
+		return false;
+	}
+	*pcb = feed->pcbs[feed->order[feed->next++].index];
+	return true;
+}
+
+// Feeds the PCBs to the simulator in arrival order, simulating up to each arrival before submitting it, and
+// checkpoints every interval ticks of simulated time. The PCB count kept in a checkpoint is the number of PCBs
+// fed so far in that order, a resumed run skips that many of them, so a stream resumes by sorting the file
+// again and reading past them rather than by recording where its merge was.
+static bool run_checkpointed(arrival_feed_t *feed, const ScheduleConfig_t *config, const checkpoint_plan_t *plan,
+							 ScheduleResult_t *result)
+{
+	uint64_t fed = 0;
+	Scheduler_t *sched = plan->resume ? sched_restore(config, plan->resume, plan->input_id, &fed) :
+		sched_create(config);
+	ScheduleMetrics_t metrics;
+	bool ok = sched && sched_snapshot_metrics(sched, &metrics);
+	ProcessControlBlock_t pcb;
+	for (uint64_t skipped = 0; ok && skipped < fed; ++skipped)
+	{
+		ok = feed_next(feed, &pcb);
+	}
+	if (!ok && plan->resume)
+	{
+		fprintf(stderr, "Error: Failed to resume from checkpoint '%s'\n", plan->resume);
+	}
+
+	bool more = ok && feed_next(feed, &pcb);
+	uint64_t next_checkpoint = ok ? metrics.clock : 0;
+	next_checkpoint = UINT64_MAX - next_checkpoint < plan->interval ? UINT64_MAX : next_checkpoint + plan->interval;
+	pid_t writer = 0;
+	while (ok)
+	{
+		uint64_t until = UINT64_MAX;
+		if (more)
+		{
+			until = pcb.arrival > 0 ? pcb.arrival - 1 : 0;
+		}
+
+		if (until < next_checkpoint)
+		{
+			// Everything before the arrival is simulated before it is submitted
+			ok = (until <= metrics.clock || sched_advance_to(sched, until)) && sched_submit(sched, &pcb);
+			++fed;
+			more = ok && feed_next(feed, &pcb);
+		}
+		else
+		{
+			ok = (more ? sched_advance_to(sched, next_checkpoint) : sched_drain_until(sched, next_checkpoint)) &&
+				sched_snapshot_metrics(sched, &metrics);
+			const uint64_t settled = metrics.completed + metrics.result.rejected + metrics.result.dropped;
+			if (!ok || (!more && settled == metrics.submitted))
+			{
+				break;
+			}
+			if (plan->file)
+			{
+				checkpoint_in_background(sched, plan, fed, &writer);
+			}
+			next_checkpoint = UINT64_MAX - next_checkpoint < plan->interval ? UINT64_MAX :
+				next_checkpoint + plan->interval;
+		}
+		ok = ok && sched_snapshot_metrics(sched, &metrics);
+	}
+
+	reap_writer(&writer, plan->file, true);
+	ok = ok && !(feed->stream && pcb_stream_failed(feed->stream));
+	if (ok)
+	{
+		*result = metrics.result;
+	}
+	sched_destroy(sched);
+	return ok;
+}
+
+// Runs the loaded PCBs checkpointed, sorted by arrival first
+static bool run_loaded_checkpointed(const dyn_array_t *pcbs, const ScheduleConfig_t *config,
+									const checkpoint_plan_t *plan, ScheduleResult_t *result)
+{
+	const size_t n = dyn_array_size(pcbs);
+	const ProcessControlBlock_t *const input = (const ProcessControlBlock_t *)dyn_array_export(pcbs);
+	dyn_array_t *sorted = dyn_array_create(n ? n : 1, sizeof(arrival_order_t), NULL);
+	bool ok = sorted != NULL;
+	for (size_t i = 0; ok && i < n; ++i)
+	{
+		const arrival_order_t entry = {input[i].arrival, i};
+		ok = dyn_array_push_back(sorted, &entry);
+	}
+	// Files in arrival order, the usual case, take the adaptive sort a single pass
+	ok = ok && (n == 0 || dyn_array_sort(sorted, compare_arrival_order));
+	if (ok)
+	{
+		arrival_feed_t feed = {input, (const arrival_order_t *)dyn_array_export(sorted), n, 0, NULL};
+		ok = run_checkpointed(&feed, config, plan, result);
+	}
+	dyn_array_destroy(sorted);
+	return ok;
+}
+
+// Flags tuning a single algorithm
+typedef struct
+{
+	const char *levels;
+	const char *quanta;
+	const char *boost;
+	const char *granularity;
+} algorithm_options_t;
+
+// Fills in the parameters of config->algorithm, reporting errors on stderr
+// \param parameter the optional quantum, aging interval or target latency argument
+// \param level_quanta storage for the MLFQ time slices, SCHEDULE_MLFQ_MAX_LEVELS long
+static bool configure_algorithm(ScheduleConfig_t *config, const char *parameter, const algorithm_options_t *options,
+								uint64_t *level_quanta)
+{
+	if (config->algorithm == SCHEDULE_RR)
+	{
+		if (!parameter)
+		{
+			fprintf(stderr, "Error: Round Robin requires a time quantum argument\n");
+			return false;
+		}
+		if (sscanf(parameter, "%zu", &config->quantum) != 1 || config->quantum == 0)
+		{
+			fprintf(stderr, "Error: Invalid time quantum '%s'\n", parameter);
+			return false;
+		}
+	}
+
+	// Aging is optional for preemptive priority, off by default
+	if (config->algorithm == SCHEDULE_PRIORITY_PREEMPTIVE && parameter &&
+			sscanf(parameter, "%" SCNu64, &config->aging_interval) != 1)
+	{
+		fprintf(stderr, "Error: Invalid aging interval '%s'\n", parameter);
+		return false;
+	}
+
+	// MLFQ takes its slices either from --quanta or by doubling the quantum at each level
+	if (config->algorithm == SCHEDULE_MLFQ)
+	{
+		config->levels = DEFAULT_MLFQ_LEVELS;
+		if (options->levels && (sscanf(options->levels, "%zu", &config->levels) != 1 || config->levels == 0 ||
+				config->levels > SCHEDULE_MLFQ_MAX_LEVELS))
+		{
+			fprintf(stderr, "Error: Invalid level count '%s'\n", options->levels);
+			return false;
+		}
+		if (options->boost && sscanf(options->boost, "%" SCNu64, &config->boost_interval) != 1)
+		{
+			fprintf(stderr, "Error: Invalid boost interval '%s'\n", options->boost);
+			return false;
+		}
+
+		if (options->quanta)
+		{
+			const size_t count = parse_quanta(options->quanta, level_quanta, SCHEDULE_MLFQ_MAX_LEVELS);
+			if (count == 0 || (options->levels && count != config->levels))
+			{
+				fprintf(stderr, "Error: Invalid time slices '%s'\n", options->quanta);
+				return false;
+			}
+			config->levels = count;
+			config->level_quanta = level_quanta;
+		}
+		else if (!parameter || sscanf(parameter, "%zu", &config->quantum) != 1 || config->quantum == 0)
+		{
+			fprintf(stderr, "Error: MLFQ requires a time quantum argument or " QUANTA_FLAG "\n");
+			return false;
+		}
+	}
+
+	if (config->algorithm == SCHEDULE_CFS)
+	{
+		config->target_latency = DEFAULT_CFS_TARGET_LATENCY;
+		config->min_granularity = DEFAULT_CFS_MIN_GRANULARITY;
+		if (parameter && (sscanf(parameter, "%" SCNu64, &config->target_latency) != 1 ||
+				config->target_latency == 0))
+		{
+			fprintf(stderr, "Error: Invalid target latency '%s'\n", parameter);
+			return false;
+		}
+		if (options->granularity && (sscanf(options->granularity, "%" SCNu64, &config->min_granularity) != 1 ||
+				config->min_granularity == 0))
+		{
+			fprintf(stderr, "Error: Invalid minimum granularity '%s'\n", options->granularity);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void print_estimate(const MonteCarloSummary_t *summary, const MonteCarloMetric_t metric, const int precision)
+{
+	printf("%s: %.*f +- %.*f\n", monte_carlo_metric_name(metric), precision, summary->metrics[metric].mean, precision,
+		   summary->metrics[metric].half_width);
+}
+
+// Algorithms of a sweep or a batch, each with the shared settings
+typedef struct
+{
+	char *entries;					// the list as given, the labels point into it
+	size_t count;
+	ScheduleConfig_t configs[MAX_LISTED_ALGORITHMS];
+	const char *labels[MAX_LISTED_ALGORITHMS];
+	uint64_t level_quanta[MAX_LISTED_ALGORITHMS][SCHEDULE_MLFQ_MAX_LEVELS];
+} algorithm_list_t;
+
+// Parses a comma separated list of algorithm[:parameter], each configured on top of base, reporting
+// errors on stderr. Free list->entries afterwards whatever the outcome.
+static bool parse_algorithm_list(const char *text, const ScheduleConfig_t *base, const algorithm_options_t *options,
+								 algorithm_list_t *list)
+{
+	const size_t length = strlen(text);
+	list->count = 0;
+	list->entries = (char *)malloc(length + 1);
+	if (!list->entries)
+	{
+		return false;
+	}
+	memcpy(list->entries, text, length + 1);
+
+	// Split by hand, strtok isn't safe with several server threads parsing requests
+	for (char *entry = list->entries, *next; entry; entry = next)
+	{
+		next = strchr(entry, ',');
+		if (next)
+		{
+			*next++ = '\0';
+		}
+		if (*entry == '\0')
+		{
+			continue;
+		}
+
+		if (list->count == MAX_LISTED_ALGORITHMS)
+		{
+			fprintf(stderr, "Error: At most %d algorithms can be listed\n", MAX_LISTED_ALGORITHMS);
+			return false;
+		}
+		char *parameter = strchr(entry, ':');
+		if (parameter)
+		{
+			*parameter++ = '\0';
+		}
+
+		ScheduleConfig_t *config = &list->configs[list->count];
+		*config = *base;
+		if (!schedule_algorithm_from_name(entry, &config->algorithm))
+		{
+			fprintf(stderr, "Error: Unknown scheduling algorithm '%s'\n", entry);
+			fprintf(stderr, "Valid options: FCFS, SJF, P, RR, SRT, PP, MLFQ, CFS, EDF, EDFP, HRRN\n");
+			return false;
+		}
+		if (!configure_algorithm(config, parameter, options, list->level_quanta[list->count]))
+		{
+			return false;
+		}
+		// Put the parameter back for the report
+		if (parameter)
+		{
+			parameter[-1] = ':';
+		}
+		list->labels[list->count++] = entry;
+	}
+
+	if (list->count == 0)
+	{
+		fprintf(stderr, "Error: No algorithm listed\n");
+		return false;
+	}
+	return true;
+}
+
+// Runs every algorithm of the list over the sweep's workloads and prints the mean and 95% confidence
+// interval of the metrics
+static int run_sweep(const char *text, const ScheduleConfig_t *base, const algorithm_options_t *options,
+					 MonteCarloSweep_t *sweep)
+{
+	algorithm_list_t list;
+	if (!parse_algorithm_list(text, base, options, &list))
+	{
+		free(list.entries);
+		return EXIT_FAILURE;
+	}
+
+	MonteCarloSummary_t summaries[MAX_LISTED_ALGORITHMS];
+	sweep->configs = list.configs;
+	sweep->config_count = list.count;
+	if (!monte_carlo_sweep(sweep, summaries))
+	{
+		fprintf(stderr, "Error: Sweep failed\n");
+		free(list.entries);
+		return EXIT_FAILURE;
+	}
+
+	printf("Workloads: %zu of %zu PCBs, seed %" PRIu64 "\n", sweep->workloads, sweep->workload.pcb_count, sweep->seed);
+	for (size_t i = 0; i < list.count; ++i)
+	{
+		printf("Algorithm: %s\n", list.labels[i]);
+		print_estimate(&summaries[i], MONTE_CARLO_WAITING_TIME, 2);
+		print_estimate(&summaries[i], MONTE_CARLO_TURNAROUND_TIME, 2);
+		print_estimate(&summaries[i], MONTE_CARLO_RUN_TIME, 2);
+		if (sweep->workload.deadline_slack > 0.0)
+		{
+			print_estimate(&summaries[i], MONTE_CARLO_MISSED_DEADLINES, 2);
+		}
+		if (base->switch_cost > 0 || base->warmup_cost > 0)
+		{
+			print_estimate(&summaries[i], MONTE_CARLO_CONTEXT_SWITCHES, 2);
+		}
+		if (sweep->workload.max_io_bursts > 0 || base->cpu_count > 1)
+		{
+			print_estimate(&summaries[i], MONTE_CARLO_CPU_UTILIZATION, 2);
+			print_estimate(&summaries[i], MONTE_CARLO_IO_UTILIZATION, 2);
+			print_estimate(&summaries[i], MONTE_CARLO_THROUGHPUT, 4);
+		}
+		if (base->ready_capacity > 0)
+		{
+			print_estimate(&summaries[i], MONTE_CARLO_REJECTED, 2);
+			print_estimate(&summaries[i], MONTE_CARLO_DROPPED, 2);
+		}
+	}
+
+	free(list.entries);
+	return EXIT_SUCCESS;
+}
+
+// Files of a batch, shared by its workers
+typedef struct
+{
+	const algorithm_list_t *list;
+	output_format_t format;
+	dyn_array_t *files;				// char *, owned
+	ResultCache_t *results;			// NULL to always schedule
+	atomic_size_t next;				// next file to take
+	atomic_bool failed;
+	pthread_mutex_t output;			// keeps the results of different files from interleaving
+} batch_state_t;
+
+static void free_path(void *element)
+{
+	free(*(char **)element);
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// \return directory/name, or a copy of name without a directory, NULL if out of memory
+static char *join_path(const char *directory, const char *name)
+{
+	const size_t prefix = directory ? strlen(directory) + 1 : 0;
+	const size_t length = strlen(name);
+	char *path = (char *)malloc(prefix + length + 1);
+	if (path && directory)
+	{
+		memcpy(path, directory, prefix - 1);
+		path[prefix - 1] = '/';
+	}
+	if (path)
+	{
+		memcpy(path + prefix, name, length + 1);
+	}
+	return path;
+}
+
+// Hands path over to files, freeing it if it can't be added
+static bool push_path(dyn_array_t *files, char *path)
+{
+	if (path && dyn_array_push_back(files, &path))
+	{
+		return true;
+	}
+	free(path);
+	return false;
+}
+
+// Adds the regular files of a directory, hidden ones excepted, or path itself when it isn't a directory
+static bool collect_files(const char *path, dyn_array_t *files)
+{
+	DIR *directory = opendir(path);
+	if (!directory)
+	{
+		return push_path(files, join_path(NULL, path));
+	}
+
+	bool ok = true;
+	for (struct dirent *entry = readdir(directory); ok && entry; entry = readdir(directory))
+	{
+		if (entry->d_name[0] == '.')
+		{
+			continue;
+		}
+		char *file = join_path(path, entry->d_name);
+		struct stat info;
+		if (file && stat(file, &info) == 0 && !S_ISREG(info.st_mode))
+		{
+			free(file);
+			continue;
+		}
+		ok = push_path(files, file);
+	}
+	closedir(directory);
+	return ok;
+}
+
+static void *batch_worker(void *arg)
+{
+	batch_state_t *state = (batch_state_t *)arg;
+	const algorithm_list_t *list = state->list;
+
+	for (size_t i = atomic_fetch_add(&state->next, 1); i < dyn_array_size(state->files);
+			i = atomic_fetch_add(&state->next, 1))
+	{
+		const char *file = *(char **)dyn_array_at(state->files, i);
+		// The file is only loaded once some algorithm misses the result cache
+		ResultCacheKey_t key = {0, 0, 0};
+		const bool hashed = state->results && result_cache_hash_file(file, &key.input_hash, &key.input_size);
+		PcbWorkload_t *workload = NULL;
+
+		for (size_t c = 0; c < list->count; ++c)
+		{
+			ScheduleResult_t result;
+			uint32_t input = 0;
+			key.config_hash = sched_config_hash(&list->configs[c]);
+			bool success = hashed && result_cache_lookup(state->results, &key, &result, &input);
+			if (!success)
+			{
+				if (!workload)
+				{
+					workload = load_pcb_workload(file);
+				}
+				if (!workload)
+				{
+					pthread_mutex_lock(&state->output);
+					fprintf(stderr, "Error: Failed to load process control blocks from '%s'\n", file);
+					pthread_mutex_unlock(&state->output);
+					atomic_store(&state->failed, true);
+					break;
+				}
+				input = input_flags(workload->pcbs);
+				success = schedule_processes(workload->pcbs, &list->configs[c], &result);
+				// A result that couldn't be cached is still reported
+				if (success && hashed)
+				{
+					result_cache_store(state->results, &key, &result, input);
+				}
+			}
+
+			pthread_mutex_lock(&state->output);
+			if (success)
+			{
+				if (state->format == FORMAT_TEXT)
+				{
+					printf("File: %s\n", file);
+				}
+				print_result(state->format, file, list->labels[c], input, &list->configs[c], &result);
+				fflush(stdout);
+			}
+			else
+			{
+				fprintf(stderr, "Error: Scheduling algorithm '%s' failed on '%s'\n", list->labels[c], file);
+				atomic_store(&state->failed, true);
+			}
+			pthread_mutex_unlock(&state->output);
+		}
+		pcb_workload_destroy(workload);
+	}
+	return NULL;
+}
+
+// Runs every algorithm of the list over every file, the files spread over a pool of worker threads.
+// Results are printed as they finish, so their order varies from run to run.
+static int run_batch(const char *text, const ScheduleConfig_t *base, const algorithm_options_t *options,
+					 const output_format_t format, const char *const *paths, const size_t path_count, size_t threads,
+					 ResultCache_t *results)
+{
+	algorithm_list_t list;
+	list.entries = NULL;
+	batch_state_t state;
+	state.list = &list;
+	state.format = format;
+	state.files = dyn_array_create(path_count, sizeof(char *), free_path);
+	state.results = results;
+	atomic_init(&state.next, 0);
+	atomic_init(&state.failed, false);
+
+	bool ok = state.files && parse_algorithm_list(text, base, options, &list);
+	for (size_t i = 0; ok && i < path_count; ++i)
+	{
+		ok = collect_files(paths[i], state.files);
+	}
+	if (!ok || dyn_array_empty(state.files))
+	{
+		if (ok)
+		{
+			fprintf(stderr, "Error: No PCB files to run\n");
+		}
+		free(list.entries);
+		dyn_array_destroy(state.files);
+		return EXIT_FAILURE;
+	}
+	dyn_array_sort(state.files, compare_paths);
+
+	if (threads == 0)
+	{
+		const long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 0 ? (size_t)online : 1;
+	}
+	if (threads > dyn_array_size(state.files))
+	{
+		threads = dyn_array_size(state.files);
+	}
+
+	if (format == FORMAT_CSV)
+	{
+		print_csv_header();
+	}
+	pthread_mutex_init(&state.output, NULL);
+	// The calling thread is one of the workers
+	pthread_t *workers = threads > 1 ? (pthread_t *)malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+	size_t started = 0;
+	while (workers && started < threads - 1 && pthread_create(&workers[started], NULL, batch_worker, &state) == 0)
+	{
+		++started;
+	}
+	batch_worker(&state);
+	for (size_t i = 0; i < started; ++i)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+	pthread_mutex_destroy(&state.output);
+
+	free(list.entries);
+	dyn_array_destroy(state.files);
+	return atomic_load(&state.failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// A loaded PCB file, shared by the requests running on it
+typedef struct
+{
+	char *path;
+	time_t modified;				// with size and inode tells a rewritten file from the one loaded
+	uint64_t size;
+	uint64_t inode;
+	PcbWorkload_t *workload;
+	uint32_t input;					// input_flags of the workload
+	ResultCacheKey_t key;			// the content part of its result cache keys, when hashed
+	size_t refs;					// requests using it
+	uint64_t last_used;
+	bool cached;					// false once evicted, the last request using it frees it
+} cached_workload_t;
+
+// Least recently used workloads of a server, entries are freed once evicted and no longer used
+typedef struct
+{
+	pthread_mutex_t lock;
+	cached_workload_t **entries;	// capacity slots, NULL when free
+	size_t capacity;
+	uint64_t clock;					// bumped on every use
+	bool hash;						// hash files as they are loaded, for the result cache
+} workload_cache_t;
+
+static void free_cached_workload(cached_workload_t *entry)
+{
+	pcb_workload_destroy(entry->workload);
+	free(entry->path);
+	free(entry);
+}
+
+// Drops a cache slot, the entry lives on until its last request releases it. Called with the lock held.
+static void evict(workload_cache_t *cache, const size_t slot)
+{
+	cached_workload_t *entry = cache->entries[slot];
+	cache->entries[slot] = NULL;
+	entry->cached = false;
+	if (entry->refs == 0)
+	{
+		free_cached_workload(entry);
+	}
+}
+
+// \return the cached entry for the file as it is now, evicting one of an older version. Called with the lock held.
+static cached_workload_t *cache_find(workload_cache_t *cache, const char *path, const struct stat *info)
+{
+	for (size_t i = 0; i < cache->capacity; ++i)
+	{
+		cached_workload_t *entry = cache->entries[i];
+		if (entry && strcmp(entry->path, path) == 0)
+		{
+			if (entry->modified == info->st_mtime && entry->size == (uint64_t)info->st_size &&
+					entry->inode == (uint64_t)info->st_ino)
+			{
+				entry->last_used = ++cache->clock;
+				++entry->refs;
+				return entry;
+			}
+			evict(cache, i);
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+// \return the workload of the file, loaded on a miss, NULL if it can't be loaded. Release it when done.
+static cached_workload_t *cache_acquire(workload_cache_t *cache, const char *path)
+{
+	struct stat info;
+	if (stat(path, &info) != 0)
+	{
+		return NULL;
+	}
+	pthread_mutex_lock(&cache->lock);
+	cached_workload_t *entry = cache_find(cache, path, &info);
+	pthread_mutex_unlock(&cache->lock);
+	if (entry)
+	{
+		return entry;
+	}
+
+	// Loaded outside the lock so hits aren't held up, concurrent misses on one file keep the first load
+	entry = (cached_workload_t *)calloc(1, sizeof(cached_workload_t));
+	if (!entry)
+	{
+		return NULL;
+	}
+	entry->path = join_path(NULL, path);
+	entry->workload = load_pcb_workload(path);
+	if (!entry->path || !entry->workload ||
+			(cache->hash && !result_cache_hash_file(path, &entry->key.input_hash, &entry->key.input_size)))
+	{
+		free_cached_workload(entry);
+		return NULL;
+	}
+	entry->modified = info.st_mtime;
+	entry->size = (uint64_t)info.st_size;
+	entry->inode = (uint64_t)info.st_ino;
+	entry->input = input_flags(entry->workload->pcbs);
+	entry->refs = 1;
+
+	pthread_mutex_lock(&cache->lock);
+	cached_workload_t *loaded = cache_find(cache, path, &info);
+	if (loaded)
+	{
+		pthread_mutex_unlock(&cache->lock);
+		free_cached_workload(entry);
+		return loaded;
+	}
+	size_t slot = 0;
+	for (size_t i = 0; i < cache->capacity; ++i)
+	{
+		if (!cache->entries[i])
+		{
+			slot = i;
+			break;
+		}
+		if (cache->entries[i]->last_used < cache->entries[slot]->last_used)
+		{
+			slot = i;
+		}
+	}
+	if (cache->entries[slot])
+	{
+		evict(cache, slot);
+	}
+	entry->last_used = ++cache->clock;
+	entry->cached = true;
+	cache->entries[slot] = entry;
+	pthread_mutex_unlock(&cache->lock);
+	return entry;
+}
+
+static void cache_release(workload_cache_t *cache, cached_workload_t *entry)
+{
+	pthread_mutex_lock(&cache->lock);
+	if (--entry->refs == 0 && !entry->cached)
+	{
+		free_cached_workload(entry);
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
+
+// A connected client. The polling thread owns it, except for the request line a worker is answering.
+typedef struct serve_client
+{
+	int fd;
+	size_t used;					// bytes buffered
+	size_t taken;					// bytes of the line handed to a worker, 0 if none is
+	bool done;						// the worker has answered, guarded by the queue lock
+	bool sent;						// and its reply reached the client
+	struct serve_client *next;		// in the queue of lines waiting for a worker
+	char buffer[SERVE_MAX_REQUEST];
+} serve_client_t;
+
+typedef struct
+{
+	int listener;
+	output_format_t format;
+	const ScheduleConfig_t *base;
+	const algorithm_options_t *options;
+	workload_cache_t cache;
+	ResultCache_t *results;			// NULL to always schedule
+	serve_client_t **clients;
+	size_t client_count;
+	size_t client_capacity;
+	pthread_mutex_t lock;			// guards the queue, stopping and the clients' done flags
+	pthread_cond_t ready;
+	serve_client_t *head;			// clients whose next line waits for a worker, oldest first
+	serve_client_t *tail;
+	bool stopping;
+	int wake[2];					// a worker writes a byte here once it has answered
+} server_t;
+
+static bool write_all(const int fd, const char *data, size_t length)
+{
+	while (length > 0)
+	{
+		const ssize_t written = write(fd, data, length);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written <= 0)
+		{
+			return false;
+		}
+		data += written;
+		length -= (size_t)written;
+	}
+	return true;
+}
+
+static void append_error_line(text_t *text, const output_format_t format, const char *message)
+{
+	if (format == FORMAT_JSON)
+	{
+		text_append(text, "{\"error\":");
+		append_json_string(text, message);
+		text_append(text, "}\n");
+	}
+	else
+	{
+		text_append(text, "error,");
+		append_csv_field(text, message);
+		text_append(text, "\n");
+	}
+}
+
+// Answers one request line, "<algorithm[:parameter]> <pcb file>", with one line: the result or an error
+// \return false if the reply couldn't be sent
+static bool answer_request(server_t *server, const int fd, char *request)
+{
+	const size_t length = strlen(request);
+	if (length > 0 && request[length - 1] == '\r')
+	{
+		request[length - 1] = '\0';
+	}
+
+	text_t reply = {NULL, 0, 0, false};
+	char *file = strchr(request, ' ');
+	algorithm_list_t list;
+	list.entries = NULL;
+	if (!file)
+	{
+		append_error_line(&reply, server->format, "expected <algorithm[:parameter]> <pcb file>");
+	}
+	else
+	{
+		*file++ = '\0';
+		if (!parse_algorithm_list(request, server->base, server->options, &list))
+		{
+			append_error_line(&reply, server->format, "unknown algorithm or invalid parameter");
+		}
+		else if (list.count != 1)
+		{
+			append_error_line(&reply, server->format, "one algorithm per request");
+		}
+		else
+		{
+			cached_workload_t *entry = cache_acquire(&server->cache, file);
+			if (!entry)
+			{
+				append_error_line(&reply, server->format, "failed to load process control blocks");
+			}
+			else
+			{
+				ScheduleResult_t result;
+				ResultCacheKey_t key = entry->key;
+				key.config_hash = sched_config_hash(&list.configs[0]);
+				if (server->results && result_cache_lookup(server->results, &key, &result, NULL))
+				{
+					append_result_line(&reply, server->format, file, list.labels[0], &result);
+				}
+				else if (!schedule_processes(entry->workload->pcbs, &list.configs[0], &result))
+				{
+					append_error_line(&reply, server->format, "scheduling algorithm failed");
+				}
+				else
+				{
+					if (server->results)
+					{
+						result_cache_store(server->results, &key, &result, entry->input);
+					}
+					append_result_line(&reply, server->format, file, list.labels[0], &result);
+				}
+				cache_release(&server->cache, entry);
+			}
+		}
+	}
+	free(list.entries);
+
+	const bool sent = !reply.failed && write_all(fd, reply.data, reply.length);
+	free(reply.data);
+	return sent;
+}
+
+// Hands the client's next complete line to the workers, one line at a time so replies keep their order
+// \return false if the client has to be dropped, its buffer is full without a whole line
+static bool dispatch_request(server_t *server, serve_client_t *client)
+{
+	if (client->taken)
+	{
+		return true;
+	}
+	char *newline = (char *)memchr(client->buffer, '\n', client->used);
+	if (!newline)
+	{
+		if (client->used < sizeof(client->buffer))
+		{
+			return true;
+		}
+		text_t reply = {NULL, 0, 0, false};
+		append_error_line(&reply, server->format, "request too long");
+		if (!reply.failed)
+		{
+			write_all(client->fd, reply.data, reply.length);
+		}
+		free(reply.data);
+		return false;
+	}
+
+	*newline = '\0';
+	client->taken = (size_t)(newline - client->buffer) + 1;
+	client->next = NULL;
+	pthread_mutex_lock(&server->lock);
+	if (server->tail)
+	{
+		server->tail->next = client;
+	}
+	else
+	{
+		server->head = client;
+	}
+	server->tail = client;
+	pthread_cond_signal(&server->ready);
+	pthread_mutex_unlock(&server->lock);
+	return true;
+}
+
+// Workers answer single request lines, so one busy client never holds a worker while it is idle
+static void *server_worker(void *arg)
+{
+	server_t *server = (server_t *)arg;
+	pthread_mutex_lock(&server->lock);
+	for (;;)
+	{
+		while (!server->head && !server->stopping)
+		{
+			pthread_cond_wait(&server->ready, &server->lock);
+		}
+		serve_client_t *client = server->head;
+		if (!client)
+		{
+			break;
+		}
+		server->head = client->next;
+		if (!server->head)
+		{
+			server->tail = NULL;
+		}
+		pthread_mutex_unlock(&server->lock);
+
+		const bool sent = answer_request(server, client->fd, client->buffer);
+
+		pthread_mutex_lock(&server->lock);
+		client->sent = sent;
+		client->done = true;
+		// The pipe is non-blocking, a full one already holds a wakeup
+		while (write(server->wake[1], "", 1) < 0 && errno == EINTR)
+		{
+		}
+	}
+	pthread_mutex_unlock(&server->lock);
+	return NULL;
+}
+
+static void drop_client(server_t *server, const size_t index)
+{
+	close(server->clients[index]->fd);
+	free(server->clients[index]);
+	server->clients[index] = server->clients[--server->client_count];
+}
+
+// Takes a new client off the listening socket
+// \return false if accepting failed for good
+static bool accept_client(server_t *server)
+{
+	const int fd = accept(server->listener, NULL, NULL);
+	if (fd < 0)
+	{
+		if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			return true;
+		}
+		perror("accept");
+		return false;
+	}
+	serve_client_t *client = (serve_client_t *)malloc(sizeof(serve_client_t));
+	if (client && server->client_count == server->client_capacity)
+	{
+		const size_t capacity = server->client_capacity ? 2 * server->client_capacity : 16;
+		serve_client_t **clients =
+			(serve_client_t **)realloc(server->clients, capacity * sizeof(serve_client_t *));
+		if (!clients)
+		{
+			free(client);
+			client = NULL;
+		}
+		else
+		{
+			server->clients = clients;
+			server->client_capacity = capacity;
+		}
+	}
+	if (!client)
+	{
+		close(fd);
+		return true;
+	}
+	client->fd = fd;
+	client->used = 0;
+	client->taken = 0;
+	client->done = false;
+	client->sent = false;
+	client->next = NULL;
+	server->clients[server->client_count++] = client;
+	return true;
+}
+
+// One thread polls the listening socket and every client without a request in flight, reads what arrives
+// and queues whole lines for the workers. Workers wake it through the pipe once they have answered.
+// \return once accepting or polling fails for good
+static void poll_clients(server_t *server)
+{
+	struct pollfd *polled = NULL;
+	size_t polled_capacity = 0;
+	for (;;)
+	{
+		if (polled_capacity < server->client_count + 2)
+		{
+			const size_t capacity = 2 * server->client_count + 2;
+			struct pollfd *grown = (struct pollfd *)realloc(polled, capacity * sizeof(struct pollfd));
+			if (!grown)
+			{
+				perror("realloc");
+				break;
+			}
+			polled = grown;
+			polled_capacity = capacity;
+		}
+		// Clients with a line at a worker aren't read from until it is answered, poll skips negative fds
+		polled[0].fd = server->wake[0];
+		polled[1].fd = server->listener;
+		for (size_t i = 0; i < server->client_count; ++i)
+		{
+			polled[i + 2].fd = server->clients[i]->taken ? -1 : server->clients[i]->fd;
+		}
+		const size_t count = server->client_count;
+		for (size_t i = 0; i < count + 2; ++i)
+		{
+			polled[i].events = POLLIN;
+			polled[i].revents = 0;
+		}
+		if (poll(polled, (nfds_t)(count + 2), -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			perror("poll");
+			break;
+		}
+
+		// Backwards, so dropping a client moves one already handled into its place
+		for (size_t i = count; i-- > 0;)
+		{
+			serve_client_t *client = server->clients[i];
+			if (!polled[i + 2].revents)
+			{
+				continue;
+			}
+			const ssize_t got = read(client->fd, client->buffer + client->used, sizeof(client->buffer) - client->used);
+			if (got < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (got <= 0)
+			{
+				drop_client(server, i);
+				continue;
+			}
+			client->used += (size_t)got;
+			if (!dispatch_request(server, client))
+			{
+				drop_client(server, i);
+			}
+		}
+
+		if (polled[0].revents)
+		{
+			char drained[64];
+			while (read(server->wake[0], drained, sizeof(drained)) > 0)
+			{
+			}
+			for (size_t i = server->client_count; i-- > 0;)
+			{
+				serve_client_t *client = server->clients[i];
+				pthread_mutex_lock(&server->lock);
+				const bool done = client->done;
+				client->done = false;
+				pthread_mutex_unlock(&server->lock);
+				if (!done)
+				{
+					continue;
+				}
+				// Pipelined lines already buffered go to the workers before the client is read again
+				client->used -= client->taken;
+				memmove(client->buffer, client->buffer + client->taken, client->used);
+				client->taken = 0;
+				if (!client->sent || !dispatch_request(server, client))
+				{
+					drop_client(server, i);
+				}
+			}
+		}
+
+		if (polled[1].revents && !accept_client(server))
+		{
+			break;
+		}
+	}
+	free(polled);
+}
+
+// A socket file no server answers on anymore, never a regular file or a directory
+static bool stale_socket(const char *path, const struct sockaddr_un *address)
+{
+	struct stat info;
+	if (stat(path, &info) != 0 || S_ISREG(info.st_mode) || S_ISDIR(info.st_mode))
+	{
+		return false;
+	}
+	const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe < 0)
+	{
+		return false;
+	}
+	const bool refused = connect(probe, (const struct sockaddr *)address, sizeof(*address)) != 0 &&
+		errno == ECONNREFUSED;
+	close(probe);
+	return refused;
+}
+
+// Binds a listening Unix socket at path, replacing one left behind by a server that is gone
+// \return the socket, -1 on error
+static int listen_at(const char *path)
+{
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "Error: Socket path '%s' is too long\n", path);
+		return -1;
+	}
+	memcpy(address.sun_path, path, strlen(path) + 1);
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0)
+	{
+		fprintf(stderr, "Error: Failed to create a socket: %s\n", strerror(errno));
+		return -1;
+	}
+	bool bound = bind(listener, (const struct sockaddr *)&address, sizeof(address)) == 0;
+	if (!bound && errno == EADDRINUSE && stale_socket(path, &address))
+	{
+		bound = unlink(path) == 0 && bind(listener, (const struct sockaddr *)&address, sizeof(address)) == 0;
+	}
+	if (!bound || listen(listener, SERVE_BACKLOG) != 0)
+	{
+		fprintf(stderr, "Error: Failed to listen on '%s': %s\n", path, strerror(errno));
+		close(listener);
+		return -1;
+	}
+	return listener;
+}
+
+// Answers requests on a Unix socket until accepting fails, see answer_request for the protocol.
+// One thread multiplexes every client and a pool of workers answers their requests, sharing one cache of
+// loaded workloads.
+static int run_server(const char *path, const ScheduleConfig_t *base, const algorithm_options_t *options,
+					  const output_format_t format, size_t threads, const size_t cache_size, ResultCache_t *results)
+{
+	server_t server;
+	server.results = results;
+	server.format = format;
+	server.base = base;
+	server.options = options;
+	server.cache.entries = (cached_workload_t **)calloc(cache_size, sizeof(cached_workload_t *));
+	server.cache.capacity = cache_size;
+	server.cache.clock = 0;
+	server.cache.hash = results != NULL;
+	server.clients = NULL;
+	server.client_count = 0;
+	server.client_capacity = 0;
+	server.head = NULL;
+	server.tail = NULL;
+	server.stopping = false;
+	if (!server.cache.entries)
+	{
+		return EXIT_FAILURE;
+	}
+	if (pipe(server.wake) != 0 || fcntl(server.wake[0], F_SETFL, O_NONBLOCK) != 0 ||
+		fcntl(server.wake[1], F_SETFL, O_NONBLOCK) != 0)
+	{
+		perror("pipe");
+		free(server.cache.entries);
+		return EXIT_FAILURE;
+	}
+	server.listener = listen_at(path);
+	if (server.listener < 0)
+	{
+		close(server.wake[0]);
+		close(server.wake[1]);
+		free(server.cache.entries);
+		return EXIT_FAILURE;
+	}
+	pthread_mutex_init(&server.cache.lock, NULL);
+	pthread_mutex_init(&server.lock, NULL);
+	pthread_cond_init(&server.ready, NULL);
+	// A client hanging up before its reply is sent must not take the server down
+	signal(SIGPIPE, SIG_IGN);
+
+	// Workers only ever compute, so one per CPU
+	if (threads == 0)
+	{
+		const long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 1 ? (size_t)online : 1;
+	}
+	pthread_t *workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+	size_t started = 0;
+	while (workers && started < threads && pthread_create(&workers[started], NULL, server_worker, &server) == 0)
+	{
+		++started;
+	}
+	if (started > 0)
+	{
+		printf("Serving on %s with %zu workers\n", path, started);
+		fflush(stdout);
+		poll_clients(&server);
+	}
+	else
+	{
+		fprintf(stderr, "Error: Failed to start any server workers\n");
+	}
+
+	// Workers answer what is queued before they stop
+	pthread_mutex_lock(&server.lock);
+	server.stopping = true;
+	pthread_cond_broadcast(&server.ready);
+	pthread_mutex_unlock(&server.lock);
+	for (size_t i = 0; i < started; ++i)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+	close(server.listener);
+	while (server.client_count > 0)
+	{
+		drop_client(&server, server.client_count - 1);
+	}
+	free(server.clients);
+	close(server.wake[0]);
+	close(server.wake[1]);
+
+	for (size_t i = 0; i < server.cache.capacity; ++i)
+	{
+		if (server.cache.entries[i])
+		{
+			free_cached_workload(server.cache.entries[i]);
+		}
+	}
+	free(server.cache.entries);
+	pthread_cond_destroy(&server.ready);
+	pthread_mutex_destroy(&server.lock);
+	pthread_mutex_destroy(&server.cache.lock);
+	unlink(path);
+	return EXIT_FAILURE;
+}
+
+// Phases of a profiled run, sorting is timed inside scheduling and reported apart from it
+typedef enum
+{
+	PHASE_LOAD,			// the result cache lookup and loading the PCB file, or sorting it into runs
+	PHASE_SCHEDULE,
+	PHASE_REPORT,
+	PHASE_COUNT
+} phase_t;
+
+typedef struct
+{
+	bool enabled;
+	Profile_t hardware;
+	uint64_t phase_start;			// op_counters_clock when the current phase began
+	uint64_t phase_sort_start;		// OP_SORT_NANOSECONDS when the current phase began
+	uint64_t phases[PHASE_COUNT];	// nanoseconds
+	uint64_t sorts[PHASE_COUNT];	// nanoseconds of each phase spent sorting
+} run_profile_t;
+
+// Starts the hardware counters and the first phase, the operation counters count from here
+static void profile_begin(run_profile_t *profile, const bool enabled)
+{
+	memset(profile, 0, sizeof(*profile));
+	profile->enabled = enabled;
+	if (enabled)
+	{
+		profile_start(&profile->hardware);
+		op_counters_reset();
+		profile->phase_start = op_counters_clock();
+	}
+}
+
+// Ends phase, the next one starts now
+static void profile_phase(run_profile_t *profile, const phase_t phase)
+{
+	if (profile->enabled)
+	{
+		const uint64_t now = op_counters_clock();
+		OpCounters_t counters;
+		op_counters_read(&counters);
+		profile->phases[phase] += now - profile->phase_start;
+		profile->sorts[phase] += counters.counts[OP_SORT_NANOSECONDS] - profile->phase_sort_start;
+		profile->phase_start = now;
+		profile->phase_sort_start = counters.counts[OP_SORT_NANOSECONDS];
+	}
+}
+
+// Reports the profile on stderr, out of the way of the results, and stops the hardware counters
+static void profile_end(run_profile_t *profile)
+{
+	if (!profile->enabled)
+	{
+		return;
+	}
+	uint64_t hardware[PROFILE_HARDWARE_COUNT];
+	bool available[PROFILE_HARDWARE_COUNT];
+	for (size_t i = 0; i < PROFILE_HARDWARE_COUNT; ++i)
+	{
+		available[i] = profile_read(&profile->hardware, (ProfileHardware_t)i, &hardware[i]);
+	}
+	profile_stop(&profile->hardware);
+	OpCounters_t counters;
+	op_counters_read(&counters);
+
+	// Sorting is taken out of the phase it happened in, the stream's runs are sorted while loading and
+	// out of order input while scheduling. Without the counters it can't be told apart from either.
+	uint64_t times[PHASE_COUNT];
+	uint64_t sort = 0;
+	for (size_t i = 0; i < PHASE_COUNT; ++i)
+	{
+		times[i] = profile->phases[i] > profile->sorts[i] ? profile->phases[i] - profile->sorts[i] : 0;
+		sort += profile->sorts[i];
+	}
+	fprintf(stderr, "Load Time: %.3f ms\n", (double)times[PHASE_LOAD] / 1e6);
+	if (op_counters_enabled())
+	{
+		fprintf(stderr, "Sort Time: %.3f ms\n", (double)sort / 1e6);
+	}
+	else
+	{
+		fprintf(stderr, "Sort Time: not available\n");
+	}
+	fprintf(stderr, "Simulate Time: %.3f ms\n", (double)times[PHASE_SCHEDULE] / 1e6);
+	fprintf(stderr, "Report Time: %.3f ms\n", (double)times[PHASE_REPORT] / 1e6);
+	fprintf(stderr, "Peak RSS: %" PRIu64 " KiB\n", profile_peak_rss());
+	for (size_t i = 0; i < PROFILE_HARDWARE_COUNT; ++i)
+	{
+		if (available[i])
+		{
+			fprintf(stderr, "%s: %" PRIu64 "\n", profile_hardware_name((ProfileHardware_t)i), hardware[i]);
+		}
+		else
+		{
+			fprintf(stderr, "%s: not available\n", profile_hardware_name((ProfileHardware_t)i));
+		}
+	}
+	if (!op_counters_enabled())
+	{
+		fprintf(stderr, "Operation Counters: compiled out\n");
+		return;
+	}
+	for (size_t i = 0; i < OP_COUNTER_COUNT; ++i)
+	{
+		if (i != OP_SORT_NANOSECONDS)
+		{
+			fprintf(stderr, "%s: %" PRIu64 "\n", op_counter_name((OpCounter_t)i), counters.counts[i]);
+		}
+	}
+}
+
+// Opens the result cache at path, *results is NULL without one
+static bool open_result_cache(const char *path, ResultCache_t **results)
+{
+	*results = NULL;
+	if (path)
+	{
+		*results = result_cache_open(path);
+		if (!*results)
+		{
+			fprintf(stderr, "Error: Failed to open result cache '%s'\n", path);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Converts a scheduler trace, "-" reads it from stdin
+static int run_import(const char *trace_file, const char *pcb_file, const char *tick_arg, const bool v1)
+{
+	uint64_t tick_ns = 1000;
+	if (tick_arg && (sscanf(tick_arg, "%" SCNu64, &tick_ns) != 1 || tick_ns == 0))
+	{
+		fprintf(stderr, "Error: Invalid tick length '%s'\n", tick_arg);
+		return EXIT_FAILURE;
+	}
+	FILE *input = strcmp(trace_file, "-") == 0 ? stdin : fopen(trace_file, "r");
+	if (!input)
+	{
+		fprintf(stderr, "Error: Failed to open trace '%s'\n", trace_file);
+		return EXIT_FAILURE;
+	}
+
+	TraceImportStats_t stats;
+	const bool ok = trace_import(input, pcb_file, tick_ns, v1, &stats);
+	if (input != stdin)
+	{
+		fclose(input);
+	}
+	if (!ok)
+	{
+		fprintf(stderr, "Error: Failed to import '%s' into '%s'\n", trace_file, pcb_file);
+		return EXIT_FAILURE;
+	}
+	printf("Lines: %" PRIu64 "\n", stats.lines);
+	printf("Events: %" PRIu64 "\n", stats.events);
+	printf("Skipped: %" PRIu64 "\n", stats.skipped);
+	printf("Tasks: %" PRIu64 "\n", stats.tasks);
+	printf("PCBs: %" PRIu64 "\n", stats.pcbs);
+	return EXIT_SUCCESS;
+}
+
+// Identifies a checkpointed run's input by its content: the hash of the PCB file, or with shards the hashes of
+// the files in the order they are merged
+static bool hash_checkpoint_input(const char *path, const bool shards, uint64_t *id)
+{
+	uint64_t size;
+	if (!shards)
+	{
+		return result_cache_hash_file(path, id, &size);
+	}
+	dyn_array_t *files = dyn_array_create(0, sizeof(char *), free_path);
+	bool ok = files && collect_files(path, files) && dyn_array_sort(files, compare_paths);
+	const char *const *paths = (const char *const *)dyn_array_export(files);
+	*id = 0xcbf29ce484222325u;
+	for (size_t i = 0; ok && i < dyn_array_size(files); ++i)
+	{
+		uint64_t hash;
+		ok = result_cache_hash_file(paths[i], &hash, &size);
+		*id = (*id ^ hash) * 0x100000001b3u;
+	}
+	dyn_array_destroy(files);
+	return ok;
+}
+
+// Loads the files of a directory (or a single file) as shards of one workload, in name order
+static PcbWorkload_t *load_shards(const char *path, const size_t threads)
+{
+	dyn_array_t *files = dyn_array_create(0, sizeof(char *), free_path);
+	if (!files || !collect_files(path, files) || dyn_array_empty(files))
+	{
+		dyn_array_destroy(files);
+		return NULL;
+	}
+	dyn_array_sort(files, compare_paths);
+	PcbWorkload_t *workload =
+		load_pcb_shards((const char *const *)dyn_array_export(files), dyn_array_size(files), threads);
+	dyn_array_destroy(files);
+	return workload;
+}
+
+// Runs a file too large to load through the simulator in arrival order, see pcb_stream.h, checkpointed
+// under checkpoints unless that is NULL.
+// The results are those of the loaded file, so they go to the result cache under the same key, NULL for none
+static int run_external(const char *pcb_file, const char *algorithm, const size_t run_pcbs, const char *temp_dir,
+						const char *trace_file, const output_format_t format, ScheduleConfig_t *config,
+						const checkpoint_plan_t *checkpoints, ResultCache_t *results, const ResultCacheKey_t *key,
+						run_profile_t *profile)
+{
+	PcbStream_t *stream = pcb_stream_open(pcb_file, run_pcbs, temp_dir);
+	if (!stream)
+	{
+		fprintf(stderr, "Error: Failed to sort process control blocks from '%s'\n", pcb_file);
+		return EXIT_FAILURE;
+	}
+	if (trace_file)
+	{
+		config->trace = schedule_trace_open(trace_file);
+		if (!config->trace)
+		{
+			fprintf(stderr, "Error: Failed to create trace file '%s'\n", trace_file);
+			pcb_stream_close(stream);
+			return EXIT_FAILURE;
+		}
+	}
+	profile_phase(profile, PHASE_LOAD);
+
+	ScheduleResult_t result;
+	bool success;
+	if (checkpoints)
+	{
+		arrival_feed_t feed = {NULL, NULL, 0, 0, stream};
+		success = run_checkpointed(&feed, config, checkpoints, &result);
+	}
+	else
+	{
+		success = pcb_stream_schedule(stream, config, &result);
+	}
+	if (!schedule_trace_close(config->trace))
+	{
+		fprintf(stderr, "Error: Failed to write trace file '%s'\n", trace_file);
+		success = false;
+	}
+	profile_phase(profile, PHASE_SCHEDULE);
+	const uint32_t input = pcb_stream_has_deadlines(stream) ? INPUT_DEADLINES : 0;
+	pcb_stream_close(stream);
+	if (!success)
+	{
+		fprintf(stderr, "Error: Scheduling algorithm '%s' failed\n", algorithm);
+		return EXIT_FAILURE;
+	}
+
+	if (key)
+	{
+		result_cache_store(results, key, &result, input);
+	}
+	if (format == FORMAT_CSV)
+	{
+		print_csv_header();
+	}
+	print_result(format, pcb_file, algorithm, input, config, &result);
+	profile_phase(profile, PHASE_REPORT);
+	profile_end(profile);
+	return EXIT_SUCCESS;
+}
 
 // Add and comment your analysis code in this function.
 // THIS IS NOT FINISHED.
 int main(int argc, char **argv) 
 {
-	if (argc < 3) 
+	// Pull the optional flags out first so the positional arguments keep their places
+	const char *positional[3] = {NULL, NULL, NULL};
+	size_t positional_count = 0;
+	const char *trace_file = NULL;
+	const char *levels_arg = NULL;
+	const char *quanta_arg = NULL;
+	const char *boost_arg = NULL;
+	const char *granularity_arg = NULL;
+	const char *switch_cost_arg = NULL;
+	const char *warmup_arg = NULL;
+	const char *warmup_decay_arg = NULL;
+	const char *cpus_arg = NULL;
+	const char *placement_arg = NULL;
+	const char *capacity_arg = NULL;
+	const char *admission_arg = NULL;
+	const char *checkpoint_file = NULL;
+	const char *checkpoint_every_arg = NULL;
+	const char *resume_file = NULL;
+	const char *sweep_arg = NULL;
+	const char *seed_arg = NULL;
+	const char *threads_arg = NULL;
+	const char *sweep_pcbs_arg = NULL;
+	const char *mean_gap_arg = NULL;
+	const char *mean_burst_arg = NULL;
+	const char *io_bursts_arg = NULL;
+	const char *slack_arg = NULL;
+	const char *format_arg = NULL;
+	const char *serve_socket = NULL;
+	const char *cache_arg = NULL;
+	const char *result_cache_file = NULL;
+	bool profiling = false;
+	const char *external_arg = NULL;
+	const char *temp_dir = NULL;
+	bool shards = false;
+	const char *import_file = NULL;
+	const char *tick_arg = NULL;
+	bool v1 = false;
+	const char *batch_list = NULL;
+	const char *const *batch_paths = NULL;
+	size_t batch_path_count = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], TRACE_FLAG) == 0 && i + 1 < argc)
+		{
+			trace_file = argv[++i];
+		}
+		else if (strcmp(argv[i], LEVELS_FLAG) == 0 && i + 1 < argc)
+		{
+			levels_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], QUANTA_FLAG) == 0 && i + 1 < argc)
+		{
+			quanta_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], BOOST_FLAG) == 0 && i + 1 < argc)
+		{
+			boost_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], GRANULARITY_FLAG) == 0 && i + 1 < argc)
+		{
+			granularity_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], SWITCH_COST_FLAG) == 0 && i + 1 < argc)
+		{
+			switch_cost_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], WARMUP_FLAG) == 0 && i + 1 < argc)
+		{
+			warmup_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], WARMUP_DECAY_FLAG) == 0 && i + 1 < argc)
+		{
+			warmup_decay_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], CPUS_FLAG) == 0 && i + 1 < argc)
+		{
+			cpus_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], PLACEMENT_FLAG) == 0 && i + 1 < argc)
+		{
+			placement_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], CAPACITY_FLAG) == 0 && i + 1 < argc)
+		{
+			capacity_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], ADMISSION_FLAG) == 0 && i + 1 < argc)
+		{
+			admission_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], CHECKPOINT_FLAG) == 0 && i + 1 < argc)
+		{
+			checkpoint_file = argv[++i];
+		}
+		else if (strcmp(argv[i], CHECKPOINT_EVERY_FLAG) == 0 && i + 1 < argc)
+		{
+			checkpoint_every_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], RESUME_FLAG) == 0 && i + 1 < argc)
+		{
+			resume_file = argv[++i];
+		}
+		else if (strcmp(argv[i], SWEEP_FLAG) == 0 && i + 1 < argc)
+		{
+			sweep_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], SEED_FLAG) == 0 && i + 1 < argc)
+		{
+			seed_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], THREADS_FLAG) == 0 && i + 1 < argc)
+		{
+			threads_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], SWEEP_PCBS_FLAG) == 0 && i + 1 < argc)
+		{
+			sweep_pcbs_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], MEAN_GAP_FLAG) == 0 && i + 1 < argc)
+		{
+			mean_gap_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], MEAN_BURST_FLAG) == 0 && i + 1 < argc)
+		{
+			mean_burst_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], IO_BURSTS_FLAG) == 0 && i + 1 < argc)
+		{
+			io_bursts_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], SLACK_FLAG) == 0 && i + 1 < argc)
+		{
+			slack_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], FORMAT_FLAG) == 0 && i + 1 < argc)
+		{
+			format_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], SERVE_FLAG) == 0 && i + 1 < argc)
+		{
+			serve_socket = argv[++i];
+		}
+		else if (strcmp(argv[i], CACHE_FLAG) == 0 && i + 1 < argc)
+		{
+			cache_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], RESULT_CACHE_FLAG) == 0 && i + 1 < argc)
+		{
+			result_cache_file = argv[++i];
+		}
+		else if (strcmp(argv[i], PROFILE_FLAG) == 0)
+		{
+			profiling = true;
+		}
+		else if (strcmp(argv[i], EXTERNAL_FLAG) == 0 && i + 1 < argc)
+		{
+			external_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], TEMP_DIR_FLAG) == 0 && i + 1 < argc)
+		{
+			temp_dir = argv[++i];
+		}
+		else if (strcmp(argv[i], SHARDS_FLAG) == 0)
+		{
+			shards = true;
+		}
+		else if (strcmp(argv[i], IMPORT_FLAG) == 0 && i + 1 < argc)
+		{
+			import_file = argv[++i];
+		}
+		else if (strcmp(argv[i], TICK_FLAG) == 0 && i + 1 < argc)
+		{
+			tick_arg = argv[++i];
+		}
+		else if (strcmp(argv[i], V1_FLAG) == 0)
+		{
+			v1 = true;
+		}
+		// Everything after the algorithm list is a file or directory of the batch
+		else if (strcmp(argv[i], BATCH_FLAG) == 0 && i + 1 < argc)
+		{
+			batch_list = argv[i + 1];
+			batch_paths = (const char *const *)&argv[i + 2];
+			batch_path_count = (size_t)(argc - i - 2);
+			break;
+		}
+		else if (positional_count < 3)
+		{
+			positional[positional_count++] = argv[i];
+		}
+		else
+		{
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// A sweep takes only the algorithm list, a batch and a server nothing but their own arguments, an import
+	// the PCB file to write, a run the PCB file and the algorithm
+	const size_t modes = (sweep_arg != NULL) + (batch_list != NULL) + (serve_socket != NULL) + (import_file != NULL);
+	if (modes > 1 || (batch_list && (positional_count > 0 || batch_path_count == 0)) ||
+			(serve_socket && positional_count > 0) || (import_file && positional_count != 1) ||
+			(modes == 0 && positional_count < 2) || (sweep_arg && positional_count != 1))
+	{
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	// Sweeps generate their workloads, and a run leaving a trace or checkpoints behind always schedules
+	if (result_cache_file && (sweep_arg || trace_file || checkpoint_file || resume_file))
+	{
+		fprintf(stderr, "Error: " RESULT_CACHE_FLAG " can't be combined with " SWEEP_FLAG ", " TRACE_FLAG ", "
+				CHECKPOINT_FLAG " or " RESUME_FLAG "\n");
+		return EXIT_FAILURE;
+	}
+	// The counters are per thread, so only a single run on the main thread is profiled
+	if (profiling && modes > 0)
+	{
+		fprintf(stderr, "Error: " PROFILE_FLAG " only profiles single runs\n");
+		return EXIT_FAILURE;
+	}
+	if ((external_arg || temp_dir) && modes > 0)
+	{
+		fprintf(stderr, "Error: " EXTERNAL_FLAG " only streams single runs\n");
+		return EXIT_FAILURE;
+	}
+	// The cache is keyed by the content of a single file
+	if (shards && (modes > 0 || external_arg || result_cache_file))
 	{
-		printf("Usage: %s <pcb file> <schedule algorithm> [quantum]\n", argv[0]);
+		fprintf(stderr, "Error: " SHARDS_FLAG " only merges the shards of single runs, without " EXTERNAL_FLAG
+				" or " RESULT_CACHE_FLAG "\n");
 		return EXIT_FAILURE;
 	}
 
-	const char *pcb_file = argv[1];
-	const char *algorithm = argv[2];
+	if (import_file)
+	{
+		return run_import(import_file, positional[0], tick_arg, v1);
+	}
 
-	// Load process control blocks from the binary file
-	dyn_array_t *ready_queue = load_process_control_blocks(pcb_file);
-	if (!ready_queue)
+	output_format_t format = FORMAT_TEXT;
+	if (format_arg)
 	{
-		fprintf(stderr, "Error: Failed to load process control blocks from '%s'\n", pcb_file);
+		static const char *const formats[] = {"text", "json", "csv"};
+		size_t i = 0;
+		while (i < sizeof(formats) / sizeof(formats[0]) && strcmp(format_arg, formats[i]) != 0)
+		{
+			++i;
+		}
+		if (i == sizeof(formats) / sizeof(formats[0]))
+		{
+			fprintf(stderr, "Error: Unknown output format '%s'\n", format_arg);
+			return EXIT_FAILURE;
+		}
+		if (sweep_arg && i != FORMAT_TEXT)
+		{
+			fprintf(stderr, "Error: " SWEEP_FLAG " only reports as text\n");
+			return EXIT_FAILURE;
+		}
+		format = (output_format_t)i;
+	}
+
+	ScheduleConfig_t config = {.algorithm = SCHEDULE_FCFS};
+	const algorithm_options_t options = {levels_arg, quanta_arg, boost_arg, granularity_arg};
+
+	// Switch costs apply to every policy
+	if ((switch_cost_arg && sscanf(switch_cost_arg, "%" SCNu64, &config.switch_cost) != 1) ||
+			(warmup_arg && sscanf(warmup_arg, "%" SCNu64, &config.warmup_cost) != 1) ||
+			(warmup_decay_arg && sscanf(warmup_decay_arg, "%" SCNu64, &config.warmup_decay) != 1))
+	{
+		fprintf(stderr, "Error: Invalid context switch cost\n");
 		return EXIT_FAILURE;
 	}
 
-	ScheduleResult_t result;
-	bool success = false;
+	uint32_t cpu_speeds[MAX_CPUS];
+	if (cpus_arg)
+	{
+		config.cpu_count = parse_speeds(cpus_arg, cpu_speeds, MAX_CPUS);
+		if (config.cpu_count == 0)
+		{
+			fprintf(stderr, "Error: Invalid CPU speeds '%s'\n", cpus_arg);
+			return EXIT_FAILURE;
+		}
+		config.cpu_speeds = cpu_speeds;
+	}
+	if (placement_arg)
+	{
+		static const char *const placements[] = {"fastest", "energy", "affinity"};
+		size_t i = 0;
+		while (i < sizeof(placements) / sizeof(placements[0]) && strcmp(placement_arg, placements[i]) != 0)
+		{
+			++i;
+		}
+		if (i == sizeof(placements) / sizeof(placements[0]))
+		{
+			fprintf(stderr, "Error: Unknown placement '%s'\n", placement_arg);
+			return EXIT_FAILURE;
+		}
+		config.placement = (SchedulePlacement_t)i;
+	}
 
-	// Dispatch to the appropriate scheduling algorithm
-	if (strncmp(algorithm, FCFS, 5) == 0)
+	if (capacity_arg && (sscanf(capacity_arg, "%zu", &config.ready_capacity) != 1 || config.ready_capacity == 0))
 	{
-		success = first_come_first_serve(ready_queue, &result);
+		fprintf(stderr, "Error: Invalid ready queue capacity '%s'\n", capacity_arg);
+		return EXIT_FAILURE;
 	}
-	else if (strncmp(algorithm, SJF, 4) == 0)
+	if (admission_arg)
 	{
-		success = shortest_job_first(ready_queue, &result);
+		static const char *const admissions[] = {"reject", "delay", "drop"};
+		size_t i = 0;
+		while (i < sizeof(admissions) / sizeof(admissions[0]) && strcmp(admission_arg, admissions[i]) != 0)
+		{
+			++i;
+		}
+		if (i == sizeof(admissions) / sizeof(admissions[0]))
+		{
+			fprintf(stderr, "Error: Unknown admission policy '%s'\n", admission_arg);
+			return EXIT_FAILURE;
+		}
+		config.admission = (ScheduleAdmission_t)i;
 	}
-	else if (strncmp(algorithm, P, 2) == 0)
+
+	// The shared settings are in place, a sweep, a batch or a server applies them to each of its algorithms
+	if (serve_socket)
 	{
-		success = priority(ready_queue, &result);
+		size_t threads = 0;
+		size_t cache_size = DEFAULT_SERVE_CACHE;
+		if (trace_file || checkpoint_file || resume_file)
+		{
+			fprintf(stderr, "Error: " SERVE_FLAG " can't be combined with " TRACE_FLAG ", " CHECKPOINT_FLAG " or "
+					RESUME_FLAG "\n");
+			return EXIT_FAILURE;
+		}
+		if ((threads_arg && sscanf(threads_arg, "%zu", &threads) != 1) ||
+				(cache_arg && (sscanf(cache_arg, "%zu", &cache_size) != 1 || cache_size == 0)))
+		{
+			fprintf(stderr, "Error: Invalid thread count or cache size\n");
+			return EXIT_FAILURE;
+		}
+		if (format == FORMAT_TEXT && format_arg)
+		{
+			fprintf(stderr, "Error: " SERVE_FLAG " replies json or csv\n");
+			return EXIT_FAILURE;
+		}
+		ResultCache_t *results;
+		if (!open_result_cache(result_cache_file, &results))
+		{
+			return EXIT_FAILURE;
+		}
+		const int status = run_server(serve_socket, &config, &options, format == FORMAT_CSV ? FORMAT_CSV : FORMAT_JSON,
+									  threads, cache_size, results);
+		result_cache_close(results);
+		return status;
 	}
-	else if (strncmp(algorithm, RR, 3) == 0)
+	if (batch_list)
 	{
-		if (argc < 4)
+		size_t threads = 0;
+		if (trace_file || checkpoint_file || resume_file)
 		{
-			fprintf(stderr, "Error: Round Robin requires a time quantum argument\n");
-			dyn_array_destroy(ready_queue);
+			fprintf(stderr, "Error: " BATCH_FLAG " can't be combined with " TRACE_FLAG ", " CHECKPOINT_FLAG " or "
+					RESUME_FLAG "\n");
+			return EXIT_FAILURE;
+		}
+		if (threads_arg && sscanf(threads_arg, "%zu", &threads) != 1)
+		{
+			fprintf(stderr, "Error: Invalid thread count '%s'\n", threads_arg);
 			return EXIT_FAILURE;
 		}
-		size_t quantum = 0;
-		if (sscanf(argv[3], "%zu", &quantum) != 1 || quantum == 0)
+		ResultCache_t *results;
+		if (!open_result_cache(result_cache_file, &results))
 		{
-			fprintf(stderr, "Error: Invalid time quantum '%s'\n", argv[3]);
-			dyn_array_destroy(ready_queue);
 			return EXIT_FAILURE;
 		}
-		success = round_robin(ready_queue, &result, quantum);
+		const int status = run_batch(batch_list, &config, &options, format, batch_paths, batch_path_count, threads,
+									 results);
+		result_cache_close(results);
+		return status;
 	}
-	else if (strncmp(algorithm, SRT, 4) == 0)
+	if (sweep_arg)
 	{
-		success = shortest_remaining_time_first(ready_queue, &result);
+		if (trace_file || checkpoint_file || resume_file)
+		{
+			fprintf(stderr, "Error: " SWEEP_FLAG " can't be combined with " TRACE_FLAG ", " CHECKPOINT_FLAG " or "
+					RESUME_FLAG "\n");
+			return EXIT_FAILURE;
+		}
+
+		MonteCarloSweep_t sweep = {
+			.workload = {DEFAULT_SWEEP_PCBS, DEFAULT_SWEEP_MEAN_GAP, DEFAULT_SWEEP_MEAN_BURST, DEFAULT_SWEEP_PRIORITIES,
+						 0, DEFAULT_SWEEP_MEAN_BURST, 0.0},
+			.seed = 1
+		};
+		if (sscanf(sweep_arg, "%zu", &sweep.workloads) != 1 || sweep.workloads < 2)
+		{
+			fprintf(stderr, "Error: Invalid workload count '%s', a sweep needs at least 2\n", sweep_arg);
+			return EXIT_FAILURE;
+		}
+		if ((seed_arg && sscanf(seed_arg, "%" SCNu64, &sweep.seed) != 1) ||
+				(threads_arg && sscanf(threads_arg, "%zu", &sweep.threads) != 1))
+		{
+			fprintf(stderr, "Error: Invalid seed or thread count\n");
+			return EXIT_FAILURE;
+		}
+		if ((sweep_pcbs_arg && (sscanf(sweep_pcbs_arg, "%zu", &sweep.workload.pcb_count) != 1 ||
+					sweep.workload.pcb_count == 0)) ||
+				(mean_gap_arg && (sscanf(mean_gap_arg, "%lf", &sweep.workload.mean_interarrival) != 1 ||
+					!(sweep.workload.mean_interarrival >= 0.0))) ||
+				(mean_burst_arg && (sscanf(mean_burst_arg, "%lf", &sweep.workload.mean_burst) != 1 ||
+					!(sweep.workload.mean_burst >= 1.0))) ||
+				(io_bursts_arg && sscanf(io_bursts_arg, "%" SCNu32, &sweep.workload.max_io_bursts) != 1) ||
+				(slack_arg && (sscanf(slack_arg, "%lf", &sweep.workload.deadline_slack) != 1 ||
+					!(sweep.workload.deadline_slack >= 0.0))))
+		{
+			fprintf(stderr, "Error: Invalid sweep workload shape\n");
+			return EXIT_FAILURE;
+		}
+		// IO bursts are as long as CPU bursts on average
+		sweep.workload.mean_io_burst = sweep.workload.mean_burst;
+
+		return run_sweep(positional[0], &config, &options, &sweep);
 	}
-	else
+
+	const char *pcb_file = positional[0];
+	const char *algorithm = positional[1];
+
+	if (!schedule_algorithm_from_name(algorithm, &config.algorithm))
 	{
 		fprintf(stderr, "Error: Unknown scheduling algorithm '%s'\n", algorithm);
-		fprintf(stderr, "Valid options: FCFS, SJF, P, RR, SRT\n");
-		dyn_array_destroy(ready_queue);
+		fprintf(stderr, "Valid options: FCFS, SJF, P, RR, SRT, PP, MLFQ, CFS, EDF, EDFP, HRRN\n");
+		return EXIT_FAILURE;
+	}
+
+	uint64_t level_quanta[SCHEDULE_MLFQ_MAX_LEVELS];
+	if (!configure_algorithm(&config, positional[2], &options, level_quanta))
+	{
+		return EXIT_FAILURE;
+	}
+
+	uint64_t checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+	if (checkpoint_every_arg &&
+			(sscanf(checkpoint_every_arg, "%" SCNu64, &checkpoint_interval) != 1 || checkpoint_interval == 0))
+	{
+		fprintf(stderr, "Error: Invalid checkpoint interval '%s'\n", checkpoint_every_arg);
+		return EXIT_FAILURE;
+	}
+	// A resumed run would only trace what is left of the schedule
+	if (resume_file && trace_file)
+	{
+		fprintf(stderr, "Error: " TRACE_FLAG " can't be combined with " RESUME_FLAG "\n");
+		return EXIT_FAILURE;
+	}
+
+	size_t run_pcbs = 0;
+	if (temp_dir && !external_arg)
+	{
+		fprintf(stderr, "Error: " TEMP_DIR_FLAG " needs " EXTERNAL_FLAG "\n");
+		return EXIT_FAILURE;
+	}
+	if (external_arg && (sscanf(external_arg, "%zu", &run_pcbs) != 1 || run_pcbs < 2))
+	{
+		fprintf(stderr, "Error: Invalid run size '%s', at least 2 PCBs\n", external_arg);
+		return EXIT_FAILURE;
+	}
+
+	size_t shard_threads = 0;
+	if (shards && threads_arg && sscanf(threads_arg, "%zu", &shard_threads) != 1)
+	{
+		fprintf(stderr, "Error: Invalid thread count '%s'\n", threads_arg);
+		return EXIT_FAILURE;
+	}
+
+	run_profile_t profile;
+	profile_begin(&profile, profiling);
+
+	// A cached result is reported without loading the file
+	ResultCache_t *results;
+	if (!open_result_cache(result_cache_file, &results))
+	{
+		return EXIT_FAILURE;
+	}
+	ScheduleResult_t result;
+	ResultCacheKey_t key = {0, 0, sched_config_hash(&config)};
+	uint32_t input;
+	const bool hashed = results && result_cache_hash_file(pcb_file, &key.input_hash, &key.input_size);
+	if (hashed && result_cache_lookup(results, &key, &result, &input))
+	{
+		result_cache_close(results);
+		profile_phase(&profile, PHASE_LOAD);
+		if (format == FORMAT_CSV)
+		{
+			print_csv_header();
+		}
+		print_result(format, pcb_file, algorithm, input, &config, &result);
+		profile_phase(&profile, PHASE_REPORT);
+		profile_end(&profile);
+		return EXIT_SUCCESS;
+	}
+
+	// A checkpoint only resumes the input it was taken of
+	checkpoint_plan_t checkpoints = {checkpoint_file, checkpoint_interval, resume_file, 0};
+	const bool checkpointed = checkpoint_file || resume_file;
+	if (checkpointed && !hash_checkpoint_input(pcb_file, shards, &checkpoints.input_id))
+	{
+		fprintf(stderr, "Error: Failed to read process control blocks from '%s'\n", pcb_file);
+		result_cache_close(results);
+		return EXIT_FAILURE;
+	}
+
+	// A streamed run gives the results of the loaded file, and shares its cache entries
+	if (external_arg)
+	{
+		const int status = run_external(pcb_file, algorithm, run_pcbs, temp_dir, trace_file, format, &config,
+										checkpointed ? &checkpoints : NULL, results, hashed ? &key : NULL, &profile);
+		result_cache_close(results);
+		return status;
+	}
+
+	// Load process control blocks from the binary file
+	PcbWorkload_t *workload = shards ? load_shards(pcb_file, shard_threads) : load_pcb_workload(pcb_file);
+	if (!workload)
+	{
+		fprintf(stderr, "Error: Failed to load process control blocks from '%s'\n", pcb_file);
+		result_cache_close(results);
 		return EXIT_FAILURE;
 	}
 
+	if (trace_file)
+	{
+		config.trace = schedule_trace_open(trace_file);
+		if (!config.trace)
+		{
+			fprintf(stderr, "Error: Failed to create trace file '%s'\n", trace_file);
+			pcb_workload_destroy(workload);
+			result_cache_close(results);
+			return EXIT_FAILURE;
+		}
+	}
+
+	profile_phase(&profile, PHASE_LOAD);
+
+	dyn_array_t *ready_queue = workload->pcbs;
+	bool success;
+	if (checkpointed)
+	{
+		success = dyn_array_size(ready_queue) > 0 &&
+			run_loaded_checkpointed(ready_queue, &config, &checkpoints, &result);
+	}
+	else
+	{
+		success = schedule_processes(ready_queue, &config, &result);
+	}
+
+	if (!schedule_trace_close(config.trace))
+	{
+		fprintf(stderr, "Error: Failed to write trace file '%s'\n", trace_file);
+		success = false;
+	}
+	profile_phase(&profile, PHASE_SCHEDULE);
+
 	if (success)
 	{
-		printf("Algorithm: %s\n", algorithm);
-		printf("Average Waiting Time: %.2f\n", result.average_waiting_time);
-		printf("Average Turnaround Time: %.2f\n", result.average_turnaround_time);
-		printf("Total Clock Time: %lu\n", result.total_run_time);
+		input = input_flags(ready_queue);
+		if (hashed)
+		{
+			result_cache_store(results, &key, &result, input);
+		}
+		if (format == FORMAT_CSV)
+		{
+			print_csv_header();
+		}
+		print_result(format, pcb_file, algorithm, input, &config, &result);
+		profile_phase(&profile, PHASE_REPORT);
+		profile_end(&profile);
 	}
 	else
 	{
 		fprintf(stderr, "Error: Scheduling algorithm '%s' failed\n", algorithm);
-		dyn_array_destroy(ready_queue);
+		pcb_workload_destroy(workload);
+		result_cache_close(results);
 		return EXIT_FAILURE;
 	}
 
 	// Clean up
-	dyn_array_destroy(ready_queue);
+	pcb_workload_destroy(workload);
+	result_cache_close(results);
 
 	return EXIT_SUCCESS;
 }
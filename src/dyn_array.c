@@ -1,19 +1,17 @@
 #include "dyn_array.h"
-
-// Flag values
-// SHRUNK to indicate shrink_to_fit was called and size needs to be corrected
-// SORTED to track if the objects have been sorted by us (sorted is set by sort and unset by insert/push)
-// these are just ideas
-// typedef enum {NONE = 0x00, SHRUNK = 0x01, SORTED = 0x02, ALL = 0xFF} DYN_FLAGS;
+#include "op_count.h"
 
 struct dyn_array 
 {
-	// DYN_FLAGS flags;
 	size_t capacity;
 	size_t size;
 	const size_t data_size;
 	void *array;
 	void (*destructor)(void *);
+	// The comparator the contents are known to be sorted by, NULL if unknown
+	// Set by sort, kept by removals and insert_sorted, cleared by any other insert, by for_each
+	// and by handing out a writable object pointer (front, back, at)
+	int (*sorted_by)(const void *, const void *);
 };
 
 // Supports 64bit+ size_t!
@@ -29,6 +27,16 @@ struct dyn_array
 // Gets the size (in bytes) of n dyn_array elements
 #define DYN_SIZE_N_ELEMS(dyn_array_ptr, n) ((dyn_array_ptr)->data_size * (n))
 
+// Objects may be written through the pointers front, back and at hand out, so the order is no longer known
+// Every dyn_array is malloc'd by create, never a const object, so the const can be cast away
+static inline void dyn_forget_order(const dyn_array_t *const dyn_array)
+{
+	if (dyn_array->sorted_by)
+	{
+		((dyn_array_t *)dyn_array)->sorted_by = NULL;
+	}
+}
+
 
 
 // Modes of operation for dyn_shift
@@ -71,7 +79,7 @@ dyn_array_t *dyn_array_create(const size_t capacity, const size_t data_type_size
 			// I had an idea... and it compiles
 			// const members of a malloc'd struct are so annoying
 			memcpy(dyn_array, &((dyn_array_t){actual_capacity, 0, data_type_size,
-											  malloc(data_type_size * actual_capacity), destruct_func}),
+											  malloc(data_type_size * actual_capacity), destruct_func, NULL}),
 				   sizeof(dyn_array_t));
 
 			if (dyn_array->array) 
@@ -113,7 +121,8 @@ dyn_array_t *dyn_array_import(const void *const data, const size_t count, const
 // exporting then changing isn't safe since it's all the same data
 const void *dyn_array_export(const dyn_array_t *const dyn_array) 
 {
-	return dyn_array_front(dyn_array);
+	// Not through front, the objects are read only here so the order stays known
+	return dyn_array && dyn_array->size ? dyn_array->array : NULL;
 }
 
 void dyn_array_destroy(dyn_array_t *dyn_array) 
@@ -135,6 +144,7 @@ void *dyn_array_front(const dyn_array_t *const dyn_array)
 		// If array is null, well, this is ok, because it's null
 		// but if array is broken, well, we can't help that
 		// nor can we detect that, so I guess it's not an error
+		dyn_forget_order(dyn_array);
 		return dyn_array->array;
 	}
 	return NULL;
@@ -162,6 +172,7 @@ void *dyn_array_back(const dyn_array_t *const dyn_array)
 {
 	if (dyn_array && dyn_array->size) 
 	{
+		dyn_forget_order(dyn_array);
 		return DYN_ARRAY_POSITION(dyn_array, dyn_array->size - 1);
 	}
 	return NULL;
@@ -187,8 +198,10 @@ bool dyn_array_extract_back(dyn_array_t *const dyn_array, void *const object)
 
 void *dyn_array_at(const dyn_array_t *const dyn_array, const size_t index) 
 {
+	OP_COUNT(OP_ARRAY_ACCESSES);
 	if (dyn_array && index < dyn_array->size) 
 	{
+		dyn_forget_order(dyn_array);
 		return DYN_ARRAY_POSITION(dyn_array, index);
 	}
 	return NULL;
@@ -255,18 +268,226 @@ size_t dyn_array_data_size(const dyn_array_t *const dyn_array)
 
 
 
+// Runs shorter than this are extended with insertion sort before merging, as timsort does
+#define DYN_SORT_MIN_RUN 32
+
+// A comparator call of the sort, counted as a comparison
+#define DYN_COMPARE(compare, a, b) (OP_COUNT(OP_COMPARISONS), (compare)((a), (b)))
+
+// Length of the run starting at start, a strictly descending run is reversed in place
+// Only strict descents are reversed so equal objects never swap and the sort stays stable
+static size_t dyn_sort_run(uint8_t *const base, const size_t start, const size_t end, const size_t width,
+						   int (*const compare)(const void *, const void *), uint8_t *const temp)
+{
+	size_t next = start + 1;
+	if (next == end)
+	{
+		return 1;
+	}
+	if (DYN_COMPARE(compare, base + next * width, base + start * width) < 0)
+	{
+		while (++next < end && DYN_COMPARE(compare, base + next * width, base + (next - 1) * width) < 0)
+		{
+		}
+		for (size_t lo = start, hi = next - 1; lo < hi; ++lo, --hi)
+		{
+			memcpy(temp, base + lo * width, width);
+			memcpy(base + lo * width, base + hi * width, width);
+			memcpy(base + hi * width, temp, width);
+		}
+	}
+	else
+	{
+		while (++next < end && DYN_COMPARE(compare, base + next * width, base + (next - 1) * width) >= 0)
+		{
+		}
+	}
+	return next - start;
+}
+
+// Grows the sorted run [start, sorted) to [start, end) one object at a time
+static void dyn_sort_insertion(uint8_t *const base, const size_t start, size_t sorted, const size_t end,
+							   const size_t width, int (*const compare)(const void *, const void *), uint8_t *const temp)
+{
+	for (; sorted < end; ++sorted)
+	{
+		size_t position = sorted;
+		while (position > start && DYN_COMPARE(compare, base + sorted * width, base + (position - 1) * width) < 0)
+		{
+			--position;
+		}
+		if (position != sorted)
+		{
+			memcpy(temp, base + sorted * width, width);
+			memmove(base + (position + 1) * width, base + position * width, (sorted - position) * width);
+			memcpy(base + position * width, temp, width);
+		}
+	}
+}
+
+// Merges the sorted runs [start, middle) and [middle, end) of src into the same span of dst
+// Ties take the left run so the merge is stable. Runs already in order cost one comparison and a copy.
+static void dyn_sort_merge(const uint8_t *const src, uint8_t *const dst, const size_t start, const size_t middle,
+						   const size_t end, const size_t width, int (*const compare)(const void *, const void *))
+{
+	size_t left = start;
+	size_t right = middle;
+	size_t out = start;
+	if (middle < end && middle > start && DYN_COMPARE(compare, src + (middle - 1) * width, src + middle * width) > 0)
+	{
+		while (left < middle && right < end)
+		{
+			if (DYN_COMPARE(compare, src + left * width, src + right * width) > 0)
+			{
+				memcpy(dst + out++ * width, src + right++ * width, width);
+			}
+			else
+			{
+				memcpy(dst + out++ * width, src + left++ * width, width);
+			}
+		}
+	}
+	memcpy(dst + out * width, src + left * width, (middle - left) * width);
+	out += middle - left;
+	memcpy(dst + out * width, src + right * width, (end - right) * width);
+}
+
+// Natural merge sort: finds the runs already in the data, then merges neighbouring runs pairwise until one
+// is left. Sorted input is a single run found with n - 1 comparisons and nothing moves, input made of k
+// runs costs about n log2(k). \return false if the buffers can't be allocated, with the array untouched
+static bool dyn_sort_adaptive(dyn_array_t *const dyn_array, int (*const compare)(const void *, const void *))
+{
+	const size_t count = dyn_array->size;
+	const size_t width = dyn_array->data_size;
+	uint8_t *base = (uint8_t *) dyn_array->array;
+
+	// The first run decides if there's anything to do, and needs no buffers
+	uint8_t temp_object[64];
+	uint8_t *temp = width <= sizeof(temp_object) ? temp_object : (uint8_t *) malloc(width);
+	if (!temp)
+	{
+		return false;
+	}
+	size_t length = dyn_sort_run(base, 0, count, width, compare, temp);
+	if (length == count)
+	{
+		if (temp != temp_object)
+		{
+			free(temp);
+		}
+		return true;
+	}
+
+	// Every run but the last is at least DYN_SORT_MIN_RUN long
+	size_t *run_ends = (size_t *) malloc((count / DYN_SORT_MIN_RUN + 2) * sizeof(size_t));
+	uint8_t *buffer = (uint8_t *) malloc(DYN_SIZE_N_ELEMS(dyn_array, count));
+	if (!run_ends || !buffer)
+	{
+		free(run_ends);
+		free(buffer);
+		if (temp != temp_object)
+		{
+			free(temp);
+		}
+		return false;
+	}
+
+	size_t runs = 0;
+	for (size_t start = 0; start < count; start += length)
+	{
+		if (start)
+		{
+			length = dyn_sort_run(base, start, count, width, compare, temp);
+		}
+		if (length < DYN_SORT_MIN_RUN && start + length < count)
+		{
+			const size_t end = count - start < DYN_SORT_MIN_RUN ? count : start + DYN_SORT_MIN_RUN;
+			dyn_sort_insertion(base, start, start + length, end, width, compare, temp);
+			length = end - start;
+		}
+		run_ends[runs++] = start + length;
+	}
+
+	// Each pass merges runs 2i and 2i + 1 from src into dst, an odd run out is copied across
+	uint8_t *src = base;
+	uint8_t *dst = buffer;
+	while (runs > 1)
+	{
+		size_t merged = 0;
+		size_t start = 0;
+		for (size_t run = 0; run < runs; run += 2)
+		{
+			const size_t middle = run_ends[run];
+			const size_t end = run + 1 < runs ? run_ends[run + 1] : middle;
+			dyn_sort_merge(src, dst, start, middle, end, width, compare);
+			run_ends[merged++] = end;
+			start = end;
+		}
+		runs = merged;
+		uint8_t *const swap = src;
+		src = dst;
+		dst = swap;
+	}
+	if (src != base)
+	{
+		memcpy(base, src, DYN_SIZE_N_ELEMS(dyn_array, count));
+	}
+
+	free(run_ends);
+	free(buffer);
+	if (temp != temp_object)
+	{
+		free(temp);
+	}
+	return true;
+}
+
 bool dyn_array_sort(dyn_array_t *const dyn_array, int (*const compare)(const void *, const void *)) 
 {
-	// hah, turns out there's a quicksort in cstdlib.
-	// and it works exactly like we want it to
 	if (dyn_array && dyn_array->size && compare) 
 	{
-		qsort(dyn_array->array, dyn_array->size, dyn_array->data_size, compare);
+		// Nothing has been inserted or handed out writable since the last sort by this comparator
+		if (dyn_array->sorted_by == compare)
+		{
+			return true;
+		}
+#ifndef OP_COUNTERS_DISABLED
+		const uint64_t start = op_counters_clock();
+#endif
+		// qsort is the fallback when the merge buffer can't be had, it needs no memory but isn't stable
+		if (!dyn_sort_adaptive(dyn_array, compare))
+		{
+			qsort(dyn_array->array, dyn_array->size, dyn_array->data_size, compare);
+		}
+#ifndef OP_COUNTERS_DISABLED
+		OP_COUNT_ADD(OP_SORT_NANOSECONDS, op_counters_clock() - start);
+#endif
+		dyn_array->sorted_by = compare;
 		return true;
 	}
 	return false;
 }
 
+bool dyn_array_is_sorted(const dyn_array_t *const dyn_array, int (*const compare)(const void *, const void *))
+{
+	if (!dyn_array || !compare)
+	{
+		return false;
+	}
+	if (dyn_array->sorted_by == compare)
+	{
+		return true;
+	}
+	for (size_t idx = 1; idx < dyn_array->size; ++idx)
+	{
+		if (DYN_COMPARE(compare, DYN_ARRAY_POSITION(dyn_array, idx), DYN_ARRAY_POSITION(dyn_array, idx - 1)) < 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 
 bool dyn_array_insert_sorted(dyn_array_t *const dyn_array, const void *const object,
 							 int (*const compare)(const void *, const void *)) 
@@ -277,12 +498,19 @@ bool dyn_array_insert_sorted(dyn_array_t *const dyn_array, const void *const obj
 		if (dyn_array->size) 
 		{
 			while (ordered_position < dyn_array->size
-				   && compare(object, DYN_ARRAY_POSITION(dyn_array, ordered_position)) > 0) 
+				   && DYN_COMPARE(compare, object, DYN_ARRAY_POSITION(dyn_array, ordered_position)) > 0) 
 			{
 				++ordered_position;
 			}
 		}
-		return dyn_shift_insert(dyn_array, ordered_position, 1, MODE_INSERT, object);
+		// Inserting in order keeps the array sorted by compare
+		int (*const sorted_by)(const void *, const void *) = dyn_array->sorted_by;
+		if (!dyn_shift_insert(dyn_array, ordered_position, 1, MODE_INSERT, object))
+		{
+			return false;
+		}
+		dyn_array->sorted_by = sorted_by == compare ? sorted_by : NULL;
+		return true;
 	}
 	return false;
 }
@@ -300,6 +528,8 @@ bool dyn_array_for_each(dyn_array_t *const dyn_array, void (*const func)(void *c
 		// Not checking it will segfault, which is good for debugging, but not so much for the end user
 		// but good for the tester. But the tester may not trigger this if it's a crazy edge case.
 		// HMMMMMMMMM...
+		// func may change the objects, so their order is no longer known
+		dyn_array->sorted_by = NULL;
 		uint8_t *data_walker = (uint8_t *) dyn_array->array;
 		for (size_t idx = 0; idx < dyn_array->size; ++idx, data_walker += dyn_array->data_size) 
 		{
@@ -359,11 +589,14 @@ bool dyn_shift_insert(dyn_array_t *const dyn_array, const size_t position, const
 		{
 			if (position != dyn_array->size) 
 			{  // wasn't a gap at the end, we need to move data
+				const size_t bytes = DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - position);
+				OP_COUNT_ADD(OP_MEMMOVE_BYTES, bytes);
 				memmove(DYN_ARRAY_POSITION(dyn_array, position + count), DYN_ARRAY_POSITION(dyn_array, position),
-						DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - position));
+						bytes);
 			}
 			memcpy(DYN_ARRAY_POSITION(dyn_array, position), data_src, dyn_array->data_size * count);
 			dyn_array->size += count;
+			dyn_array->sorted_by = NULL;
 			return true;
 		}
 	}
@@ -412,8 +645,10 @@ bool dyn_shift_remove(dyn_array_t *const dyn_array, const size_t position, const
 		if (position + count < dyn_array->size) 
 		{
 			// there's a actual gap, not just a hole to make at the end
+			const size_t bytes = DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - (position + count));
+			OP_COUNT_ADD(OP_MEMMOVE_BYTES, bytes);
 			memmove(DYN_ARRAY_POSITION(dyn_array, position), DYN_ARRAY_POSITION(dyn_array, position + count),
-					DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - (position + count)));
+					bytes);
 		}
 		// decrease the size and return
 		dyn_array->size -= count;
@@ -452,6 +687,7 @@ bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increm
 			// we can theoretically hold this, check if we can allocate that
 			// if (!MULTIPLY_MAY_OVERFLOW(new_capacity, dyn_array->data_size)) {
 			// we won't overflow, so we can at least REQUEST this change
+			OP_COUNT(OP_REALLOCS);
 			void *new_array = realloc(dyn_array->array, new_capacity * dyn_array->data_size);
 			if (new_array) 
 			{
@@ -0,0 +1,237 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "index_heap.h"
+#include "op_count.h"
+
+// Marks an id that is not in the heap
+#define NOT_IN_HEAP SIZE_MAX
+
+struct index_heap
+{
+	size_t *ids;			// the heap itself, ids[0] is the top
+	size_t size;
+	size_t capacity;		// of ids
+	size_t *positions;		// positions[id] = index of id in ids, NOT_IN_HEAP if absent
+	size_t id_capacity;		// of positions
+	bool (*before)(size_t, size_t, void *);
+	void *context;
+};
+
+#define HEAP_BEFORE(heap, a, b) \
+	(OP_COUNT(OP_COMPARISONS), (heap)->before((heap)->ids[a], (heap)->ids[b], (heap)->context))
+
+static void heap_swap(index_heap_t *const heap, const size_t i, const size_t j)
+{
+	const size_t id_i = heap->ids[i];
+	heap->ids[i] = heap->ids[j];
+	heap->ids[j] = id_i;
+	heap->positions[heap->ids[i]] = i;
+	heap->positions[heap->ids[j]] = j;
+}
+
+static size_t sift_up(index_heap_t *const heap, size_t index)
+{
+	while (index > 0)
+	{
+		const size_t parent = (index - 1) / 2;
+		if (!HEAP_BEFORE(heap, index, parent))
+		{
+			break;
+		}
+		heap_swap(heap, index, parent);
+		index = parent;
+	}
+	return index;
+}
+
+static void sift_down(index_heap_t *const heap, size_t index)
+{
+	for (;;)
+	{
+		const size_t left = 2 * index + 1;
+		if (left >= heap->size)
+		{
+			return;
+		}
+
+		size_t best = left;
+		if (left + 1 < heap->size && HEAP_BEFORE(heap, left + 1, left))
+		{
+			best = left + 1;
+		}
+		if (!HEAP_BEFORE(heap, best, index))
+		{
+			return;
+		}
+		heap_swap(heap, index, best);
+		index = best;
+	}
+}
+
+// Grows the position table so it can index id
+static bool reserve_id(index_heap_t *const heap, const size_t id)
+{
+	if (id < heap->id_capacity)
+	{
+		return true;
+	}
+
+	size_t new_capacity = heap->id_capacity ? heap->id_capacity : 16;
+	while (new_capacity <= id)
+	{
+		new_capacity <<= 1;
+	}
+
+	size_t *positions = realloc(heap->positions, new_capacity * sizeof(size_t));
+	if (!positions)
+	{
+		return false;
+	}
+	for (size_t i = heap->id_capacity; i < new_capacity; ++i)
+	{
+		positions[i] = NOT_IN_HEAP;
+	}
+	heap->positions = positions;
+	heap->id_capacity = new_capacity;
+	return true;
+}
+
+index_heap_t *index_heap_create(const size_t capacity, bool (*before)(size_t, size_t, void *), void *context)
+{
+	if (!before)
+	{
+		return NULL;
+	}
+
+	index_heap_t *heap = (index_heap_t *)malloc(sizeof(index_heap_t));
+	if (heap)
+	{
+		heap->capacity = capacity > 16 ? capacity : 16;
+		heap->ids = malloc(heap->capacity * sizeof(size_t));
+		heap->size = 0;
+		heap->positions = NULL;
+		heap->id_capacity = 0;
+		heap->before = before;
+		heap->context = context;
+
+		if (heap->ids && reserve_id(heap, heap->capacity - 1))
+		{
+			return heap;
+		}
+		index_heap_destroy(heap);
+	}
+	return NULL;
+}
+
+void index_heap_destroy(index_heap_t *const heap)
+{
+	if (heap)
+	{
+		free(heap->ids);
+		free(heap->positions);
+		free(heap);
+	}
+}
+
+bool index_heap_push(index_heap_t *const heap, const size_t id)
+{
+	if (!heap || id == NOT_IN_HEAP || !reserve_id(heap, id) || heap->positions[id] != NOT_IN_HEAP)
+	{
+		return false;
+	}
+
+	if (heap->size == heap->capacity)
+	{
+		size_t *ids = realloc(heap->ids, (heap->capacity << 1) * sizeof(size_t));
+		if (!ids)
+		{
+			return false;
+		}
+		heap->ids = ids;
+		heap->capacity <<= 1;
+	}
+
+	OP_COUNT(OP_HEAP_OPERATIONS);
+	heap->ids[heap->size] = id;
+	heap->positions[id] = heap->size;
+	++heap->size;
+	sift_up(heap, heap->size - 1);
+	return true;
+}
+
+bool index_heap_peek(const index_heap_t *const heap, size_t *const id)
+{
+	if (!heap || !id || heap->size == 0)
+	{
+		return false;
+	}
+	*id = heap->ids[0];
+	return true;
+}
+
+bool index_heap_pop(index_heap_t *const heap, size_t *const id)
+{
+	return index_heap_peek(heap, id) && index_heap_remove(heap, *id);
+}
+
+bool index_heap_remove(index_heap_t *const heap, const size_t id)
+{
+	if (!index_heap_contains(heap, id))
+	{
+		return false;
+	}
+
+	OP_COUNT(OP_HEAP_OPERATIONS);
+	const size_t index = heap->positions[id];
+	const size_t last = heap->size - 1;
+	if (index != last)
+	{
+		heap_swap(heap, index, last);
+	}
+	heap->positions[id] = NOT_IN_HEAP;
+	--heap->size;
+
+	// The id moved into the hole may belong above or below it
+	if (index < heap->size)
+	{
+		sift_down(heap, sift_up(heap, index));
+	}
+	return true;
+}
+
+bool index_heap_update(index_heap_t *const heap, const size_t id)
+{
+	if (!index_heap_contains(heap, id))
+	{
+		return false;
+	}
+	OP_COUNT(OP_HEAP_OPERATIONS);
+	sift_down(heap, sift_up(heap, heap->positions[id]));
+	return true;
+}
+
+bool index_heap_contains(const index_heap_t *const heap, const size_t id)
+{
+	return heap && id < heap->id_capacity && heap->positions[id] != NOT_IN_HEAP;
+}
+
+size_t index_heap_size(const index_heap_t *const heap)
+{
+	if (heap)
+	{
+		return heap->size;
+	}
+	return 0;
+}
+
+void index_heap_for_each(const index_heap_t *const heap, void (*const func)(size_t, void *), void *arg)
+{
+	if (heap && func)
+	{
+		for (size_t i = 0; i < heap->size; ++i)
+		{
+			func(heap->ids[i], arg);
+		}
+	}
+}
@@ -0,0 +1,339 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "monte_carlo.h"
+#include "scheduler.h"
+
+// Two sided 97.5% quantiles of Student's t for 1 to 30 degrees of freedom
+static const double t_quantiles[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double t_quantile(const size_t degrees)
+{
+	if (degrees <= sizeof(t_quantiles) / sizeof(t_quantiles[0]))
+	{
+		return t_quantiles[degrees - 1];
+	}
+	// Cornish-Fisher expansion around the normal 1.96, within 0.003 of the table from 30 on
+	const double z = 1.959964;
+	return z + (z * z * z + z) / (4.0 * (double)degrees);
+}
+
+// splitmix64, seeded per workload so workloads don't depend on which thread generates them
+static uint64_t next_random(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+static double next_uniform(uint64_t *state)
+{
+	return (double)(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double next_exponential(uint64_t *state, const double mean)
+{
+	return -mean * log(1.0 - next_uniform(state));
+}
+
+// Exponential ticks, at least 1
+static uint32_t next_ticks(uint64_t *state, const double mean)
+{
+	const double ticks = floor(next_exponential(state, mean) + 0.5);
+	if (ticks < 1.0)
+	{
+		return 1;
+	}
+	return ticks >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)ticks;
+}
+
+static bool valid_shape(const MonteCarloWorkload_t *shape)
+{
+	return shape && shape->pcb_count > 0 && shape->mean_interarrival >= 0.0 && shape->mean_burst >= 0.0 &&
+		shape->mean_io_burst >= 0.0 && shape->deadline_slack >= 0.0;
+}
+
+// Fills pcbs with workload index, the IO bursts go to *bursts which is grown as needed and whose
+// *capacity is kept across calls
+static bool generate(const MonteCarloWorkload_t *shape, const uint64_t seed, const size_t index, dyn_array_t *pcbs,
+					 uint32_t **bursts, size_t *capacity)
+{
+	// The stream starts at a hash of seed and index, neighbouring indices don't share draws
+	uint64_t state = seed;
+	state = next_random(&state) ^ (uint64_t)index;
+	state = next_random(&state);
+
+	dyn_array_clear(pcbs);
+	size_t burst_count = 0;
+	double arrival = 0.0;
+	for (size_t i = 0; i < shape->pcb_count; ++i)
+	{
+		ProcessControlBlock_t pcb = {0};
+		pcb.pid = (uint32_t)i;
+		pcb.arrival = (uint64_t)arrival;
+		pcb.remaining_burst_time = next_ticks(&state, shape->mean_burst);
+		pcb.priority = shape->priority_levels > 0 ? (uint32_t)(next_random(&state) % shape->priority_levels) : 0;
+		arrival += next_exponential(&state, shape->mean_interarrival);
+
+		uint64_t demand = pcb.remaining_burst_time;
+		const uint32_t io_bursts =
+			shape->max_io_bursts > 0 ? (uint32_t)(next_random(&state) % ((uint64_t)shape->max_io_bursts + 1)) : 0;
+		if (burst_count + 2 * (size_t)io_bursts > *capacity)
+		{
+			size_t grown = *capacity > 0 ? *capacity : 64;
+			while (grown < burst_count + 2 * (size_t)io_bursts)
+			{
+				grown *= 2;
+			}
+			uint32_t *larger = (uint32_t *)realloc(*bursts, grown * sizeof(uint32_t));
+			if (!larger)
+			{
+				return false;
+			}
+			*bursts = larger;
+			*capacity = grown;
+		}
+		for (uint32_t j = 0; j < io_bursts; ++j)
+		{
+			(*bursts)[burst_count++] = next_ticks(&state, shape->mean_io_burst);
+			(*bursts)[burst_count] = next_ticks(&state, shape->mean_burst);
+			demand += (*bursts)[burst_count++];
+		}
+		// next_bursts is pointed into the buffer once it has stopped moving
+		pcb.next_burst_count = 2 * io_bursts;
+
+		if (shape->deadline_slack > 0.0)
+		{
+			const uint64_t slack = (uint64_t)(shape->deadline_slack * (double)demand);
+			pcb.deadline = pcb.arrival + (slack > 0 ? slack : 1);
+		}
+
+		if (!dyn_array_push_back(pcbs, &pcb))
+		{
+			return false;
+		}
+	}
+
+	size_t offset = 0;
+	for (size_t i = 0; i < shape->pcb_count; ++i)
+	{
+		ProcessControlBlock_t *pcb = (ProcessControlBlock_t *)dyn_array_at(pcbs, i);
+		if (pcb->next_burst_count > 0)
+		{
+			pcb->next_bursts = *bursts + offset;
+			offset += pcb->next_burst_count;
+		}
+	}
+	return true;
+}
+
+PcbWorkload_t *monte_carlo_workload(const MonteCarloWorkload_t *shape, const uint64_t seed, const size_t index)
+{
+	if (!valid_shape(shape))
+	{
+		return NULL;
+	}
+
+	PcbWorkload_t *workload = (PcbWorkload_t *)calloc(1, sizeof(PcbWorkload_t));
+	if (!workload)
+	{
+		return NULL;
+	}
+	workload->pcbs = dyn_array_create(shape->pcb_count, sizeof(ProcessControlBlock_t), NULL);
+	size_t capacity = 0;
+	if (!workload->pcbs || !generate(shape, seed, index, workload->pcbs, &workload->bursts, &capacity))
+	{
+		pcb_workload_destroy(workload);
+		return NULL;
+	}
+	return workload;
+}
+
+typedef struct
+{
+	const MonteCarloSweep_t *sweep;
+	ScheduleResult_t *results;		// workload k's result under config c at k * config_count + c
+	atomic_size_t next;				// next workload to take
+	atomic_bool failed;
+}
+sweep_state_t;
+
+static void *sweep_worker(void *arg)
+{
+	sweep_state_t *state = (sweep_state_t *)arg;
+	const MonteCarloSweep_t *sweep = state->sweep;
+
+	dyn_array_t *pcbs = dyn_array_create(sweep->workload.pcb_count, sizeof(ProcessControlBlock_t), NULL);
+	uint32_t *bursts = NULL;
+	size_t capacity = 0;
+	if (!pcbs)
+	{
+		atomic_store(&state->failed, true);
+		return NULL;
+	}
+
+	while (!atomic_load(&state->failed))
+	{
+		const size_t k = atomic_fetch_add(&state->next, 1);
+		if (k >= sweep->workloads)
+		{
+			break;
+		}
+
+		bool ok = generate(&sweep->workload, sweep->seed, k, pcbs, &bursts, &capacity);
+		for (size_t c = 0; ok && c < sweep->config_count; ++c)
+		{
+			ok = sched_run(pcbs, &sweep->configs[c], &state->results[k * sweep->config_count + c]);
+		}
+		if (!ok)
+		{
+			atomic_store(&state->failed, true);
+		}
+	}
+
+	dyn_array_destroy(pcbs);
+	free(bursts);
+	return NULL;
+}
+
+static double metric_value(const ScheduleResult_t *result, const MonteCarloMetric_t metric)
+{
+	switch (metric)
+	{
+		case MONTE_CARLO_WAITING_TIME:
+			return result->average_waiting_time;
+		case MONTE_CARLO_TURNAROUND_TIME:
+			return result->average_turnaround_time;
+		case MONTE_CARLO_RUN_TIME:
+			return (double)result->total_run_time;
+		case MONTE_CARLO_CPU_UTILIZATION:
+			return result->cpu_utilization;
+		case MONTE_CARLO_IO_UTILIZATION:
+			return result->io_utilization;
+		case MONTE_CARLO_THROUGHPUT:
+			return result->throughput;
+		case MONTE_CARLO_CONTEXT_SWITCHES:
+			return (double)result->context_switches;
+		case MONTE_CARLO_MISSED_DEADLINES:
+			return (double)result->missed_deadlines;
+		case MONTE_CARLO_REJECTED:
+			return (double)result->rejected;
+		case MONTE_CARLO_DROPPED:
+			return (double)result->dropped;
+		default:
+			return 0.0;
+	}
+}
+
+// Mean and 95% interval of one metric of one config, summed in workload order
+static MonteCarloEstimate_t estimate(const MonteCarloSweep_t *sweep, const ScheduleResult_t *results, const size_t config,
+									 const MonteCarloMetric_t metric)
+{
+	const size_t n = sweep->workloads;
+	double sum = 0.0;
+	for (size_t k = 0; k < n; ++k)
+	{
+		sum += metric_value(&results[k * sweep->config_count + config], metric);
+	}
+	const double mean = sum / (double)n;
+
+	double squares = 0.0;
+	for (size_t k = 0; k < n; ++k)
+	{
+		const double deviation = metric_value(&results[k * sweep->config_count + config], metric) - mean;
+		squares += deviation * deviation;
+	}
+
+	MonteCarloEstimate_t result = {mean, t_quantile(n - 1) * sqrt(squares / (double)(n - 1) / (double)n)};
+	return result;
+}
+
+bool monte_carlo_sweep(const MonteCarloSweep_t *sweep, MonteCarloSummary_t *summaries)
+{
+	if (!sweep || !summaries || !valid_shape(&sweep->workload) || sweep->workloads < 2 || !sweep->configs ||
+			sweep->config_count == 0)
+	{
+		return false;
+	}
+	for (size_t c = 0; c < sweep->config_count; ++c)
+	{
+		if (sweep->configs[c].trace)
+		{
+			return false;
+		}
+	}
+	if (sweep->workloads > SIZE_MAX / sweep->config_count / sizeof(ScheduleResult_t))
+	{
+		return false;
+	}
+
+	sweep_state_t state;
+	state.sweep = sweep;
+	state.results = (ScheduleResult_t *)malloc(sweep->workloads * sweep->config_count * sizeof(ScheduleResult_t));
+	atomic_init(&state.next, 0);
+	atomic_init(&state.failed, false);
+	if (!state.results)
+	{
+		return false;
+	}
+
+	size_t threads = sweep->threads;
+	if (threads == 0)
+	{
+		const long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 0 ? (size_t)online : 1;
+	}
+	if (threads > sweep->workloads)
+	{
+		threads = sweep->workloads;
+	}
+
+	// The calling thread is one of the workers
+	pthread_t *workers = threads > 1 ? (pthread_t *)malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+	size_t started = 0;
+	while (workers && started < threads - 1 && pthread_create(&workers[started], NULL, sweep_worker, &state) == 0)
+	{
+		++started;
+	}
+	sweep_worker(&state);
+	for (size_t i = 0; i < started; ++i)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+
+	const bool ok = !atomic_load(&state.failed);
+	for (size_t c = 0; ok && c < sweep->config_count; ++c)
+	{
+		for (size_t m = 0; m < MONTE_CARLO_METRIC_COUNT; ++m)
+		{
+			summaries[c].metrics[m] = estimate(sweep, state.results, c, (MonteCarloMetric_t)m);
+		}
+	}
+
+	free(state.results);
+	return ok;
+}
+
+const char *monte_carlo_metric_name(const MonteCarloMetric_t metric)
+{
+	static const char *const names[MONTE_CARLO_METRIC_COUNT] = {
+		"Average Waiting Time", "Average Turnaround Time", "Total Clock Time", "CPU Utilization",
+		"IO Utilization", "Throughput", "Context Switches", "Missed Deadlines", "Rejected", "Dropped"
+	};
+	if ((size_t)metric >= MONTE_CARLO_METRIC_COUNT)
+	{
+		return NULL;
+	}
+	return names[metric];
+}
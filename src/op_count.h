@@ -0,0 +1,17 @@
+#ifndef OP_COUNT_H
+#define OP_COUNT_H
+
+#include "op_counters.h"
+
+// The calling thread's counters, read through op_counters.h
+extern _Thread_local uint64_t op_counts[OP_COUNTER_COUNT];
+
+#ifdef OP_COUNTERS_DISABLED
+#define OP_COUNT(counter) ((void)0)
+#define OP_COUNT_ADD(counter, amount) ((void)0)
+#else
+#define OP_COUNT(counter) (++op_counts[counter])
+#define OP_COUNT_ADD(counter, amount) (op_counts[counter] += (amount))
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+// clock_gettime and CLOCK_MONOTONIC are POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+
+#include "op_count.h"
+
+_Thread_local uint64_t op_counts[OP_COUNTER_COUNT];
+
+void op_counters_read(OpCounters_t *counters)
+{
+	if (counters)
+	{
+		memcpy(counters->counts, op_counts, sizeof(op_counts));
+	}
+}
+
+void op_counters_reset(void)
+{
+	memset(op_counts, 0, sizeof(op_counts));
+}
+
+const char *op_counter_name(const OpCounter_t counter)
+{
+	static const char *const names[OP_COUNTER_COUNT] = {
+		"Comparisons", "Array Accesses", "Heap Operations", "Ticks Simulated", "Events Processed",
+		"Memmove Bytes", "Reallocs", "Read Calls", "Records Decoded",
+		"Sort Nanoseconds"
+	};
+	if ((size_t)counter >= OP_COUNTER_COUNT)
+	{
+		return NULL;
+	}
+	return names[counter];
+}
+
+bool op_counters_enabled(void)
+{
+#ifdef OP_COUNTERS_DISABLED
+	return false;
+#else
+	return true;
+#endif
+}
+
+uint64_t op_counters_clock(void)
+{
+	struct timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+	{
+		return 0;
+	}
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
@@ -0,0 +1,229 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "op_count.h"
+#include "pcb_shards.h"
+
+typedef struct
+{
+	const char *const *paths;
+	PcbWorkload_t **shards;			// each sorted by arrival once loaded
+	size_t count;
+	atomic_size_t next;				// next shard to take
+	atomic_bool failed;
+} shard_load_t;
+
+// The loader's pids are record indices, so this is a stable sort by arrival
+static int compare_arrival_then_pid(const void *a, const void *b)
+{
+	const ProcessControlBlock_t *x = (const ProcessControlBlock_t *)a;
+	const ProcessControlBlock_t *y = (const ProcessControlBlock_t *)b;
+	if (x->arrival != y->arrival)
+	{
+		return x->arrival < y->arrival ? -1 : 1;
+	}
+	return x->pid < y->pid ? -1 : x->pid > y->pid;
+}
+
+static void *shard_worker(void *arg)
+{
+	shard_load_t *load = (shard_load_t *)arg;
+	while (!atomic_load(&load->failed))
+	{
+		const size_t k = atomic_fetch_add(&load->next, 1);
+		if (k >= load->count)
+		{
+			break;
+		}
+
+		load->shards[k] = load_pcb_workload(load->paths[k]);
+		if (!load->shards[k] || (!dyn_array_empty(load->shards[k]->pcbs) &&
+				!dyn_array_sort(load->shards[k]->pcbs, compare_arrival_then_pid)))
+		{
+			atomic_store(&load->failed, true);
+		}
+	}
+	return NULL;
+}
+
+// Tournament over the heads of the sorted shards. Leaf i is shard i at node count + i, node n plays the
+// winners of nodes 2n and 2n + 1 and keeps the loser, node 0 keeps the overall winner. Replacing the winner
+// only replays the matches on its path to the root, each against the loser stored there.
+typedef struct
+{
+	const ProcessControlBlock_t **heads;	// next PCB of each shard, NULL once it is used up
+	const ProcessControlBlock_t **ends;
+	size_t *nodes;
+	size_t count;
+} loser_tree_t;
+
+// Used up shards lose every match, ties go to the earlier shard
+static bool shard_before(const loser_tree_t *tree, const size_t a, const size_t b)
+{
+	const ProcessControlBlock_t *x = tree->heads[a];
+	const ProcessControlBlock_t *y = tree->heads[b];
+	if (!x || !y)
+	{
+		return x != NULL;
+	}
+	OP_COUNT(OP_COMPARISONS);
+	return x->arrival < y->arrival || (x->arrival == y->arrival && a < b);
+}
+
+// Plays every match below node, \return the winner
+static size_t loser_tree_play(loser_tree_t *tree, const size_t node)
+{
+	if (node >= tree->count)
+	{
+		return node - tree->count;
+	}
+	const size_t left = loser_tree_play(tree, 2 * node);
+	const size_t right = loser_tree_play(tree, 2 * node + 1);
+	const bool left_wins = shard_before(tree, left, right);
+	tree->nodes[node] = left_wins ? right : left;
+	return left_wins ? left : right;
+}
+
+// Moves the winner's shard on to its next PCB and replays its path
+static void loser_tree_advance(loser_tree_t *tree)
+{
+	size_t winner = tree->nodes[0];
+	if (++tree->heads[winner] == tree->ends[winner])
+	{
+		tree->heads[winner] = NULL;
+	}
+	for (size_t node = (tree->count + winner) / 2; node > 0; node /= 2)
+	{
+		if (shard_before(tree, tree->nodes[node], winner))
+		{
+			const size_t loser = winner;
+			winner = tree->nodes[node];
+			tree->nodes[node] = loser;
+		}
+	}
+	tree->nodes[0] = winner;
+}
+
+// Merges the sorted shards into pcbs, copying every PCB's IO bursts into one pool
+static bool merge_shards(PcbWorkload_t *const *shards, const size_t count, PcbWorkload_t *merged)
+{
+	uint64_t total = 0;
+	uint64_t burst_total = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const size_t n = dyn_array_size(shards[i]->pcbs);
+		const ProcessControlBlock_t *pcbs = (const ProcessControlBlock_t *)dyn_array_export(shards[i]->pcbs);
+		total += n;
+		for (size_t j = 0; j < n; ++j)
+		{
+			burst_total += pcbs[j].next_burst_count;
+		}
+	}
+	if (total > SIZE_MAX || burst_total > SIZE_MAX / sizeof(uint32_t))
+	{
+		return false;
+	}
+
+	loser_tree_t tree;
+	tree.count = count;
+	tree.heads = (const ProcessControlBlock_t **)malloc(count * sizeof(ProcessControlBlock_t *));
+	tree.ends = (const ProcessControlBlock_t **)malloc(count * sizeof(ProcessControlBlock_t *));
+	tree.nodes = (size_t *)malloc(count * sizeof(size_t));
+	merged->pcbs = dyn_array_create((size_t)total, sizeof(ProcessControlBlock_t), NULL);
+	merged->bursts = burst_total ? (uint32_t *)malloc((size_t)burst_total * sizeof(uint32_t)) : NULL;
+	bool ok = tree.heads && tree.ends && tree.nodes && merged->pcbs && (!burst_total || merged->bursts);
+
+	if (ok)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const size_t n = dyn_array_size(shards[i]->pcbs);
+			tree.heads[i] = n ? (const ProcessControlBlock_t *)dyn_array_export(shards[i]->pcbs) : NULL;
+			tree.ends[i] = tree.heads[i] ? tree.heads[i] + n : NULL;
+		}
+		tree.nodes[0] = loser_tree_play(&tree, 1);
+	}
+
+	size_t pool_used = 0;
+	for (uint64_t k = 0; ok && k < total; ++k)
+	{
+		ProcessControlBlock_t pcb = *tree.heads[tree.nodes[0]];
+		pcb.pid = (uint32_t)k;
+		if (pcb.next_burst_count)
+		{
+			memcpy(merged->bursts + pool_used, pcb.next_bursts, pcb.next_burst_count * sizeof(uint32_t));
+			pcb.next_bursts = merged->bursts + pool_used;
+			pool_used += pcb.next_burst_count;
+		}
+		ok = dyn_array_push_back(merged->pcbs, &pcb);
+		loser_tree_advance(&tree);
+	}
+
+	free(tree.heads);
+	free(tree.ends);
+	free(tree.nodes);
+	return ok;
+}
+
+PcbWorkload_t *load_pcb_shards(const char *const *paths, const size_t count, size_t threads)
+{
+	if (!paths || count == 0)
+	{
+		return NULL;
+	}
+
+	shard_load_t load;
+	load.paths = paths;
+	load.count = count;
+	load.shards = (PcbWorkload_t **)calloc(count, sizeof(PcbWorkload_t *));
+	atomic_init(&load.next, 0);
+	atomic_init(&load.failed, false);
+	PcbWorkload_t *merged = (PcbWorkload_t *)calloc(1, sizeof(PcbWorkload_t));
+	if (!load.shards || !merged)
+	{
+		free(load.shards);
+		free(merged);
+		return NULL;
+	}
+
+	if (threads == 0)
+	{
+		const long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 0 ? (size_t)online : 1;
+	}
+	if (threads > count)
+	{
+		threads = count;
+	}
+
+	// The calling thread is one of the workers
+	pthread_t *workers = threads > 1 ? (pthread_t *)malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+	size_t started = 0;
+	while (workers && started < threads - 1 && pthread_create(&workers[started], NULL, shard_worker, &load) == 0)
+	{
+		++started;
+	}
+	shard_worker(&load);
+	for (size_t i = 0; i < started; ++i)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+
+	bool ok = !atomic_load(&load.failed) && merge_shards(load.shards, count, merged);
+	for (size_t i = 0; i < count; ++i)
+	{
+		pcb_workload_destroy(load.shards[i]);
+	}
+	free(load.shards);
+	if (!ok)
+	{
+		pcb_workload_destroy(merged);
+		return NULL;
+	}
+	return merged;
+}
@@ -0,0 +1,423 @@
+// mkstemp, pread and unlink are POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "index_heap.h"
+#include "op_count.h"
+#include "pcb_stream.h"
+#include "scheduler.h"
+
+// PCBs read ahead from each run being merged, and buffered before a merge pass writes them out
+#define RUN_BUFFER_PCBS 1024
+
+#define PCB_SIZE sizeof(ProcessControlBlock_t)
+
+// A sorted run, as a byte range of the temporary file
+typedef struct
+{
+	uint64_t begin;
+	uint64_t end;
+} run_span_t;
+
+// Read position in a run while it is merged
+typedef struct
+{
+	uint64_t next;			// file offset of the first PCB not yet in buffer
+	uint64_t end;
+	size_t offset;			// the run's head is buffer[offset]
+	size_t length;
+	ProcessControlBlock_t buffer[RUN_BUFFER_PCBS];
+} run_cursor_t;
+
+typedef struct
+{
+	int fd;
+	run_cursor_t *cursors;
+	index_heap_t *heap;		// cursors with PCBs left, the earliest head on top
+	bool failed;
+} run_merge_t;
+
+struct pcb_stream
+{
+	uint64_t count;
+	bool has_deadlines;
+	bool failed;
+	dyn_array_t *memory;			// the sorted file if it fit in one run, else NULL
+	size_t memory_next;
+	run_merge_t merge;				// the final merge otherwise
+};
+
+// Ties go to the earlier record so the order matches a stable sort of the loaded file
+static bool pcb_earlier(const ProcessControlBlock_t *a, const ProcessControlBlock_t *b)
+{
+	return a->arrival < b->arrival || (a->arrival == b->arrival && a->pid < b->pid);
+}
+
+static int compare_arrival_then_pid(const void *a, const void *b)
+{
+	const ProcessControlBlock_t *x = (const ProcessControlBlock_t *)a;
+	const ProcessControlBlock_t *y = (const ProcessControlBlock_t *)b;
+	return pcb_earlier(x, y) ? -1 : pcb_earlier(y, x) ? 1 : 0;
+}
+
+// Creates an anonymous temporary file in dir, unlinked right away so only the descriptor keeps it
+static int open_temp(const char *dir)
+{
+	if (!dir)
+	{
+		dir = getenv("TMPDIR");
+		dir = dir && *dir ? dir : "/tmp";
+	}
+
+	static const char name[] = "/pcb_run_XXXXXX";
+	const size_t length = strlen(dir);
+	char *path = malloc(length + sizeof(name));
+	if (!path)
+	{
+		return -1;
+	}
+	memcpy(path, dir, length);
+	memcpy(path + length, name, sizeof(name));
+
+	const int fd = mkstemp(path);
+	if (fd != -1)
+	{
+		unlink(path);
+	}
+	free(path);
+	return fd;
+}
+
+static bool write_all(const int fd, const void *src, size_t count)
+{
+	const uint8_t *in = (const uint8_t *)src;
+	while (count > 0)
+	{
+		const ssize_t put = write(fd, in, count);
+		if (put <= 0)
+		{
+			return false;
+		}
+		in += put;
+		count -= (size_t)put;
+	}
+	return true;
+}
+
+// Refills the cursor's buffer from the file
+// \return false once the run is used up or for an error, which sets failed
+static bool cursor_fill(run_cursor_t *cursor, const int fd, bool *failed)
+{
+	const uint64_t left = (cursor->end - cursor->next) / PCB_SIZE;
+	const size_t want = left < RUN_BUFFER_PCBS ? (size_t)left : RUN_BUFFER_PCBS;
+	size_t got = 0;
+	while (got < want * PCB_SIZE)
+	{
+		OP_COUNT(OP_READ_CALLS);
+		const ssize_t chunk = pread(fd, (uint8_t *)cursor->buffer + got, want * PCB_SIZE - got,
+									(off_t)(cursor->next + got));
+		if (chunk <= 0)
+		{
+			*failed = true;
+			return false;
+		}
+		got += (size_t)chunk;
+	}
+	cursor->next += got;
+	cursor->offset = 0;
+	cursor->length = want;
+	return want > 0;
+}
+
+static bool cursor_before(const size_t a, const size_t b, void *context)
+{
+	const run_cursor_t *cursors = ((const run_merge_t *)context)->cursors;
+	return pcb_earlier(&cursors[a].buffer[cursors[a].offset], &cursors[b].buffer[cursors[b].offset]);
+}
+
+// Starts merging count runs of fd
+static bool merge_open(run_merge_t *merge, const int fd, const run_span_t *spans, const size_t count)
+{
+	merge->fd = fd;
+	merge->failed = false;
+	merge->cursors = (run_cursor_t *)malloc((count ? count : 1) * sizeof(run_cursor_t));
+	merge->heap = index_heap_create(count, cursor_before, merge);
+	if (!merge->cursors || !merge->heap)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		merge->cursors[i].next = spans[i].begin;
+		merge->cursors[i].end = spans[i].end;
+		if (cursor_fill(&merge->cursors[i], fd, &merge->failed) && !index_heap_push(merge->heap, i))
+		{
+			return false;
+		}
+	}
+	return !merge->failed;
+}
+
+// Takes the earliest head of all runs
+static bool merge_next(run_merge_t *merge, ProcessControlBlock_t *pcb)
+{
+	size_t top;
+	if (merge->failed || !index_heap_peek(merge->heap, &top))
+	{
+		return false;
+	}
+
+	run_cursor_t *cursor = &merge->cursors[top];
+	*pcb = cursor->buffer[cursor->offset];
+	if (++cursor->offset < cursor->length || cursor_fill(cursor, merge->fd, &merge->failed))
+	{
+		index_heap_update(merge->heap, top);
+	}
+	else
+	{
+		index_heap_remove(merge->heap, top);
+	}
+	return !merge->failed;
+}
+
+// Frees the merge state, the file stays open
+static void merge_close(run_merge_t *merge)
+{
+	index_heap_destroy(merge->heap);
+	free(merge->cursors);
+	merge->heap = NULL;
+	merge->cursors = NULL;
+}
+
+// Merges every PCB_STREAM_FAN_IN runs of *fd into one run of a new temporary file, which replaces *fd
+static bool merge_pass(int *fd, run_span_t *spans, size_t *count, const char *temp_dir)
+{
+	const int out = open_temp(temp_dir);
+	ProcessControlBlock_t *buffer = (ProcessControlBlock_t *)malloc(RUN_BUFFER_PCBS * PCB_SIZE);
+	bool ok = out != -1 && buffer;
+
+	uint64_t offset = 0;
+	size_t merged = 0;
+	for (size_t first = 0; ok && first < *count; first += PCB_STREAM_FAN_IN)
+	{
+		const size_t group = *count - first < PCB_STREAM_FAN_IN ? *count - first : PCB_STREAM_FAN_IN;
+		run_merge_t merge;
+		ok = merge_open(&merge, *fd, spans + first, group);
+
+		const uint64_t begin = offset;
+		size_t length = 0;
+		while (ok && merge_next(&merge, &buffer[length]))
+		{
+			if (++length == RUN_BUFFER_PCBS)
+			{
+				ok = write_all(out, buffer, length * PCB_SIZE);
+				offset += length * PCB_SIZE;
+				length = 0;
+			}
+		}
+		ok = ok && !merge.failed && write_all(out, buffer, length * PCB_SIZE);
+		offset += length * PCB_SIZE;
+		merge_close(&merge);
+
+		// Runs only ever shrink in number, so the merged spans overwrite ones already consumed
+		spans[merged].begin = begin;
+		spans[merged].end = offset;
+		++merged;
+	}
+
+	free(buffer);
+	if (!ok)
+	{
+		if (out != -1)
+		{
+			close(out);
+		}
+		return false;
+	}
+	close(*fd);
+	*fd = out;
+	*count = merged;
+	return true;
+}
+
+// Reads the file in runs of run_pcbs, sorts them and writes them to *fd, or keeps the one run in memory
+static bool write_runs(PcbStream_t *stream, PcbReader_t *reader, const size_t run_pcbs, const char *temp_dir,
+					   int *fd, run_span_t **spans, size_t *count)
+{
+	const size_t buffer_pcbs = stream->count < run_pcbs ? (size_t)stream->count : run_pcbs;
+	dyn_array_t *buffer = dyn_array_create(buffer_pcbs ? buffer_pcbs : 1, PCB_SIZE, NULL);
+	const uint64_t run_count = stream->count / run_pcbs + (stream->count % run_pcbs != 0);
+	*spans = run_count > 1 ? (run_span_t *)malloc((size_t)run_count * sizeof(run_span_t)) : NULL;
+	bool ok = buffer && (run_count <= 1 || *spans);
+
+	uint64_t read = 0;
+	uint64_t offset = 0;
+	while (ok && read < stream->count)
+	{
+		dyn_array_clear(buffer);
+		while (ok && dyn_array_size(buffer) < buffer_pcbs && read < stream->count)
+		{
+			ProcessControlBlock_t pcb;
+			ok = pcb_reader_next(reader, &pcb) && dyn_array_push_back(buffer, &pcb);
+			stream->has_deadlines = stream->has_deadlines || (ok && pcb.deadline != PCB_NO_DEADLINE);
+			++read;
+		}
+		// Dumps are usually in arrival order already, which the adaptive sort takes in one pass
+		if (!ok || !dyn_array_sort(buffer, compare_arrival_then_pid))
+		{
+			ok = false;
+			break;
+		}
+
+		if (run_count <= 1)
+		{
+			stream->memory = buffer;
+			buffer = NULL;
+			break;
+		}
+		if (*fd == -1)
+		{
+			*fd = open_temp(temp_dir);
+		}
+		const size_t length = dyn_array_size(buffer);
+		ok = *fd != -1 && write_all(*fd, dyn_array_export(buffer), length * PCB_SIZE);
+		(*spans)[*count].begin = offset;
+		offset += length * PCB_SIZE;
+		(*spans)[*count].end = offset;
+		++*count;
+	}
+	dyn_array_destroy(buffer);
+	return ok;
+}
+
+PcbStream_t *pcb_stream_open(const char *input_file, const size_t run_pcbs, const char *temp_dir)
+{
+	if (!input_file || run_pcbs < 2)
+	{
+		return NULL;
+	}
+	PcbReader_t *reader = pcb_reader_open(input_file);
+	PcbStream_t *stream = (PcbStream_t *)calloc(1, sizeof(PcbStream_t));
+	if (!reader || !stream)
+	{
+		pcb_reader_close(reader);
+		free(stream);
+		return NULL;
+	}
+	stream->count = pcb_reader_count(reader);
+	stream->merge.fd = -1;
+
+	int fd = -1;
+	run_span_t *spans = NULL;
+	size_t count = 0;
+	bool ok = write_runs(stream, reader, run_pcbs, temp_dir, &fd, &spans, &count);
+	pcb_reader_close(reader);
+
+	while (ok && count > PCB_STREAM_FAN_IN)
+	{
+		ok = merge_pass(&fd, spans, &count, temp_dir);
+	}
+	if (ok && !stream->memory)
+	{
+		// The last runs are merged as they are read
+		ok = merge_open(&stream->merge, fd, spans, count);
+		fd = -1;
+	}
+	free(spans);
+	if (fd != -1)
+	{
+		close(fd);
+	}
+	if (!ok)
+	{
+		pcb_stream_close(stream);
+		return NULL;
+	}
+	return stream;
+}
+
+bool pcb_stream_next(PcbStream_t *stream, ProcessControlBlock_t *pcb)
+{
+	if (!stream || !pcb || stream->failed)
+	{
+		return false;
+	}
+	if (stream->memory)
+	{
+		if (stream->memory_next == dyn_array_size(stream->memory))
+		{
+			return false;
+		}
+		*pcb = ((const ProcessControlBlock_t *)dyn_array_export(stream->memory))[stream->memory_next++];
+		return true;
+	}
+	if (!stream->merge.heap || !merge_next(&stream->merge, pcb))
+	{
+		stream->failed = stream->merge.failed;
+		return false;
+	}
+	return true;
+}
+
+bool pcb_stream_failed(const PcbStream_t *stream)
+{
+	return !stream || stream->failed;
+}
+
+uint64_t pcb_stream_count(const PcbStream_t *stream)
+{
+	return stream ? stream->count : 0;
+}
+
+bool pcb_stream_has_deadlines(const PcbStream_t *stream)
+{
+	return stream && stream->has_deadlines;
+}
+
+void pcb_stream_close(PcbStream_t *stream)
+{
+	if (stream)
+	{
+		merge_close(&stream->merge);
+		if (stream->merge.fd != -1)
+		{
+			close(stream->merge.fd);
+		}
+		dyn_array_destroy(stream->memory);
+		free(stream);
+	}
+}
+
+bool pcb_stream_schedule(PcbStream_t *stream, const ScheduleConfig_t *config, ScheduleResult_t *result)
+{
+	if (!stream || !config || !result)
+	{
+		return false;
+	}
+
+	Scheduler_t *sched = sched_create(config);
+	ScheduleMetrics_t metrics;
+	bool ok = sched && sched_snapshot_metrics(sched, &metrics);
+	ProcessControlBlock_t pcb;
+	while (ok && pcb_stream_next(stream, &pcb))
+	{
+		// Everything before the arrival is simulated before it is submitted, so completed PCBs free their
+		// slots before later ones take them
+		const uint64_t until = pcb.arrival > 0 ? pcb.arrival - 1 : 0;
+		ok = (until <= metrics.clock || sched_advance_to(sched, until)) && sched_submit(sched, &pcb) &&
+			sched_snapshot_metrics(sched, &metrics);
+	}
+
+	ok = ok && !stream->failed && sched_drain(sched) && sched_snapshot_metrics(sched, &metrics);
+	if (ok)
+	{
+		*result = metrics.result;
+	}
+	sched_destroy(sched);
+	return ok;
+}
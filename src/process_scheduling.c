@@ -1,509 +1,706 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "dyn_array.h"
+#include "op_count.h"
 #include "processing_scheduling.h"
+#include "scheduler.h"
 
 
 // You might find this handy.  I put it around unused parameters, but you should
 // remove it before you submit. Just allows things to compile initially.
 #define UNUSED(x) (void)(x)
 
-// private function
-void virtual_cpu(ProcessControlBlock_t *process_control_block) 
-{
-	// decrement the burst time of the pcb
-	--process_control_block->remaining_burst_time;
-}
+// Buffered access to PCB files: one read()/write() per PCB_IO_BUFFER_SIZE bytes
+// instead of one syscall per field, which dominated load time on large files
+#define PCB_IO_BUFFER_SIZE (1 << 16)
 
-// Comparator for sorting PCBs by arrival time (ascending)
-static int compare_arrival_time(const void *a, const void *b)
-{
-	const ProcessControlBlock_t *pcb_a = (const ProcessControlBlock_t *)a;
-	const ProcessControlBlock_t *pcb_b = (const ProcessControlBlock_t *)b;
-
-	if (pcb_a->arrival < pcb_b->arrival) return -1;
-	if (pcb_a->arrival > pcb_b->arrival) return 1;
-	return 0;
-}
+#define PCB_V1_HEADER_SIZE sizeof(uint32_t)
+#define PCB_V1_RECORD_SIZE (3 * sizeof(uint32_t))
+#define PCB_V2_HEADER_SIZE (2 * sizeof(uint32_t) + sizeof(uint64_t))
+#define PCB_V2_RECORD_SIZE (2 * sizeof(uint32_t) + sizeof(uint64_t))
+#define PCB_DEADLINE_COLUMN_SIZE sizeof(uint64_t)
+#define PCB_BURST_OFFSET_SIZE sizeof(uint64_t)
 
-static int compare_remaining_burst_time(const void *a, const void *b)
+typedef struct
 {
-	const ProcessControlBlock_t *pcb_a = (const ProcessControlBlock_t *)a;
-	const ProcessControlBlock_t *pcb_b = (const ProcessControlBlock_t *)b;
-
-	if (pcb_a->remaining_burst_time < pcb_b->remaining_burst_time) return -1;
-	if (pcb_a->remaining_burst_time > pcb_b->remaining_burst_time) return 1;
-	return 0;
-}
-
-static int compare_priority(const void *a, const void *b)
+	int fd;
+	size_t offset;
+	size_t length;
+	uint8_t buffer[PCB_IO_BUFFER_SIZE];
+} pcb_io_t;
+
+// Copies the next count bytes of the file into dst, refilling the buffer as needed
+static bool pcb_io_read(pcb_io_t *io, void *dst, size_t count)
 {
-	const ProcessControlBlock_t *pcb_a = (const ProcessControlBlock_t *)a;
-	const ProcessControlBlock_t *pcb_b = (const ProcessControlBlock_t *)b;
+	uint8_t *out = (uint8_t *)dst;
+
+	while (count > 0)
+	{
+		if (io->offset == io->length)
+		{
+			OP_COUNT(OP_READ_CALLS);
+			ssize_t got = read(io->fd, io->buffer, PCB_IO_BUFFER_SIZE);
+			if (got <= 0)
+			{
+				return false;
+			}
+			io->offset = 0;
+			io->length = (size_t)got;
+		}
 
-	if (pcb_a->priority < pcb_b->priority) return -1;
-	if (pcb_a->priority > pcb_b->priority) return 1;
-	return 0;
+		size_t chunk = io->length - io->offset;
+		if (chunk > count)
+		{
+			chunk = count;
+		}
+		memcpy(out, io->buffer + io->offset, chunk);
+		io->offset += chunk;
+		out += chunk;
+		count -= chunk;
+	}
+	return true;
 }
 
-// If two processes have the same arrival, check their remaining burst time
-static int compare_arrival_with_burst_fallback(const void *a, const void*b) 
+// Writes out whatever is buffered
+static bool pcb_io_flush(pcb_io_t *io)
 {
-	const int arrival_comp = compare_arrival_time(a, b);
-
-	if (arrival_comp != 0)
-		return arrival_comp;
-
-	return compare_remaining_burst_time(a, b);
+	size_t written = 0;
+	while (written < io->length)
+	{
+		ssize_t put = write(io->fd, io->buffer + written, io->length - written);
+		if (put <= 0)
+		{
+			return false;
+		}
+		written += (size_t)put;
+	}
+	io->length = 0;
+	return true;
 }
 
-// If two processes have the same arrival, check their priority
-static int compare_arrival_with_priority_fallback(const void *a, const void*b) 
+// Appends count bytes from src to the buffer, flushing it when full
+static bool pcb_io_write(pcb_io_t *io, const void *src, size_t count)
 {
-	const int arrival_comp = compare_arrival_time(a, b);
+	const uint8_t *in = (const uint8_t *)src;
 
-	if (arrival_comp != 0)
-		return arrival_comp;
+	while (count > 0)
+	{
+		if (io->length == PCB_IO_BUFFER_SIZE && !pcb_io_flush(io))
+		{
+			return false;
+		}
 
-	return compare_priority(a, b);
+		size_t chunk = PCB_IO_BUFFER_SIZE - io->length;
+		if (chunk > count)
+		{
+			chunk = count;
+		}
+		memcpy(io->buffer + io->length, in, chunk);
+		io->length += chunk;
+		in += chunk;
+		count -= chunk;
+	}
+	return true;
 }
 
-bool first_come_first_serve(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+// What a PCB file's header says about the records that follow it
+typedef struct
 {
-	// Parameter validation
-	if (!ready_queue || !result)
-	{
-		return false;
-	}
+	uint64_t count;			// PCBs in the file
+	uint64_t file_size;
+	uint64_t header_size;
+	uint64_t record_size;	// bytes per PCB, its burst offset included
+	bool v2;
+	bool has_deadline;
+	bool has_bursts;
+} pcb_header_t;
+
+// Reads and checks the header, leaving io at the first record
+// Files with IO bursts are rejected unless allow_bursts is set.
+static bool read_pcb_header(pcb_io_t *io, const bool allow_bursts, pcb_header_t *header)
+{
+	struct stat file_stat;
+	uint32_t magic;
+	uint32_t flags = 0;
 
-	size_t num_processes = dyn_array_size(ready_queue);
-	if (num_processes == 0)
+	if (fstat(io->fd, &file_stat) != 0 || !pcb_io_read(io, &magic, sizeof(uint32_t)))
 	{
 		return false;
 	}
 
-	// Sort the ready queue by arrival time to ensure FCFS order
-	dyn_array_sort(ready_queue, compare_arrival_time);
-
-	unsigned long clock = 0;
-	float total_wait_time = 0;
-	float total_turnaround_time = 0;
-
-	for (size_t i = 0; i < num_processes; i++)
+	header->v2 = magic == PCB_FILE_V2_MAGIC;
+	if (header->v2)
 	{
-		ProcessControlBlock_t *pcb = (ProcessControlBlock_t *)dyn_array_at(ready_queue, i);
-		if (!pcb)
+		if (!pcb_io_read(io, &flags, sizeof(uint32_t)) ||
+				(flags & ~(PCB_FILE_FLAG_DEADLINE | PCB_FILE_FLAG_BURSTS)) != 0 ||
+				((flags & PCB_FILE_FLAG_BURSTS) && !allow_bursts) ||
+				!pcb_io_read(io, &header->count, sizeof(uint64_t)))
 		{
 			return false;
 		}
+	}
+	else
+	{
+		header->count = magic;
+	}
 
-		// If the CPU is idle and the process hasn't arrived yet, advance the clock
-		if (clock < pcb->arrival)
-		{
-			clock = pcb->arrival;
-		}
-
-		// Calculate wait time: time spent waiting before getting the CPU
-		unsigned long wait_time = clock - pcb->arrival;
-		total_wait_time += (float)wait_time;
-
-		// Mark the process as started
-		pcb->started = true;
+	// Reject counts the file can't possibly hold before trying to allocate for them
+	header->has_deadline = (flags & PCB_FILE_FLAG_DEADLINE) != 0;
+	header->has_bursts = (flags & PCB_FILE_FLAG_BURSTS) != 0;
+	header->file_size = (uint64_t)file_stat.st_size;
+	header->header_size = header->v2 ? PCB_V2_HEADER_SIZE : PCB_V1_HEADER_SIZE;
+	header->record_size = header->v2 ? PCB_V2_RECORD_SIZE + (header->has_deadline ? PCB_DEADLINE_COLUMN_SIZE : 0) +
+		(header->has_bursts ? PCB_BURST_OFFSET_SIZE : 0) : PCB_V1_RECORD_SIZE;
+	const uint64_t trailer_size = header->has_bursts ? PCB_BURST_OFFSET_SIZE : 0;
+	return header->file_size >= header->header_size + trailer_size &&
+		header->count <= (header->file_size - header->header_size - trailer_size) / header->record_size &&
+		header->count <= SIZE_MAX;
+}
 
-		// Run the process on the virtual CPU until its burst is complete
-		while (pcb->remaining_burst_time > 0)
-		{
-			virtual_cpu(pcb);
-			clock++;
-		}
+// Reads the next record, representing the next process control block, into block
+// pid is the record's index, the IO bursts (if any) come after all the records and are left to the caller.
+static bool read_pcb_record(pcb_io_t *io, const pcb_header_t *header, const uint64_t index,
+							ProcessControlBlock_t *block)
+{
+	uint32_t burst_time, priority_val;
+	uint64_t arrival_time;
+	uint64_t deadline = PCB_NO_DEADLINE;
+	bool ok;
 
-		// Calculate turnaround time: completion time - arrival time
-		unsigned long turnaround_time = clock - pcb->arrival;
-		total_turnaround_time += (float)turnaround_time;
+	if (header->v2)
+	{
+		ok = pcb_io_read(io, &burst_time, sizeof(uint32_t)) &&
+			pcb_io_read(io, &priority_val, sizeof(uint32_t)) &&
+			pcb_io_read(io, &arrival_time, sizeof(uint64_t)) &&
+			(!header->has_deadline || pcb_io_read(io, &deadline, sizeof(uint64_t)));
+	}
+	else
+	{
+		uint32_t arrival_v1;
+		ok = pcb_io_read(io, &burst_time, sizeof(uint32_t)) &&
+			pcb_io_read(io, &priority_val, sizeof(uint32_t)) &&
+			pcb_io_read(io, &arrival_v1, sizeof(uint32_t));
+		arrival_time = arrival_v1;
 	}
+	OP_COUNT(OP_RECORDS_DECODED);
+
+	block->remaining_burst_time = burst_time;
+	block->priority = priority_val;
+	block->arrival = arrival_time;
+	block->started = false;
+	block->pid = (uint32_t)index;
+	block->deadline = deadline;
+	block->next_bursts = NULL;
+	block->next_burst_count = 0;
+	return ok;
+}
 
-	// Fill in the result structure
-	result->average_waiting_time = total_wait_time / (float)num_processes;
-	result->average_turnaround_time = total_turnaround_time / (float)num_processes;
-	result->total_run_time = clock;
+// Opens input_file for buffered reading, NULL on error
+static pcb_io_t *pcb_io_open(const char *input_file)
+{
+	pcb_io_t *io = malloc(sizeof(pcb_io_t));
+	if (!io)
+	{
+		return NULL;
+	}
+	io->offset = 0;
+	io->length = 0;
 
-	return true;
+	io->fd = open(input_file, O_RDONLY);
+	if (io->fd == -1) 
+	{
+		free(io);
+		return NULL;
+	}
+	return io;
 }
 
-bool shortest_job_first(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+// Shared by both loaders. Files with IO bursts are only accepted when bursts is given, which then
+// receives the single allocation every PCB's next_bursts point into.
+static dyn_array_t *load_pcbs(const char *input_file, uint32_t **bursts)
 {
-	if (!ready_queue || !result)
+	if (!input_file) 
 	{
-		return false;
+		return NULL;
 	}
 
-	size_t num_processes = dyn_array_size(ready_queue);
-	if (num_processes == 0)
+	pcb_io_t *io = pcb_io_open(input_file);
+	if (!io)
 	{
-		return false;
+		return NULL;
 	}
 
-	unsigned long clock = 0;
-	float total_wait_time = 0;
-	float total_turnaround_time = 0;
+	dyn_array_t *array = NULL;
+	uint32_t *pool = NULL;
+	pcb_header_t header;
 
-	size_t completed = 0;
+	if (!read_pcb_header(io, bursts != NULL, &header))
+	{
+		goto done;
+	}
+	const uint64_t num_pcb = header.count;
 
-	dyn_array_sort(ready_queue, compare_remaining_burst_time);
-	while (completed < num_processes) 
+	// No destructor needed: elements are stored inline in the dyn_array
+	array = dyn_array_create((size_t)num_pcb, sizeof(ProcessControlBlock_t), NULL);
+	if (!array)
 	{
-		ProcessControlBlock_t *pcb = NULL;
+		goto done;
+	}
 
-		// In case no PCB have arrived, also keep track of 
-		// the soonest arrival
-		ProcessControlBlock_t *soonest_arrival = NULL;
+	while (dyn_array_size(array) < (size_t)num_pcb) 
+	{
+		// Use a stack-allocated PCB; push_back will copy it into the array
+		ProcessControlBlock_t block;
+		if (!read_pcb_record(io, &header, dyn_array_size(array), &block) || !dyn_array_push_back(array, &block)) 
+		{
+			goto fail;
+		}
+	}
 
-		// Search for an arrived process in the queue sorted by burst
-		for (size_t i = 0; i < dyn_array_size(ready_queue); ++i) 
+	if (header.has_bursts)
+	{
+		// Whatever follows the offset index is the burst pool, sized from the file so it is one allocation
+		const uint64_t index_end = header.header_size + num_pcb * (header.record_size - PCB_BURST_OFFSET_SIZE) +
+			(num_pcb + 1) * PCB_BURST_OFFSET_SIZE;
+		const uint64_t pool_entries = (header.file_size - index_end) / sizeof(uint32_t);
+		if (pool_entries > SIZE_MAX / sizeof(uint32_t))
 		{
-			ProcessControlBlock_t *p = (ProcessControlBlock_t *)dyn_array_at(ready_queue, i);
-			if (!p)
-			{
-				return false;
-			}
+			goto fail;
+		}
+		pool = malloc(pool_entries ? (size_t)pool_entries * sizeof(uint32_t) : 1);
+		if (!pool)
+		{
+			goto fail;
+		}
 
-			// If this process has arrived, extract remove it from the queue
-			// and stop searching
-			if (p->arrival <= clock && p->remaining_burst_time > 0)
+		uint64_t offset;
+		if (!pcb_io_read(io, &offset, sizeof(uint64_t)) || offset != 0)
+		{
+			goto fail;
+		}
+		for (size_t i = 0; i < (size_t)num_pcb; ++i)
+		{
+			uint64_t next_offset;
+			if (!pcb_io_read(io, &next_offset, sizeof(uint64_t)) || next_offset < offset ||
+					next_offset > pool_entries || (next_offset - offset) % 2 != 0 || next_offset - offset > UINT32_MAX)
 			{
-				pcb = p;
-				break;
+				goto fail;
 			}
 
-			if (!soonest_arrival || compare_arrival_with_burst_fallback(soonest_arrival, p) < 0)
-			{
-				soonest_arrival = p;
-			}
+			ProcessControlBlock_t *block = (ProcessControlBlock_t *)dyn_array_at(array, i);
+			block->next_burst_count = (uint32_t)(next_offset - offset);
+			block->next_bursts = block->next_burst_count ? pool + offset : NULL;
+			offset = next_offset;
 		}
 
-		if (pcb == NULL) // No arrived PCBs, take the soonest arriving process
+		if (offset != pool_entries || !pcb_io_read(io, pool, (size_t)pool_entries * sizeof(uint32_t)))
 		{
-			pcb = soonest_arrival;
-			clock = pcb->arrival;
+			goto fail;
 		}
+		*bursts = pool;
+		pool = NULL;
+	}
+	else if (bursts)
+	{
+		*bursts = NULL;
+	}
+	goto done;
 
-		unsigned long wait_time = clock - pcb->arrival;
-		total_wait_time += (float)wait_time;
+fail:
+	dyn_array_destroy(array);
+	array = NULL;
 
-		pcb->started = true;
-		while (pcb->remaining_burst_time > 0)
-		{
-			virtual_cpu(pcb);
-			clock++;
-		}
-		completed++;
+done:
+	free(pool);
+	close(io->fd);
+	free(io);
+	return array;
+}
+
+struct pcb_reader
+{
+	pcb_header_t header;
+	uint64_t next;			// index of the next record
+	pcb_io_t *io;
+};
 
-		unsigned long turnaround_time = clock - pcb->arrival;
-		total_turnaround_time += (float)turnaround_time;
+PcbReader_t *pcb_reader_open(const char *input_file)
+{
+	if (!input_file)
+	{
+		return NULL;
 	}
 
-	result->average_waiting_time = total_wait_time / (float)num_processes;
-	result->average_turnaround_time = total_turnaround_time / (float)num_processes;
-	result->total_run_time = clock;
+	PcbReader_t *reader = malloc(sizeof(PcbReader_t));
+	if (!reader)
+	{
+		return NULL;
+	}
+	reader->next = 0;
+	reader->io = pcb_io_open(input_file);
+	if (!reader->io)
+	{
+		free(reader);
+		return NULL;
+	}
+	if (!read_pcb_header(reader->io, false, &reader->header))
+	{
+		pcb_reader_close(reader);
+		return NULL;
+	}
+	return reader;
+}
 
-	return true;
+uint64_t pcb_reader_count(const PcbReader_t *reader)
+{
+	return reader ? reader->header.count : 0;
 }
 
-bool priority(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+bool pcb_reader_next(PcbReader_t *reader, ProcessControlBlock_t *pcb)
 {
-	if (!ready_queue || !result)
+	if (!reader || !pcb || reader->next == reader->header.count ||
+			!read_pcb_record(reader->io, &reader->header, reader->next, pcb))
 	{
 		return false;
 	}
+	++reader->next;
+	return true;
+}
 
-	size_t num_processes = dyn_array_size(ready_queue);
-	if (num_processes == 0)
+void pcb_reader_close(PcbReader_t *reader)
+{
+	if (reader)
 	{
-		return false;
+		close(reader->io->fd);
+		free(reader->io);
+		free(reader);
 	}
+}
 
-	unsigned long clock = 0;
-	float total_wait_time = 0;
-	float total_turnaround_time = 0;
-
-	size_t completed = 0;
+dyn_array_t *load_process_control_blocks(const char *input_file) 
+{
+	return load_pcbs(input_file, NULL);
+}
 
-	dyn_array_sort(ready_queue, compare_priority);
-	while (completed < num_processes) 
+PcbWorkload_t *load_pcb_workload(const char *input_file)
+{
+	PcbWorkload_t *workload = malloc(sizeof(PcbWorkload_t));
+	if (!workload)
 	{
-		ProcessControlBlock_t *pcb = NULL;
-
-		// In case no PCB have arrived, also keep track of 
-		// the soonest arrival
-		ProcessControlBlock_t *soonest_arrival = NULL;
-
-		// Search for an arrived process in the queue sorted by priority
-		for (size_t i = 0; i < dyn_array_size(ready_queue); ++i) 
-		{
-			ProcessControlBlock_t *p = (ProcessControlBlock_t *)dyn_array_at(ready_queue, i);
-			if (!p)
-			{
-				return false;
-			}
-
-			// If this process has arrived, extract remove it from the queue
-			// and stop searching
-			if (p->arrival <= clock && p->remaining_burst_time > 0)
-			{
-				pcb = p;
-				break;
-			}
+		return NULL;
+	}
 
-			if (!soonest_arrival || compare_arrival_with_priority_fallback(soonest_arrival, p) < 0) 
-			{
-				soonest_arrival = p;
-			}
-		}
+	workload->pcbs = load_pcbs(input_file, &workload->bursts);
+	if (!workload->pcbs)
+	{
+		free(workload);
+		return NULL;
+	}
+	return workload;
+}
 
-		if (pcb == NULL) // No arrived PCBs, take the soonest arriving process
-		{
-			pcb = soonest_arrival;
-			clock = pcb->arrival;
-		}
+void pcb_workload_destroy(PcbWorkload_t *workload)
+{
+	if (workload)
+	{
+		dyn_array_destroy(workload->pcbs);
+		free(workload->bursts);
+		free(workload);
+	}
+}
 
-		unsigned long wait_time = clock - pcb->arrival;
-		total_wait_time += (float)wait_time;
+struct pcb_writer
+{
+	uint64_t count;			// PCBs appended
+	bool v1;
+	bool failed;
+	pcb_io_t *io;
+};
+
+// Writes the header for the PCBs appended so far
+static bool write_pcb_header(PcbWriter_t *writer)
+{
+	if (writer->v1)
+	{
+		const uint32_t count = (uint32_t)writer->count;
+		return pcb_io_write(writer->io, &count, sizeof(uint32_t));
+	}
+	const uint32_t magic = PCB_FILE_V2_MAGIC;
+	const uint32_t flags = 0;
+	return pcb_io_write(writer->io, &magic, sizeof(uint32_t)) && pcb_io_write(writer->io, &flags, sizeof(uint32_t)) &&
+		pcb_io_write(writer->io, &writer->count, sizeof(uint64_t));
+}
 
-		pcb->started = true;
-		while (pcb->remaining_burst_time > 0)
+PcbWriter_t *pcb_writer_open(const char *output_file, const bool v1)
+{
+	if (!output_file)
+	{
+		return NULL;
+	}
+	PcbWriter_t *writer = malloc(sizeof(PcbWriter_t));
+	pcb_io_t *io = malloc(sizeof(pcb_io_t));
+	if (!writer || !io)
+	{
+		free(writer);
+		free(io);
+		return NULL;
+	}
+	io->offset = 0;
+	io->length = 0;
+	io->fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	writer->count = 0;
+	writer->v1 = v1;
+	writer->failed = false;
+	writer->io = io;
+	if (io->fd == -1 || !write_pcb_header(writer))
+	{
+		if (io->fd != -1)
 		{
-			virtual_cpu(pcb);
-			clock++;
+			close(io->fd);
 		}
-		completed++;
-
-		unsigned long turnaround_time = clock - pcb->arrival;
-		total_turnaround_time += (float)turnaround_time;
+		free(io);
+		free(writer);
+		return NULL;
 	}
+	return writer;
+}
 
-	result->average_waiting_time = total_wait_time / (float)num_processes;
-	result->average_turnaround_time = total_turnaround_time / (float)num_processes;
-	result->total_run_time = clock;
+bool pcb_writer_append(PcbWriter_t *writer, const ProcessControlBlock_t *pcb)
+{
+	if (!writer || !pcb || writer->failed || pcb->deadline != PCB_NO_DEADLINE || pcb->next_burst_count > 0 ||
+			(writer->v1 && (pcb->arrival > UINT32_MAX || writer->count == UINT32_MAX)))
+	{
+		return false;
+	}
 
-	return true;
+	if (writer->v1)
+	{
+		const uint32_t arrival = (uint32_t)pcb->arrival;
+		writer->failed = !(pcb_io_write(writer->io, &pcb->remaining_burst_time, sizeof(uint32_t)) &&
+			pcb_io_write(writer->io, &pcb->priority, sizeof(uint32_t)) &&
+			pcb_io_write(writer->io, &arrival, sizeof(uint32_t)));
+	}
+	else
+	{
+		writer->failed = !(pcb_io_write(writer->io, &pcb->remaining_burst_time, sizeof(uint32_t)) &&
+			pcb_io_write(writer->io, &pcb->priority, sizeof(uint32_t)) &&
+			pcb_io_write(writer->io, &pcb->arrival, sizeof(uint64_t)));
+	}
+	writer->count += !writer->failed;
+	return !writer->failed;
 }
 
-bool round_robin(dyn_array_t *ready_queue, ScheduleResult_t *result, size_t quantum) 
+uint64_t pcb_writer_count(const PcbWriter_t *writer)
 {
-	if (!ready_queue || !result || quantum == 0)
-		return false;
+	return writer ? writer->count : 0;
+}
 
-	size_t n = dyn_array_size(ready_queue);
-	if (n == 0)
+bool pcb_writer_close(PcbWriter_t *writer)
+{
+	if (!writer)
+	{
 		return false;
+	}
 
-	unsigned long clock = 0;
-	size_t completed = 0;
-
-	float total_wait_time = 0;
-	float total_turnaround_time = 0;
+	// The count is only known now, so the header is written a second time over the placeholder.
+	// A v1 file can't hold exactly PCB_FILE_V2_MAGIC PCBs.
+	bool ok = !writer->failed && (!writer->v1 || writer->count != PCB_FILE_V2_MAGIC) && pcb_io_flush(writer->io) &&
+		lseek(writer->io->fd, 0, SEEK_SET) == 0 && write_pcb_header(writer) && pcb_io_flush(writer->io);
+	ok = (close(writer->io->fd) == 0) && ok;
+	free(writer->io);
+	free(writer);
+	return ok;
+}
 
-	while (completed < n)
+bool save_process_control_blocks(const char *output_file, const dyn_array_t *pcbs)
+{
+	if (!output_file || !pcbs)
 	{
-		bool progress_made = false;
+		return false;
+	}
 
-		for (size_t i = 0; i < n; i++)
+	// Pick the optional columns, a PCB ending on an IO burst can't be stored
+	const uint32_t magic = PCB_FILE_V2_MAGIC;
+	const uint64_t num_pcb = dyn_array_size(pcbs);
+	uint32_t flags = 0;
+	for (size_t i = 0; i < num_pcb; ++i)
+	{
+		const ProcessControlBlock_t *pcb = (const ProcessControlBlock_t *)dyn_array_at(pcbs, i);
+		if (pcb->deadline != PCB_NO_DEADLINE)
 		{
-			ProcessControlBlock_t* pcb = dyn_array_at(ready_queue, i);
-			if (!pcb)
-				return false;
-
-			if (pcb->remaining_burst_time > 0 && pcb->arrival <= clock)
+			flags |= PCB_FILE_FLAG_DEADLINE;
+		}
+		if (pcb->next_burst_count > 0)
+		{
+			if (pcb->next_burst_count % 2 != 0 || !pcb->next_bursts)
 			{
-				progress_made = true;
-
-				if (!pcb->started)
-				{
-					total_wait_time += (float)(clock - pcb->arrival);
-					pcb->started = true;
-				}
-
-				size_t time_slice = 0;
-
-				while (time_slice < quantum && pcb->remaining_burst_time > 0)
-				{
-					virtual_cpu(pcb);
-					clock++;
-					time_slice++;
-				}
-
-				if (pcb->remaining_burst_time == 0)
-				{
-					completed++;
-					total_turnaround_time += (float)(clock - pcb->arrival);
-				}
+				return false;
 			}
+			flags |= PCB_FILE_FLAG_BURSTS;
 		}
-
-		// If no process was ready, advance clock
-		if (!progress_made)
-			clock++;
 	}
 
-	result->average_waiting_time = total_wait_time / (float)n;
-	result->average_turnaround_time = total_turnaround_time / (float)n;
-	result->total_run_time = clock;
-
-	return true;
-}
-
-dyn_array_t *load_process_control_blocks(const char *input_file) 
-{
-	if (!input_file) 
+	pcb_io_t *io = malloc(sizeof(pcb_io_t));
+	if (!io)
 	{
-		return NULL;
+		return false;
 	}
+	io->offset = 0;
+	io->length = 0;
 
-	int fd = open(input_file, O_RDONLY);
-	if (fd == -1) 
+	io->fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (io->fd == -1)
 	{
-		return NULL;
+		free(io);
+		return false;
 	}
 
-	uint32_t num_pcb;
-	if (read(fd, &num_pcb, sizeof(uint32_t)) != sizeof(uint32_t)) 
-	{
-		close(fd);
-		return NULL;
-	}
+	bool ok = pcb_io_write(io, &magic, sizeof(uint32_t)) &&
+		pcb_io_write(io, &flags, sizeof(uint32_t)) &&
+		pcb_io_write(io, &num_pcb, sizeof(uint64_t));
 
-	// No destructor needed: elements are stored inline in the dyn_array
-	dyn_array_t *array = dyn_array_create((size_t)num_pcb, sizeof(ProcessControlBlock_t), NULL);
-	if (!array)
+	for (size_t i = 0; ok && i < num_pcb; ++i)
 	{
-		close(fd);
-		return NULL;
+		const ProcessControlBlock_t *pcb = (const ProcessControlBlock_t *)dyn_array_at(pcbs, i);
+		ok = pcb_io_write(io, &pcb->remaining_burst_time, sizeof(uint32_t)) &&
+			pcb_io_write(io, &pcb->priority, sizeof(uint32_t)) &&
+			pcb_io_write(io, &pcb->arrival, sizeof(uint64_t)) &&
+			(!(flags & PCB_FILE_FLAG_DEADLINE) || pcb_io_write(io, &pcb->deadline, sizeof(uint64_t)));
 	}
 
-	while (dyn_array_size(array) < (size_t)num_pcb) 
+	if (flags & PCB_FILE_FLAG_BURSTS)
 	{
-		uint32_t burst_time, priority_val, arrival_time;
-
-		// Read the next triple, representing the next process control block
-		if (read(fd, &burst_time, sizeof(uint32_t)) == sizeof(uint32_t) && 
-				read(fd, &priority_val, sizeof(uint32_t)) == sizeof(uint32_t) &&
-				read(fd, &arrival_time, sizeof(uint32_t)) == sizeof(uint32_t))
+		uint64_t offset = 0;
+		ok = ok && pcb_io_write(io, &offset, sizeof(uint64_t));
+		for (size_t i = 0; ok && i < num_pcb; ++i)
 		{
-			// Use a stack-allocated PCB; push_back will copy it into the array
-			ProcessControlBlock_t block;
-			block.remaining_burst_time = burst_time;
-			block.priority = priority_val;
-			block.arrival = arrival_time;
-			block.started = false;
-
-			if (!dyn_array_push_back(array, &block)) 
-			{
-				dyn_array_destroy(array);
-				close(fd);
-				return NULL;
-			}
-		} 
-		else 
+			offset += ((const ProcessControlBlock_t *)dyn_array_at(pcbs, i))->next_burst_count;
+			ok = pcb_io_write(io, &offset, sizeof(uint64_t));
+		}
+		for (size_t i = 0; ok && i < num_pcb; ++i)
 		{
-			dyn_array_destroy(array);
-			close(fd);
-			return NULL;
+			const ProcessControlBlock_t *pcb = (const ProcessControlBlock_t *)dyn_array_at(pcbs, i);
+			ok = pcb->next_burst_count == 0 ||
+				pcb_io_write(io, pcb->next_bursts, pcb->next_burst_count * sizeof(uint32_t));
 		}
 	}
 
-	close(fd);
-	return array;
+	ok = ok && pcb_io_flush(io);
+	ok = (close(io->fd) == 0) && ok;
+	free(io);
+	return ok;
 }
 
-bool shortest_remaining_time_first(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+bool first_come_first_serve(dyn_array_t *ready_queue, ScheduleResult_t *result) 
 {
-	if (!ready_queue || !result)
-		return false;
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_FCFS};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-	size_t n = dyn_array_size(ready_queue);
-	if (n == 0)
-		return false;
+bool shortest_job_first(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_SJF};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-	unsigned long clock = 0;
-	size_t completed = 0;
+bool highest_response_ratio_next(dyn_array_t *ready_queue, ScheduleResult_t *result)
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_HRRN};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-	float total_wait_time = 0;
-	float total_turnaround_time = 0;
+bool priority(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_PRIORITY};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-	unsigned long* original_bursts = malloc(sizeof(unsigned long) * n);
-	if (!original_bursts) return false;
+bool priority_preemptive(dyn_array_t *ready_queue, ScheduleResult_t *result, uint64_t aging_interval)
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_PRIORITY_PREEMPTIVE, .aging_interval = aging_interval};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-	for (size_t i = 0; i < n; i++)
-	{
-		ProcessControlBlock_t* pcb = dyn_array_at(ready_queue, i);
-		original_bursts[i] = pcb->remaining_burst_time;
-	}
+bool multi_level_feedback_queue(dyn_array_t *ready_queue, ScheduleResult_t *result, size_t levels, size_t quantum,
+								uint64_t boost_interval)
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_MLFQ, .quantum = quantum, .levels = levels,
+									 .boost_interval = boost_interval};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-	while (completed < n)
-	{
-		ProcessControlBlock_t* shortest = NULL;
-		size_t shortest_index = 0;
+bool completely_fair_scheduler(dyn_array_t *ready_queue, ScheduleResult_t *result, uint64_t target_latency,
+							   uint64_t min_granularity)
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_CFS, .target_latency = target_latency,
+									 .min_granularity = min_granularity};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-		// Find process with smallest remaining time among the current processes
-		for (size_t i = 0; i < n; i++)
-		{
-			ProcessControlBlock_t* pcb = dyn_array_at(ready_queue, i);
-			if (!pcb) {
-				free(original_bursts);
-				return false;
-			}
+bool earliest_deadline_first(dyn_array_t *ready_queue, ScheduleResult_t *result, bool preemptive)
+{
+	const ScheduleConfig_t config = {.algorithm = preemptive ? SCHEDULE_EDF_PREEMPTIVE : SCHEDULE_EDF};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-			if (pcb->arrival <= clock && pcb->remaining_burst_time > 0)
-			{
-				if (!shortest ||
-					pcb->remaining_burst_time < shortest->remaining_burst_time)
-				{
-					shortest = pcb;
-					shortest_index = i;
-				}
-			}
-		}
+bool round_robin(dyn_array_t *ready_queue, ScheduleResult_t *result, size_t quantum) 
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_RR, .quantum = quantum};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-		// If no process is ready advance clock
-		if (!shortest)
-		{
-			clock++;
-			continue;
-		}
+bool shortest_remaining_time_first(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+{
+	const ScheduleConfig_t config = {.algorithm = SCHEDULE_SRT};
+	return schedule_processes(ready_queue, &config, result);
+}
 
-		// First time scheduled: compute waiting time
-		if (!shortest->started)
-		{
-			total_wait_time += (float)(clock - shortest->arrival);
-			shortest->started = true;
-		}
+// CLI names, indexed by ScheduleAlgorithm_t
+static const char *const algorithm_names[] = {"FCFS", "SJF", "P", "RR", "SRT", "PP", "MLFQ", "CFS", "EDF", "EDFP", "HRRN"};
 
-		// Run for 1 time unit
-		virtual_cpu(shortest);
-		clock++;
+#define ALGORITHM_COUNT (sizeof(algorithm_names) / sizeof(algorithm_names[0]))
 
-		// If finished
-		if (shortest->remaining_burst_time == 0)
-		{
-			completed++;
-			unsigned long turnaround = clock - shortest->arrival;
-			total_turnaround_time += (float)turnaround;
+// Every policy runs on the event driven simulator (scheduler.h), so a workload gets the same results whatever
+// the config knobs that don't bind. It jumps from event to event where the old batch loops stepped
+// each PCB once per tick, and picks from heaps where they rescanned the whole queue for each decision.
+bool schedule_processes(const dyn_array_t *ready_queue, const ScheduleConfig_t *config, ScheduleResult_t *result)
+{
+	if (!config)
+	{
+		return false;
+	}
+	return sched_run(ready_queue, config, result);
+}
 
-			unsigned long burst = original_bursts[shortest_index];
-			total_wait_time += (float)(turnaround - burst);
-		}
+bool schedule_algorithm_from_name(const char *name, ScheduleAlgorithm_t *algorithm)
+{
+	if (!name || !algorithm)
+	{
+		return false;
 	}
 
-	result->average_waiting_time = total_wait_time / (float)n;
-	result->average_turnaround_time = total_turnaround_time / (float)n;
-	result->total_run_time = clock;
+	for (size_t i = 0; i < ALGORITHM_COUNT; ++i)
+	{
+		if (strcmp(name, algorithm_names[i]) == 0)
+		{
+			*algorithm = (ScheduleAlgorithm_t)i;
+			return true;
+		}
+	}
+	return false;
+}
 
-	free(original_bursts);
-		
-	return true;
+const char *schedule_algorithm_name(ScheduleAlgorithm_t algorithm)
+{
+	if ((size_t)algorithm >= ALGORITHM_COUNT)
+	{
+		return NULL;
+	}
+	return algorithm_names[algorithm];
 }
 
 void process_control_block_destruct(void *element) 
@@ -0,0 +1,106 @@
+// perf_event_open has no libc wrapper, syscall() is a GNU extension
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "profile.h"
+
+#ifdef __linux__
+static int open_hardware_counter(const uint64_t config)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	if (ioctl((int)fd, PERF_EVENT_IOC_RESET, 0) != 0 || ioctl((int)fd, PERF_EVENT_IOC_ENABLE, 0) != 0)
+	{
+		close((int)fd);
+		return -1;
+	}
+	return (int)fd;
+}
+#endif
+
+void profile_start(Profile_t *profile)
+{
+	if (!profile)
+	{
+		return;
+	}
+	for (size_t i = 0; i < PROFILE_HARDWARE_COUNT; ++i)
+	{
+		profile->fds[i] = -1;
+	}
+#ifdef __linux__
+	static const uint64_t configs[PROFILE_HARDWARE_COUNT] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+	};
+	for (size_t i = 0; i < PROFILE_HARDWARE_COUNT; ++i)
+	{
+		profile->fds[i] = open_hardware_counter(configs[i]);
+	}
+#endif
+}
+
+bool profile_read(const Profile_t *profile, const ProfileHardware_t counter, uint64_t *value)
+{
+	if (!profile || !value || (size_t)counter >= PROFILE_HARDWARE_COUNT || profile->fds[counter] < 0)
+	{
+		return false;
+	}
+	return read(profile->fds[counter], value, sizeof(*value)) == (ssize_t)sizeof(*value);
+}
+
+void profile_stop(Profile_t *profile)
+{
+	for (size_t i = 0; profile && i < PROFILE_HARDWARE_COUNT; ++i)
+	{
+		if (profile->fds[i] >= 0)
+		{
+			close(profile->fds[i]);
+			profile->fds[i] = -1;
+		}
+	}
+}
+
+uint64_t profile_peak_rss(void)
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0 || usage.ru_maxrss < 0)
+	{
+		return 0;
+	}
+	// Linux reports KiB, macOS bytes
+#ifdef __APPLE__
+	return (uint64_t)usage.ru_maxrss / 1024;
+#else
+	return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+const char *profile_hardware_name(const ProfileHardware_t counter)
+{
+	static const char *const names[PROFILE_HARDWARE_COUNT] = {"Cycles", "Instructions", "Cache Misses"};
+	if ((size_t)counter >= PROFILE_HARDWARE_COUNT)
+	{
+		return NULL;
+	}
+	return names[counter];
+}
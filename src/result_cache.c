@@ -0,0 +1,398 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "result_cache.h"
+
+#define RESULT_CACHE_MAGIC 0x31435252u // "RRC1"
+
+// Bytes hashed per read, a multiple of the 8 byte words the hash consumes
+#define HASH_CHUNK 65536
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t record_size;			// guards against a build with another ScheduleResult_t layout
+} cache_header_t;
+
+typedef struct
+{
+	ResultCacheKey_t key;
+	ScheduleResult_t result;
+	uint32_t input_flags;
+	uint32_t reserved;				// zero
+	uint64_t checksum;				// of everything above
+} cache_record_t;
+
+struct result_cache
+{
+	int fd;
+	pthread_mutex_t lock;			// the mapping, the index and the file offset of fd
+	const unsigned char *map;		// the header and every whole record when last mapped
+	size_t mapped;					// bytes mapped
+	size_t indexed;					// records looked at by the index, all up to here are valid or torn for good
+
+	// Open addressing on the key, holding record index + 1, 0 when empty
+	size_t *slots;
+	size_t slot_count;				// power of two
+	size_t entries;
+};
+
+// MurmurHash3's finalizer
+static uint64_t mix(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ull;
+	x ^= x >> 33;
+	return x;
+}
+
+// Folds whole 8 byte words into the hash
+static uint64_t hash_words(uint64_t hash, const unsigned char *data, const size_t words)
+{
+	for (size_t i = 0; i < words; ++i)
+	{
+		uint64_t word;
+		memcpy(&word, data + 8 * i, sizeof(word));
+		hash = (hash ^ mix(word)) * 0x9e3779b97f4a7c15ull;
+	}
+	return hash;
+}
+
+// Folds the last partial word and the length in
+static uint64_t hash_finish(uint64_t hash, const unsigned char *tail, const size_t tail_length, const uint64_t length)
+{
+	uint64_t word = 0;
+	memcpy(&word, tail, tail_length);
+	return mix((hash ^ mix(word)) * 0x9e3779b97f4a7c15ull ^ length);
+}
+
+static uint64_t hash_bytes(const void *data, const size_t length)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	const uint64_t hash = hash_words(0, bytes, length / 8);
+	return hash_finish(hash, bytes + length / 8 * 8, length % 8, length);
+}
+
+static uint64_t record_checksum(const cache_record_t *record)
+{
+	return hash_bytes(record, offsetof(cache_record_t, checksum));
+}
+
+static bool key_equal(const ResultCacheKey_t *a, const ResultCacheKey_t *b)
+{
+	return a->input_hash == b->input_hash && a->input_size == b->input_size && a->config_hash == b->config_hash;
+}
+
+static size_t key_slot(const ResultCache_t *cache, const ResultCacheKey_t *key)
+{
+	return (size_t)(mix(key->input_hash ^ mix(key->input_size ^ mix(key->config_hash)))) & (cache->slot_count - 1);
+}
+
+static const cache_record_t *record_at(const ResultCache_t *cache, const size_t index)
+{
+	return (const cache_record_t *)(cache->map + sizeof(cache_header_t) + index * sizeof(cache_record_t));
+}
+
+// Places record index in the table, over an older record with the same key
+static void index_put(ResultCache_t *cache, const size_t index)
+{
+	const ResultCacheKey_t *key = &record_at(cache, index)->key;
+	size_t slot = key_slot(cache, key);
+	while (cache->slots[slot] != 0 && !key_equal(&record_at(cache, cache->slots[slot] - 1)->key, key))
+	{
+		slot = (slot + 1) & (cache->slot_count - 1);
+	}
+	if (cache->slots[slot] == 0)
+	{
+		++cache->entries;
+	}
+	cache->slots[slot] = index + 1;
+}
+
+// Keeps the table at most half full
+static bool index_reserve(ResultCache_t *cache)
+{
+	if (2 * (cache->entries + 1) <= cache->slot_count)
+	{
+		return true;
+	}
+
+	const size_t old_count = cache->slot_count;
+	size_t *old_slots = cache->slots;
+	const size_t count = old_count > 0 ? 2 * old_count : 64;
+	cache->slots = (size_t *)calloc(count, sizeof(size_t));
+	if (!cache->slots)
+	{
+		cache->slots = old_slots;
+		return false;
+	}
+	cache->slot_count = count;
+	cache->entries = 0;
+	for (size_t i = 0; i < old_count; ++i)
+	{
+		if (old_slots[i] != 0)
+		{
+			index_put(cache, old_slots[i] - 1);
+		}
+	}
+	free(old_slots);
+	return true;
+}
+
+// Maps what has been appended since the last call and indexes its valid records.
+// A bad record followed by others is torn for good (appends are serialized, so the one after it was
+// written once it was), a bad last record may still be being written and is looked at again next time.
+static bool refresh(ResultCache_t *cache)
+{
+	struct stat info;
+	if (fstat(cache->fd, &info) != 0 || (size_t)info.st_size < sizeof(cache_header_t))
+	{
+		return false;
+	}
+	const size_t records = ((size_t)info.st_size - sizeof(cache_header_t)) / sizeof(cache_record_t);
+	const size_t wanted = sizeof(cache_header_t) + records * sizeof(cache_record_t);
+	if (wanted > cache->mapped)
+	{
+		void *map = mmap(NULL, wanted, PROT_READ, MAP_SHARED, cache->fd, 0);
+		if (map == MAP_FAILED)
+		{
+			return false;
+		}
+		if (cache->map)
+		{
+			munmap((void *)cache->map, cache->mapped);
+		}
+		cache->map = (const unsigned char *)map;
+		cache->mapped = wanted;
+	}
+
+	for (; cache->indexed < records; ++cache->indexed)
+	{
+		const cache_record_t *record = record_at(cache, cache->indexed);
+		if (record->checksum != record_checksum(record))
+		{
+			if (cache->indexed + 1 == records)
+			{
+				break;
+			}
+			continue;
+		}
+		if (!index_reserve(cache))
+		{
+			return false;
+		}
+		index_put(cache, cache->indexed);
+	}
+	return true;
+}
+
+// Whole file fcntl lock, shared between the processes using the cache (threads go through cache->lock)
+static bool lock_file(const int fd, const short type)
+{
+	struct flock region;
+	memset(&region, 0, sizeof(region));
+	region.l_type = type;
+	region.l_whence = SEEK_SET;
+	int status;
+	do
+	{
+		status = fcntl(fd, type == F_UNLCK ? F_SETLK : F_SETLKW, &region);
+	} while (status != 0 && errno == EINTR);
+	return status == 0;
+}
+
+static bool write_all(const int fd, const void *data, size_t length)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	while (length > 0)
+	{
+		const ssize_t written = write(fd, bytes, length);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written <= 0)
+		{
+			return false;
+		}
+		bytes += written;
+		length -= (size_t)written;
+	}
+	return true;
+}
+
+ResultCache_t *result_cache_open(const char *path)
+{
+	if (!path)
+	{
+		return NULL;
+	}
+	const int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+
+	// Whoever gets the lock first on an empty file writes the header
+	const cache_header_t expected = {RESULT_CACHE_MAGIC, RESULT_CACHE_VERSION, sizeof(cache_record_t)};
+	cache_header_t header;
+	struct stat info;
+	bool ok = lock_file(fd, F_WRLCK) && fstat(fd, &info) == 0;
+	if (ok && info.st_size == 0)
+	{
+		ok = write_all(fd, &expected, sizeof(expected));
+	}
+	else if (ok)
+	{
+		ok = lseek(fd, 0, SEEK_SET) == 0 && read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) &&
+			memcmp(&header, &expected, sizeof(header)) == 0;
+	}
+	lock_file(fd, F_UNLCK);
+
+	ResultCache_t *cache = ok ? (ResultCache_t *)calloc(1, sizeof(ResultCache_t)) : NULL;
+	if (!cache)
+	{
+		close(fd);
+		return NULL;
+	}
+	cache->fd = fd;
+	pthread_mutex_init(&cache->lock, NULL);
+	return cache;
+}
+
+void result_cache_close(ResultCache_t *cache)
+{
+	if (cache)
+	{
+		if (cache->map)
+		{
+			munmap((void *)cache->map, cache->mapped);
+		}
+		close(cache->fd);
+		pthread_mutex_destroy(&cache->lock);
+		free(cache->slots);
+		free(cache);
+	}
+}
+
+bool result_cache_lookup(ResultCache_t *cache, const ResultCacheKey_t *key, ScheduleResult_t *result,
+						 uint32_t *input_flags)
+{
+	if (!cache || !key || !result)
+	{
+		return false;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	bool found = false;
+	if (refresh(cache) && cache->slot_count > 0)
+	{
+		for (size_t slot = key_slot(cache, key); cache->slots[slot] != 0; slot = (slot + 1) & (cache->slot_count - 1))
+		{
+			const cache_record_t *record = record_at(cache, cache->slots[slot] - 1);
+			if (key_equal(&record->key, key))
+			{
+				*result = record->result;
+				if (input_flags)
+				{
+					*input_flags = record->input_flags;
+				}
+				found = true;
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&cache->lock);
+	return found;
+}
+
+bool result_cache_store(ResultCache_t *cache, const ResultCacheKey_t *key, const ScheduleResult_t *result,
+						const uint32_t input_flags)
+{
+	if (!cache || !key || !result)
+	{
+		return false;
+	}
+
+	cache_record_t record;
+	memset(&record, 0, sizeof(record));
+	record.key = *key;
+	record.result = *result;
+	record.input_flags = input_flags;
+	record.checksum = record_checksum(&record);
+
+	// Appended at the first whole record boundary, past any record a crash cut short
+	pthread_mutex_lock(&cache->lock);
+	struct stat info;
+	bool ok = lock_file(cache->fd, F_WRLCK) && fstat(cache->fd, &info) == 0 &&
+		(size_t)info.st_size >= sizeof(cache_header_t);
+	if (ok)
+	{
+		const size_t records = ((size_t)info.st_size - sizeof(cache_header_t) + sizeof(cache_record_t) - 1) /
+			sizeof(cache_record_t);
+		const off_t offset = (off_t)(sizeof(cache_header_t) + records * sizeof(cache_record_t));
+		ok = lseek(cache->fd, offset, SEEK_SET) == offset && write_all(cache->fd, &record, sizeof(record));
+	}
+	lock_file(cache->fd, F_UNLCK);
+	pthread_mutex_unlock(&cache->lock);
+	return ok;
+}
+
+bool result_cache_hash_file(const char *path, uint64_t *hash, uint64_t *size)
+{
+	if (!path || !hash || !size)
+	{
+		return false;
+	}
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	unsigned char *chunk = (unsigned char *)malloc(HASH_CHUNK);
+	uint64_t state = 0;
+	uint64_t length = 0;
+	size_t filled = 0;
+	bool ok = chunk != NULL;
+	while (ok)
+	{
+		const ssize_t got = read(fd, chunk + filled, HASH_CHUNK - filled);
+		if (got < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (got <= 0)
+		{
+			ok = got == 0;
+			break;
+		}
+		filled += (size_t)got;
+		length += (uint64_t)got;
+		if (filled == HASH_CHUNK)
+		{
+			state = hash_words(state, chunk, HASH_CHUNK / 8);
+			filled = 0;
+		}
+	}
+	close(fd);
+
+	if (ok)
+	{
+		state = hash_words(state, chunk, filled / 8);
+		*hash = hash_finish(state, chunk + filled / 8 * 8, filled % 8, length);
+		*size = length;
+	}
+	free(chunk);
+	return ok;
+}
@@ -0,0 +1,1407 @@
+#include <stdlib.h>
+
+#include "index_heap.h"
+#include "sched_policy.h"
+
+// Ready queue policies for the simulator in scheduler.c.
+// FIFO policies sit on a ring buffer of slots, keyed policies on an index_heap.
+
+//
+// Ring buffer of slots, O(1) at both ends
+//
+
+typedef struct
+{
+	size_t *slots;
+	size_t head;
+	size_t count;
+	size_t capacity;	// always a power of two
+} slot_ring_t;
+
+static bool ring_init(slot_ring_t *ring)
+{
+	ring->head = 0;
+	ring->count = 0;
+	ring->capacity = 16;
+	ring->slots = malloc(ring->capacity * sizeof(size_t));
+	return ring->slots != NULL;
+}
+
+static bool ring_grow(slot_ring_t *ring)
+{
+	size_t *slots = malloc((ring->capacity << 1) * sizeof(size_t));
+	if (!slots)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < ring->count; ++i)
+	{
+		slots[i] = ring->slots[(ring->head + i) & (ring->capacity - 1)];
+	}
+	free(ring->slots);
+	ring->slots = slots;
+	ring->head = 0;
+	ring->capacity <<= 1;
+	return true;
+}
+
+static bool ring_push_back(slot_ring_t *ring, const size_t slot)
+{
+	if (ring->count == ring->capacity && !ring_grow(ring))
+	{
+		return false;
+	}
+	ring->slots[(ring->head + ring->count) & (ring->capacity - 1)] = slot;
+	++ring->count;
+	return true;
+}
+
+static bool ring_peek_front(const slot_ring_t *ring, size_t *slot)
+{
+	if (ring->count == 0)
+	{
+		return false;
+	}
+	*slot = ring->slots[ring->head];
+	return true;
+}
+
+static bool ring_pop_front(slot_ring_t *ring, size_t *slot)
+{
+	if (!ring_peek_front(ring, slot))
+	{
+		return false;
+	}
+	ring->head = (ring->head + 1) & (ring->capacity - 1);
+	--ring->count;
+	return true;
+}
+
+// Takes slot out from anywhere in the ring, shifting the slots behind it forward. O(n), only for shedding load.
+static void ring_remove(slot_ring_t *ring, const size_t slot)
+{
+	const size_t mask = ring->capacity - 1;
+	size_t i = 0;
+	while (i < ring->count && ring->slots[(ring->head + i) & mask] != slot)
+	{
+		++i;
+	}
+	if (i == ring->count)
+	{
+		return;
+	}
+	for (; i + 1 < ring->count; ++i)
+	{
+		ring->slots[(ring->head + i) & mask] = ring->slots[(ring->head + i + 1) & mask];
+	}
+	--ring->count;
+}
+
+//
+// Per slot policy state, grown as the simulator hands out new slots
+//
+
+// \return array with room for slot (possibly moved), NULL if it couldn't grow
+static void *slot_array_reserve(void *array, size_t *capacity, const size_t slot, const size_t element_size)
+{
+	if (slot < *capacity)
+	{
+		return array;
+	}
+
+	size_t grown = *capacity ? *capacity : 16;
+	while (grown <= slot)
+	{
+		grown <<= 1;
+	}
+	void *resized = realloc(array, grown * element_size);
+	if (resized)
+	{
+		*capacity = grown;
+	}
+	return resized;
+}
+
+//
+// Checkpoints: slot lists are a uint64_t count followed by the slots as uint64_t, per slot arrays
+// their capacity followed by the raw elements
+//
+
+static bool put_u64(sched_stream_t *out, const uint64_t value)
+{
+	return sched_stream_write(out, &value, sizeof(value));
+}
+
+static bool get_u64(sched_stream_t *in, uint64_t *value)
+{
+	return sched_stream_read(in, value, sizeof(*value));
+}
+
+static bool save_ring(const slot_ring_t *ring, sched_stream_t *out)
+{
+	bool ok = put_u64(out, ring->count);
+	for (size_t i = 0; ok && i < ring->count; ++i)
+	{
+		ok = put_u64(out, ring->slots[(ring->head + i) & (ring->capacity - 1)]);
+	}
+	return ok;
+}
+
+static bool restore_ring(slot_ring_t *ring, const Scheduler_t *sched, sched_stream_t *in)
+{
+	uint64_t count;
+	bool ok = get_u64(in, &count);
+	for (uint64_t i = 0; ok && i < count; ++i)
+	{
+		size_t slot;
+		ok = sched_stream_read_waiting(in, sched, &slot) && ring_push_back(ring, slot);
+	}
+	return ok;
+}
+
+static void put_slot(size_t slot, void *arg)
+{
+	put_u64((sched_stream_t *)arg, slot);
+}
+
+// The heap order is rebuilt by pushing the slots again, the keys decide it completely
+static bool save_heap(const index_heap_t *heap, sched_stream_t *out)
+{
+	const bool ok = put_u64(out, index_heap_size(heap));
+	index_heap_for_each(heap, put_slot, out);
+	// A failed slot write is sticky and shows up at the next write
+	return ok;
+}
+
+static bool restore_heap(index_heap_t *heap, const Scheduler_t *sched, sched_stream_t *in)
+{
+	uint64_t count;
+	bool ok = get_u64(in, &count);
+	for (uint64_t i = 0; ok && i < count; ++i)
+	{
+		size_t slot;
+		ok = sched_stream_read_waiting(in, sched, &slot) && index_heap_push(heap, slot);
+	}
+	return ok;
+}
+
+static bool save_slot_array(const void *array, const size_t capacity, const size_t element_size,
+							sched_stream_t *out)
+{
+	return put_u64(out, capacity) && (capacity == 0 || sched_stream_write(out, array, capacity * element_size));
+}
+
+static bool restore_slot_array(void **array, size_t *capacity, const size_t element_size, sched_stream_t *in)
+{
+	uint64_t count;
+	if (!get_u64(in, &count) || count > SIZE_MAX / element_size)
+	{
+		return false;
+	}
+	if (count == 0)
+	{
+		return true;
+	}
+	void *resized = slot_array_reserve(*array, capacity, (size_t)count - 1, element_size);
+	if (!resized)
+	{
+		return false;
+	}
+	*array = resized;
+	return sched_stream_read(in, resized, (size_t)count * element_size);
+}
+
+//
+// FCFS and Round Robin: a FIFO queue, Round Robin adds a quantum budget
+//
+
+typedef struct
+{
+	slot_ring_t queue;
+	uint64_t quantum;
+} fifo_policy_t;
+
+static void *fifo_create_with_quantum(const uint64_t quantum)
+{
+	fifo_policy_t *state = malloc(sizeof(fifo_policy_t));
+	if (state && ring_init(&state->queue))
+	{
+		state->quantum = quantum;
+		return state;
+	}
+	free(state);
+	return NULL;
+}
+
+static void *fcfs_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	(void)sched;
+	(void)config;
+	return fifo_create_with_quantum(UINT64_MAX);
+}
+
+static void *rr_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	(void)sched;
+	if (config->quantum == 0)
+	{
+		return NULL;
+	}
+	return fifo_create_with_quantum(config->quantum);
+}
+
+static void fifo_destroy(void *state)
+{
+	fifo_policy_t *fifo = (fifo_policy_t *)state;
+	free(fifo->queue.slots);
+	free(fifo);
+}
+
+static bool fifo_push(void *state, size_t slot, sched_push_reason_t reason)
+{
+	(void)reason;
+	return ring_push_back(&((fifo_policy_t *)state)->queue, slot);
+}
+
+static bool fifo_pop(void *state, size_t *slot)
+{
+	return ring_pop_front(&((fifo_policy_t *)state)->queue, slot);
+}
+
+static bool fifo_peek(void *state, size_t *slot)
+{
+	return ring_peek_front(&((fifo_policy_t *)state)->queue, slot);
+}
+
+static void fifo_remove(void *state, size_t slot)
+{
+	ring_remove(&((fifo_policy_t *)state)->queue, slot);
+}
+
+static bool fifo_save(const void *state, sched_stream_t *out)
+{
+	return save_ring(&((const fifo_policy_t *)state)->queue, out);
+}
+
+static bool fifo_restore(void *state, const Scheduler_t *sched, sched_stream_t *in)
+{
+	return restore_ring(&((fifo_policy_t *)state)->queue, sched, in);
+}
+
+static uint64_t rr_budget(void *state, size_t slot)
+{
+	(void)slot;
+	return ((fifo_policy_t *)state)->quantum;
+}
+
+//
+// SJF, Priority, SRT and EDF: an index_heap ordered by a per-policy key
+//
+
+typedef struct
+{
+	const Scheduler_t *sched;
+	index_heap_t *heap;
+	uint64_t (*key)(const sched_job_t *job);
+} keyed_policy_t;
+
+static uint64_t burst_key(const sched_job_t *job)
+{
+	return job->pcb.remaining_burst_time;
+}
+
+static uint64_t priority_key(const sched_job_t *job)
+{
+	return job->pcb.priority;
+}
+
+static bool keyed_before(size_t a, size_t b, void *context)
+{
+	const keyed_policy_t *keyed = (const keyed_policy_t *)context;
+	const sched_job_t *job_a = sched_job(keyed->sched, a);
+	const sched_job_t *job_b = sched_job(keyed->sched, b);
+	const uint64_t key_a = keyed->key(job_a);
+	const uint64_t key_b = keyed->key(job_b);
+
+	if (key_a != key_b)
+	{
+		return key_a < key_b;
+	}
+	return sched_job_fifo_before(job_a, job_b);
+}
+
+// PCBs without a deadline sort after every deadline
+static uint64_t deadline_key(const sched_job_t *job)
+{
+	return job->pcb.deadline == PCB_NO_DEADLINE ? UINT64_MAX : job->pcb.deadline;
+}
+
+static void *keyed_create(const Scheduler_t *sched, uint64_t (*key)(const sched_job_t *))
+{
+	keyed_policy_t *state = malloc(sizeof(keyed_policy_t));
+	if (state)
+	{
+		state->sched = sched;
+		state->key = key;
+		state->heap = index_heap_create(0, keyed_before, state);
+		if (state->heap)
+		{
+			return state;
+		}
+		free(state);
+	}
+	return NULL;
+}
+
+static void *burst_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	(void)config;
+	return keyed_create(sched, burst_key);
+}
+
+static void *priority_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	(void)config;
+	return keyed_create(sched, priority_key);
+}
+
+static void *deadline_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	(void)config;
+	return keyed_create(sched, deadline_key);
+}
+
+static void keyed_destroy(void *state)
+{
+	keyed_policy_t *keyed = (keyed_policy_t *)state;
+	index_heap_destroy(keyed->heap);
+	free(keyed);
+}
+
+static bool keyed_push(void *state, size_t slot, sched_push_reason_t reason)
+{
+	(void)reason;
+	return index_heap_push(((keyed_policy_t *)state)->heap, slot);
+}
+
+static bool keyed_pop(void *state, size_t *slot)
+{
+	return index_heap_pop(((keyed_policy_t *)state)->heap, slot);
+}
+
+static bool keyed_peek(void *state, size_t *slot)
+{
+	return index_heap_peek(((keyed_policy_t *)state)->heap, slot);
+}
+
+static void keyed_remove(void *state, size_t slot)
+{
+	index_heap_remove(((keyed_policy_t *)state)->heap, slot);
+}
+
+static bool keyed_save(const void *state, sched_stream_t *out)
+{
+	return save_heap(((const keyed_policy_t *)state)->heap, out);
+}
+
+static bool keyed_restore(void *state, const Scheduler_t *sched, sched_stream_t *in)
+{
+	return restore_heap(((keyed_policy_t *)state)->heap, sched, in);
+}
+
+// Preempting needs a strictly smaller key, equal keys leave the running slot alone
+static bool keyed_strictly_before(void *state, size_t a, size_t b)
+{
+	const keyed_policy_t *keyed = (const keyed_policy_t *)state;
+	return keyed->key(sched_job(keyed->sched, a)) < keyed->key(sched_job(keyed->sched, b));
+}
+
+//
+// Preemptive Priority with aging
+//
+// A waiting PCB's effective priority is its priority minus ticks waited / aging_interval. Scaled by the
+// interval that is key - clock with key fixed while it waits: every waiting PCB ages at the same rate, so
+// the heap order never changes as time passes and aging costs nothing per tick. While a PCB runs its
+// aging pauses, so its key is held as key - clock and rebased on the clock when it is pushed again.
+// Without aging the key is just the priority.
+//
+
+typedef __int128 aged_key_t;
+
+typedef struct
+{
+	const Scheduler_t *sched;
+	index_heap_t *heap;
+	uint64_t aging_interval;
+	aged_key_t *keys;	// by slot
+	size_t capacity;
+} aging_policy_t;
+
+// Time term of the keys, zero when aging is off
+static aged_key_t aging_elapsed(const aging_policy_t *aging)
+{
+	return aging->aging_interval ? (aged_key_t)sched_clock(aging->sched) : 0;
+}
+
+static bool aging_before(size_t a, size_t b, void *context)
+{
+	const aging_policy_t *aging = (const aging_policy_t *)context;
+	if (aging->keys[a] != aging->keys[b])
+	{
+		return aging->keys[a] < aging->keys[b];
+	}
+	return sched_job_fifo_before(sched_job(aging->sched, a), sched_job(aging->sched, b));
+}
+
+static void *aging_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	aging_policy_t *state = calloc(1, sizeof(aging_policy_t));
+	if (state)
+	{
+		state->sched = sched;
+		state->aging_interval = config->aging_interval;
+		state->heap = index_heap_create(0, aging_before, state);
+		if (state->heap)
+		{
+			return state;
+		}
+		free(state);
+	}
+	return NULL;
+}
+
+static void aging_destroy(void *state)
+{
+	aging_policy_t *aging = (aging_policy_t *)state;
+	index_heap_destroy(aging->heap);
+	free(aging->keys);
+	free(aging);
+}
+
+static bool aging_push(void *state, size_t slot, sched_push_reason_t reason)
+{
+	aging_policy_t *aging = (aging_policy_t *)state;
+	aged_key_t *keys = slot_array_reserve(aging->keys, &aging->capacity, slot, sizeof(aged_key_t));
+	if (!keys)
+	{
+		return false;
+	}
+	aging->keys = keys;
+
+	if (reason == SCHED_PUSH_ARRIVED)
+	{
+		const uint64_t scale = aging->aging_interval ? aging->aging_interval : 1;
+		aging->keys[slot] = (aged_key_t)sched_job(aging->sched, slot)->pcb.priority * scale + aging_elapsed(aging);
+	}
+	else
+	{
+		aging->keys[slot] += aging_elapsed(aging);
+	}
+	return index_heap_push(aging->heap, slot);
+}
+
+static bool aging_pop(void *state, size_t *slot)
+{
+	aging_policy_t *aging = (aging_policy_t *)state;
+	if (!index_heap_pop(aging->heap, slot))
+	{
+		return false;
+	}
+	aging->keys[*slot] -= aging_elapsed(aging);
+	return true;
+}
+
+static bool aging_peek(void *state, size_t *slot)
+{
+	return index_heap_peek(((aging_policy_t *)state)->heap, slot);
+}
+
+static void aging_remove(void *state, size_t slot)
+{
+	index_heap_remove(((aging_policy_t *)state)->heap, slot);
+}
+
+// The keys of running slots are paused ones, so every slot's key is saved, not just the waiting ones'
+static bool aging_save(const void *state, sched_stream_t *out)
+{
+	const aging_policy_t *aging = (const aging_policy_t *)state;
+	return save_slot_array(aging->keys, aging->capacity, sizeof(aged_key_t), out) && save_heap(aging->heap, out);
+}
+
+static bool aging_restore(void *state, const Scheduler_t *sched, sched_stream_t *in)
+{
+	aging_policy_t *aging = (aging_policy_t *)state;
+	return restore_slot_array((void **)&aging->keys, &aging->capacity, sizeof(aged_key_t), in) &&
+		restore_heap(aging->heap, sched, in);
+}
+
+// a is waiting, b is running and holds its paused key
+static bool aging_strictly_before(void *state, size_t a, size_t b)
+{
+	const aging_policy_t *aging = (const aging_policy_t *)state;
+	return aging->keys[a] - aging_elapsed(aging) < aging->keys[b];
+}
+
+// Runs until the best waiting PCB has aged strictly past the running one
+static uint64_t aging_budget(void *state, size_t slot)
+{
+	const aging_policy_t *aging = (const aging_policy_t *)state;
+	size_t waiting;
+	if (aging->aging_interval == 0 || !index_heap_peek(aging->heap, &waiting))
+	{
+		return UINT64_MAX;
+	}
+
+	// overtake is a clock time, the budget only starts once slot is switched in
+	const uint64_t clock = sched_clock(aging->sched);
+	const uint64_t start = sched_run_start(aging->sched, slot);
+	const aged_key_t overtake = aging->keys[waiting] - aging->keys[slot] + 1;
+	const aged_key_t budget = overtake - (aged_key_t)(start > clock ? start : clock);
+	if (budget > (aged_key_t)UINT64_MAX)
+	{
+		return UINT64_MAX;
+	}
+	return budget > 0 ? (uint64_t)budget : 1;
+}
+
+//
+// MLFQ: a FIFO ring per level and a bitmap of the non-empty levels, so picking the next slot is a
+// count-trailing-zeros. Boosts are applied lazily by the first policy call at or after they are due,
+// which is the first point where the levels can make a difference.
+//
+
+typedef struct
+{
+	const Scheduler_t *sched;
+	slot_ring_t queues[SCHEDULE_MLFQ_MAX_LEVELS];
+	uint64_t quanta[SCHEDULE_MLFQ_MAX_LEVELS];
+	size_t levels;
+	uint64_t non_empty;			// bit i set while queues[i] holds slots
+	uint8_t *level_of;			// by slot
+	size_t capacity;
+
+	uint64_t slice;				// time slice the running slot was dispatched with
+
+	uint64_t boost_interval;
+	uint64_t next_boost;
+} mlfq_policy_t;
+
+static void mlfq_destroy(void *state)
+{
+	mlfq_policy_t *mlfq = (mlfq_policy_t *)state;
+	for (size_t i = 0; i < mlfq->levels; ++i)
+	{
+		free(mlfq->queues[i].slots);
+	}
+	free(mlfq->level_of);
+	free(mlfq);
+}
+
+static void *mlfq_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	if (config->levels == 0 || config->levels > SCHEDULE_MLFQ_MAX_LEVELS)
+	{
+		return NULL;
+	}
+
+	mlfq_policy_t *state = calloc(1, sizeof(mlfq_policy_t));
+	if (!state)
+	{
+		return NULL;
+	}
+
+	state->sched = sched;
+	state->boost_interval = config->boost_interval;
+	state->next_boost = config->boost_interval;
+	for (size_t i = 0; i < config->levels; ++i)
+	{
+		uint64_t quantum = config->quantum;
+		if (config->level_quanta)
+		{
+			quantum = config->level_quanta[i];
+		}
+		else if (i > 0)
+		{
+			const uint64_t above = state->quanta[i - 1];
+			quantum = above > UINT64_MAX / 2 ? UINT64_MAX : above * 2;
+		}
+
+		if (quantum == 0 || !ring_init(&state->queues[i]))
+		{
+			mlfq_destroy(state);
+			return NULL;
+		}
+		state->quanta[i] = quantum;
+		++state->levels;
+	}
+	return state;
+}
+
+// Moves every waiting slot into the top level, the upper levels first
+static bool mlfq_boost(mlfq_policy_t *mlfq)
+{
+	const uint64_t clock = sched_clock(mlfq->sched);
+	if (mlfq->boost_interval == 0 || clock < mlfq->next_boost)
+	{
+		return true;
+	}
+	mlfq->next_boost = (clock / mlfq->boost_interval + 1) * mlfq->boost_interval;
+
+	for (size_t cpu = 0; cpu < sched_cpu_count(mlfq->sched); ++cpu)
+	{
+		const size_t running = sched_running_on(mlfq->sched, cpu);
+		if (running != SIZE_MAX)
+		{
+			mlfq->level_of[running] = 0;
+		}
+	}
+
+	size_t slot;
+	for (size_t level = 1; level < mlfq->levels; ++level)
+	{
+		while (ring_pop_front(&mlfq->queues[level], &slot))
+		{
+			if (!ring_push_back(&mlfq->queues[0], slot))
+			{
+				return false;
+			}
+			mlfq->level_of[slot] = 0;
+		}
+	}
+	if (mlfq->queues[0].count > 0)
+	{
+		mlfq->non_empty = 1;
+	}
+	return true;
+}
+
+static bool mlfq_push(void *state, size_t slot, sched_push_reason_t reason)
+{
+	mlfq_policy_t *mlfq = (mlfq_policy_t *)state;
+	if (!mlfq_boost(mlfq))
+	{
+		return false;
+	}
+
+	uint8_t *level_of = slot_array_reserve(mlfq->level_of, &mlfq->capacity, slot, sizeof(uint8_t));
+	if (!level_of)
+	{
+		return false;
+	}
+	mlfq->level_of = level_of;
+
+	if (reason == SCHED_PUSH_ARRIVED)
+	{
+		mlfq->level_of[slot] = 0;
+	}
+	else if (reason == SCHED_PUSH_EXPIRED && mlfq->level_of[slot] + 1u < mlfq->levels)
+	{
+		++mlfq->level_of[slot];
+	}
+
+	const size_t level = mlfq->level_of[slot];
+	if (!ring_push_back(&mlfq->queues[level], slot))
+	{
+		return false;
+	}
+	mlfq->non_empty |= (uint64_t)1 << level;
+	return true;
+}
+
+static bool mlfq_peek(void *state, size_t *slot)
+{
+	mlfq_policy_t *mlfq = (mlfq_policy_t *)state;
+	if (!mlfq_boost(mlfq) || mlfq->non_empty == 0)
+	{
+		return false;
+	}
+	return ring_peek_front(&mlfq->queues[__builtin_ctzll(mlfq->non_empty)], slot);
+}
+
+static bool mlfq_pop(void *state, size_t *slot)
+{
+	mlfq_policy_t *mlfq = (mlfq_policy_t *)state;
+	if (!mlfq_boost(mlfq) || mlfq->non_empty == 0)
+	{
+		return false;
+	}
+
+	const unsigned level = (unsigned)__builtin_ctzll(mlfq->non_empty);
+	ring_pop_front(&mlfq->queues[level], slot);
+	if (mlfq->queues[level].count == 0)
+	{
+		mlfq->non_empty &= ~((uint64_t)1 << level);
+	}
+
+	mlfq->slice = mlfq->quanta[level];
+	return true;
+}
+
+// Doesn't boost, the slot is found at whatever level it waits in
+static void mlfq_remove(void *state, size_t slot)
+{
+	mlfq_policy_t *mlfq = (mlfq_policy_t *)state;
+	const size_t level = mlfq->level_of[slot];
+	ring_remove(&mlfq->queues[level], slot);
+	if (mlfq->queues[level].count == 0)
+	{
+		mlfq->non_empty &= ~((uint64_t)1 << level);
+	}
+}
+
+static bool mlfq_save(const void *state, sched_stream_t *out)
+{
+	const mlfq_policy_t *mlfq = (const mlfq_policy_t *)state;
+	bool ok = put_u64(out, mlfq->next_boost) && put_u64(out, mlfq->slice) &&
+		save_slot_array(mlfq->level_of, mlfq->capacity, sizeof(uint8_t), out);
+	for (size_t level = 0; ok && level < mlfq->levels; ++level)
+	{
+		ok = save_ring(&mlfq->queues[level], out);
+	}
+	return ok;
+}
+
+static bool mlfq_restore(void *state, const Scheduler_t *sched, sched_stream_t *in)
+{
+	mlfq_policy_t *mlfq = (mlfq_policy_t *)state;
+	bool ok = get_u64(in, &mlfq->next_boost) && get_u64(in, &mlfq->slice) &&
+		restore_slot_array((void **)&mlfq->level_of, &mlfq->capacity, sizeof(uint8_t), in);
+	for (size_t level = 0; ok && level < mlfq->levels; ++level)
+	{
+		ok = restore_ring(&mlfq->queues[level], sched, in);
+		for (size_t i = 0; ok && i < mlfq->queues[level].count; ++i)
+		{
+			const size_t slot = mlfq->queues[level].slots[i];
+			ok = slot < mlfq->capacity && mlfq->level_of[slot] == level;
+		}
+		if (mlfq->queues[level].count > 0)
+		{
+			mlfq->non_empty |= (uint64_t)1 << level;
+		}
+	}
+	return ok;
+}
+
+static bool mlfq_before(void *state, size_t a, size_t b)
+{
+	const mlfq_policy_t *mlfq = (const mlfq_policy_t *)state;
+	return mlfq->level_of[a] < mlfq->level_of[b];
+}
+
+// What is left of the slice, arrivals that don't preempt don't restart it
+static uint64_t mlfq_budget(void *state, size_t slot)
+{
+	const mlfq_policy_t *mlfq = (const mlfq_policy_t *)state;
+	const uint64_t used = sched_ran(mlfq->sched, slot);
+	return used < mlfq->slice ? mlfq->slice - used : 0;
+}
+
+//
+// CFS: every slot accrues vruntime, ticks run scaled by its nice weight, and the slot with the least
+// vruntime runs next. Slices split a scheduling period between the runnable slots by weight, the period
+// being the target latency or runnable * minimum granularity if that is longer. The run queue is an
+// index_heap on vruntime.
+//
+
+// Linux's sched_prio_to_weight, nice -20 to 19. Each nice level is ~10% of CPU.
+static const uint32_t nice_weights[40] = {
+	88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+	9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+	1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+	110, 87, 70, 56, 45, 36, 29, 23, 18, 15
+};
+
+#define NICE_0_WEIGHT 1024
+
+// vruntime is kept in 1/65536 of a nice 0 tick so small weights don't round away
+#define VRUNTIME_SHIFT 16
+
+typedef struct
+{
+	const Scheduler_t *sched;
+	index_heap_t *heap;
+	uint64_t target_latency;
+	uint64_t min_granularity;
+	uint64_t *vruntime;			// by slot, for the running slot as of its dispatch
+	size_t capacity;
+	uint64_t queued_weight;		// summed over the heap
+	uint64_t min_vruntime;		// never decreases, where arrivals are placed
+} cfs_policy_t;
+
+static uint64_t cfs_weight(const cfs_policy_t *cfs, const size_t slot)
+{
+	const uint32_t priority = sched_job(cfs->sched, slot)->pcb.priority;
+	return nice_weights[priority < 40 ? priority : 39];
+}
+
+static uint64_t cfs_scale(const uint64_t ticks, const uint64_t weight)
+{
+	return (uint64_t)((((unsigned __int128)ticks << VRUNTIME_SHIFT) * NICE_0_WEIGHT) / weight);
+}
+
+static uint64_t cfs_running_vruntime(const cfs_policy_t *cfs, const size_t running)
+{
+	return cfs->vruntime[running] + cfs_scale(sched_ran(cfs->sched, running), cfs_weight(cfs, running));
+}
+
+static bool cfs_before(size_t a, size_t b, void *context)
+{
+	const cfs_policy_t *cfs = (const cfs_policy_t *)context;
+	if (cfs->vruntime[a] != cfs->vruntime[b])
+	{
+		return cfs->vruntime[a] < cfs->vruntime[b];
+	}
+	return sched_job_fifo_before(sched_job(cfs->sched, a), sched_job(cfs->sched, b));
+}
+
+static void *cfs_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	if (config->target_latency == 0 || config->min_granularity == 0)
+	{
+		return NULL;
+	}
+
+	cfs_policy_t *state = calloc(1, sizeof(cfs_policy_t));
+	if (state)
+	{
+		state->sched = sched;
+		state->target_latency = config->target_latency;
+		state->min_granularity = config->min_granularity;
+		state->heap = index_heap_create(0, cfs_before, state);
+		if (state->heap)
+		{
+			return state;
+		}
+		free(state);
+	}
+	return NULL;
+}
+
+static void cfs_destroy(void *state)
+{
+	cfs_policy_t *cfs = (cfs_policy_t *)state;
+	index_heap_destroy(cfs->heap);
+	free(cfs->vruntime);
+	free(cfs);
+}
+
+// Catches min_vruntime up with the least vruntime among the running and the queued slots
+static void cfs_update_min_vruntime(cfs_policy_t *cfs)
+{
+	uint64_t least = UINT64_MAX;
+	for (size_t cpu = 0; cpu < sched_cpu_count(cfs->sched); ++cpu)
+	{
+		const size_t running = sched_running_on(cfs->sched, cpu);
+		if (running != SIZE_MAX && cfs_running_vruntime(cfs, running) < least)
+		{
+			least = cfs_running_vruntime(cfs, running);
+		}
+	}
+
+	size_t first;
+	if (index_heap_peek(cfs->heap, &first) && cfs->vruntime[first] < least)
+	{
+		least = cfs->vruntime[first];
+	}
+
+	if (least != UINT64_MAX && least > cfs->min_vruntime)
+	{
+		cfs->min_vruntime = least;
+	}
+}
+
+static bool cfs_push(void *state, size_t slot, sched_push_reason_t reason)
+{
+	cfs_policy_t *cfs = (cfs_policy_t *)state;
+	uint64_t *vruntime = slot_array_reserve(cfs->vruntime, &cfs->capacity, slot, sizeof(uint64_t));
+	if (!vruntime)
+	{
+		return false;
+	}
+	cfs->vruntime = vruntime;
+
+	if (reason == SCHED_PUSH_ARRIVED)
+	{
+		// Newcomers start level with the queue instead of owed all the CPU time they missed
+		cfs_update_min_vruntime(cfs);
+		cfs->vruntime[slot] = cfs->min_vruntime;
+	}
+	else if (reason == SCHED_PUSH_WOKEN)
+	{
+		// Back from IO with what it banked, but a long sleep doesn't earn it a monopoly either
+		cfs_update_min_vruntime(cfs);
+		if (cfs->vruntime[slot] < cfs->min_vruntime)
+		{
+			cfs->vruntime[slot] = cfs->min_vruntime;
+		}
+	}
+	else
+	{
+		cfs->vruntime[slot] = cfs_running_vruntime(cfs, slot);
+	}
+
+	if (!index_heap_push(cfs->heap, slot))
+	{
+		return false;
+	}
+	cfs->queued_weight += cfs_weight(cfs, slot);
+	return true;
+}
+
+static void cfs_stopped(void *state, size_t slot)
+{
+	cfs_policy_t *cfs = (cfs_policy_t *)state;
+	cfs->vruntime[slot] = cfs_running_vruntime(cfs, slot);
+}
+
+static bool cfs_pop(void *state, size_t *slot)
+{
+	cfs_policy_t *cfs = (cfs_policy_t *)state;
+	if (!index_heap_pop(cfs->heap, slot))
+	{
+		return false;
+	}
+
+	cfs->queued_weight -= cfs_weight(cfs, *slot);
+	if (cfs->vruntime[*slot] > cfs->min_vruntime)
+	{
+		cfs->min_vruntime = cfs->vruntime[*slot];
+	}
+	return true;
+}
+
+static bool cfs_peek(void *state, size_t *slot)
+{
+	return index_heap_peek(((cfs_policy_t *)state)->heap, slot);
+}
+
+static void cfs_remove(void *state, size_t slot)
+{
+	cfs_policy_t *cfs = (cfs_policy_t *)state;
+	if (index_heap_remove(cfs->heap, slot))
+	{
+		cfs->queued_weight -= cfs_weight(cfs, slot);
+	}
+}
+
+static bool cfs_save(const void *state, sched_stream_t *out)
+{
+	const cfs_policy_t *cfs = (const cfs_policy_t *)state;
+	return put_u64(out, cfs->min_vruntime) && save_slot_array(cfs->vruntime, cfs->capacity, sizeof(uint64_t), out) &&
+		save_heap(cfs->heap, out);
+}
+
+static bool cfs_restore(void *state, const Scheduler_t *sched, sched_stream_t *in)
+{
+	cfs_policy_t *cfs = (cfs_policy_t *)state;
+	uint64_t count;
+	bool ok = get_u64(in, &cfs->min_vruntime) &&
+		restore_slot_array((void **)&cfs->vruntime, &cfs->capacity, sizeof(uint64_t), in) && get_u64(in, &count);
+	for (uint64_t i = 0; ok && i < count; ++i)
+	{
+		size_t slot;
+		ok = sched_stream_read_waiting(in, sched, &slot) && slot < cfs->capacity && index_heap_push(cfs->heap, slot);
+		if (ok)
+		{
+			cfs->queued_weight += cfs_weight(cfs, slot);
+		}
+	}
+	return ok;
+}
+
+// Wakeup preemption: the newcomer has to be behind by more than the minimum granularity (in its own
+// vruntime) so a stream of arrivals can't cut every slice short
+static bool cfs_preempts(void *state, size_t a, size_t b)
+{
+	const cfs_policy_t *cfs = (const cfs_policy_t *)state;
+	const uint64_t granularity = cfs_scale(cfs->min_granularity, cfs_weight(cfs, a));
+	return cfs_running_vruntime(cfs, b) > cfs->vruntime[a] + granularity;
+}
+
+// The slot's weighted share of the scheduling period, less what it already ran
+static uint64_t cfs_budget(void *state, size_t slot)
+{
+	const cfs_policy_t *cfs = (const cfs_policy_t *)state;
+	const uint64_t runnable = (uint64_t)index_heap_size(cfs->heap) + 1;
+	const uint64_t weight = cfs_weight(cfs, slot);
+
+	unsigned __int128 period = (unsigned __int128)runnable * cfs->min_granularity;
+	if (period < cfs->target_latency)
+	{
+		period = cfs->target_latency;
+	}
+	unsigned __int128 slice = period * weight / (cfs->queued_weight + weight);
+
+	const uint64_t ran = sched_ran(cfs->sched, slot);
+	if (slice <= ran)
+	{
+		return 0;
+	}
+	slice -= ran;
+	return slice > UINT64_MAX ? UINT64_MAX : (uint64_t)slice;
+}
+
+//
+// HRRN: response ratio (wait + burst) / burst, highest first. Ratios move with the clock at different
+// rates (1 / burst), so no fixed key orders them. A kinetic tournament tree over the slots keeps the
+// winner of every subtree along with the first tick its other child's winner overtakes it; moving
+// the clock forward only replays the matches whose certificate expired, and pushes and pops replay
+// the matches on one leaf-to-root path.
+//
+
+typedef struct
+{
+	const Scheduler_t *sched;
+	size_t leaves;				// power of two, slot i is node leaves + i
+	size_t *winner;				// by node, SIZE_MAX for an empty subtree
+	uint64_t *expires;			// by node, tick at which the winner loses its match, UINT64_MAX if never
+	uint64_t *next_event;		// by node, earliest expiry in the subtree
+	uint64_t *ready_at;			// by slot, arrival or return from IO; the wait is counted from here
+	uint64_t now;				// clock the certificates were last brought up to
+} hrrn_policy_t;
+
+// Whether slot i has a strictly higher response ratio than slot j at time, ties by arrival order.
+// Ratios are compared cross-multiplied; a zero burst has an infinite ratio.
+static bool hrrn_beats(const hrrn_policy_t *hrrn, const size_t i, const size_t j, const uint64_t time)
+{
+	const sched_job_t *job_i = sched_job(hrrn->sched, i);
+	const sched_job_t *job_j = sched_job(hrrn->sched, j);
+	const uint64_t burst_i = job_i->pcb.remaining_burst_time;
+	const uint64_t burst_j = job_j->pcb.remaining_burst_time;
+
+	if ((burst_i == 0) != (burst_j == 0))
+	{
+		return burst_i == 0;
+	}
+	if (burst_i != 0)
+	{
+		const __int128 ratio_i = ((__int128)time - hrrn->ready_at[i]) * burst_j;
+		const __int128 ratio_j = ((__int128)time - hrrn->ready_at[j]) * burst_i;
+		if (ratio_i != ratio_j)
+		{
+			return ratio_i > ratio_j;
+		}
+	}
+	return sched_job_fifo_before(job_i, job_j);
+}
+
+// First tick from now on at which loser beats winner, UINT64_MAX if it never does
+static uint64_t hrrn_overtake(const hrrn_policy_t *hrrn, const size_t winner, const size_t loser)
+{
+	const sched_job_t *job_w = sched_job(hrrn->sched, winner);
+	const sched_job_t *job_l = sched_job(hrrn->sched, loser);
+	const uint64_t burst_w = job_w->pcb.remaining_burst_time;
+	const uint64_t burst_l = job_l->pcb.remaining_burst_time;
+
+	// Only a shorter burst gains on the winner (zero bursts already won or never change place)
+	if (burst_l == 0 || burst_l >= burst_w)
+	{
+		return UINT64_MAX;
+	}
+
+	// (t - a_l) * b_w > (t - a_w) * b_l  <=>  t * (b_w - b_l) > a_l * b_w - a_w * b_l, equality decided by arrival
+	const __int128 numerator = (__int128)hrrn->ready_at[loser] * burst_w - (__int128)hrrn->ready_at[winner] * burst_l;
+	const __int128 denominator = (__int128)(burst_w - burst_l);
+	__int128 floor = numerator / denominator;
+	if (numerator % denominator != 0 && numerator < 0)
+	{
+		--floor;
+	}
+
+	__int128 time = floor + 1;
+	if (numerator % denominator == 0 && sched_job_fifo_before(job_l, job_w))
+	{
+		time = floor;
+	}
+	if (time < (__int128)hrrn->now)
+	{
+		time = hrrn->now;
+	}
+	return time >= (__int128)UINT64_MAX ? UINT64_MAX : (uint64_t)time;
+}
+
+// Replays the match at an internal node from its children's winners
+static void hrrn_play(hrrn_policy_t *hrrn, const size_t node)
+{
+	const size_t left = hrrn->winner[2 * node];
+	const size_t right = hrrn->winner[2 * node + 1];
+
+	if (left == SIZE_MAX || right == SIZE_MAX)
+	{
+		hrrn->winner[node] = left == SIZE_MAX ? right : left;
+		hrrn->expires[node] = UINT64_MAX;
+	}
+	else
+	{
+		const bool left_wins = hrrn_beats(hrrn, left, right, hrrn->now);
+		hrrn->winner[node] = left_wins ? left : right;
+		hrrn->expires[node] = left_wins ? hrrn_overtake(hrrn, left, right) : hrrn_overtake(hrrn, right, left);
+	}
+
+	uint64_t next = hrrn->expires[node];
+	if (2 * node < hrrn->leaves)
+	{
+		if (hrrn->next_event[2 * node] < next)
+		{
+			next = hrrn->next_event[2 * node];
+		}
+		if (hrrn->next_event[2 * node + 1] < next)
+		{
+			next = hrrn->next_event[2 * node + 1];
+		}
+	}
+	hrrn->next_event[node] = next;
+}
+
+// Replays every match whose certificate expired by now, children first
+static void hrrn_replay_expired(hrrn_policy_t *hrrn, const size_t node)
+{
+	if (node >= hrrn->leaves || hrrn->next_event[node] > hrrn->now)
+	{
+		return;
+	}
+	hrrn_replay_expired(hrrn, 2 * node);
+	hrrn_replay_expired(hrrn, 2 * node + 1);
+	hrrn_play(hrrn, node);
+}
+
+static void hrrn_advance(hrrn_policy_t *hrrn)
+{
+	hrrn->now = sched_clock(hrrn->sched);
+	hrrn_replay_expired(hrrn, 1);
+}
+
+static void hrrn_replay_path(hrrn_policy_t *hrrn, const size_t slot)
+{
+	for (size_t node = (hrrn->leaves + slot) / 2; node >= 1; node /= 2)
+	{
+		hrrn_play(hrrn, node);
+	}
+}
+
+// Sizes the tree for at least leaves slots and replays every match
+static bool hrrn_resize(hrrn_policy_t *hrrn, const size_t leaves)
+{
+	size_t *winner = malloc(2 * leaves * sizeof(size_t));
+	uint64_t *expires = malloc(2 * leaves * sizeof(uint64_t));
+	uint64_t *next_event = malloc(2 * leaves * sizeof(uint64_t));
+	uint64_t *ready_at = malloc(leaves * sizeof(uint64_t));
+	if (!winner || !expires || !next_event || !ready_at)
+	{
+		free(winner);
+		free(expires);
+		free(next_event);
+		free(ready_at);
+		return false;
+	}
+
+	for (size_t i = 0; i < leaves; ++i)
+	{
+		winner[leaves + i] = i < hrrn->leaves ? hrrn->winner[hrrn->leaves + i] : SIZE_MAX;
+		expires[leaves + i] = UINT64_MAX;
+		next_event[leaves + i] = UINT64_MAX;
+		ready_at[i] = i < hrrn->leaves ? hrrn->ready_at[i] : 0;
+	}
+
+	free(hrrn->winner);
+	free(hrrn->expires);
+	free(hrrn->next_event);
+	free(hrrn->ready_at);
+	hrrn->winner = winner;
+	hrrn->expires = expires;
+	hrrn->next_event = next_event;
+	hrrn->ready_at = ready_at;
+	hrrn->leaves = leaves;
+
+	for (size_t node = leaves - 1; node >= 1; --node)
+	{
+		hrrn_play(hrrn, node);
+	}
+	return true;
+}
+
+static void hrrn_destroy(void *state)
+{
+	hrrn_policy_t *hrrn = (hrrn_policy_t *)state;
+	free(hrrn->winner);
+	free(hrrn->expires);
+	free(hrrn->next_event);
+	free(hrrn->ready_at);
+	free(hrrn);
+}
+
+static void *hrrn_create(const Scheduler_t *sched, const ScheduleConfig_t *config)
+{
+	(void)config;
+	hrrn_policy_t *state = calloc(1, sizeof(hrrn_policy_t));
+	if (state)
+	{
+		state->sched = sched;
+		if (hrrn_resize(state, 16))
+		{
+			return state;
+		}
+		free(state);
+	}
+	return NULL;
+}
+
+static bool hrrn_push(void *state, size_t slot, sched_push_reason_t reason)
+{
+	hrrn_policy_t *hrrn = (hrrn_policy_t *)state;
+	hrrn_advance(hrrn);
+
+	if (slot >= hrrn->leaves)
+	{
+		size_t leaves = hrrn->leaves;
+		while (leaves <= slot)
+		{
+			leaves <<= 1;
+		}
+		if (!hrrn_resize(hrrn, leaves))
+		{
+			return false;
+		}
+	}
+
+	// Arrivals can be admitted after the fact (nothing preempts), wakeups happen on time
+	hrrn->ready_at[slot] = reason == SCHED_PUSH_WOKEN ? hrrn->now : sched_job(hrrn->sched, slot)->pcb.arrival;
+	hrrn->winner[hrrn->leaves + slot] = slot;
+	hrrn_replay_path(hrrn, slot);
+	return true;
+}
+
+static bool hrrn_peek(void *state, size_t *slot)
+{
+	hrrn_policy_t *hrrn = (hrrn_policy_t *)state;
+	hrrn_advance(hrrn);
+	*slot = hrrn->winner[1];
+	return *slot != SIZE_MAX;
+}
+
+static bool hrrn_pop(void *state, size_t *slot)
+{
+	hrrn_policy_t *hrrn = (hrrn_policy_t *)state;
+	if (!hrrn_peek(state, slot))
+	{
+		return false;
+	}
+	hrrn->winner[hrrn->leaves + *slot] = SIZE_MAX;
+	hrrn_replay_path(hrrn, *slot);
+	return true;
+}
+
+static void hrrn_remove(void *state, size_t slot)
+{
+	hrrn_policy_t *hrrn = (hrrn_policy_t *)state;
+	hrrn_advance(hrrn);
+	hrrn->winner[hrrn->leaves + slot] = SIZE_MAX;
+	hrrn_replay_path(hrrn, slot);
+}
+
+// The certificates are recomputed from the leaves, which replays the matches at the same now
+static bool hrrn_save(const void *state, sched_stream_t *out)
+{
+	const hrrn_policy_t *hrrn = (const hrrn_policy_t *)state;
+	uint64_t count = 0;
+	for (size_t i = 0; i < hrrn->leaves; ++i)
+	{
+		count += hrrn->winner[hrrn->leaves + i] != SIZE_MAX;
+	}
+
+	bool ok = put_u64(out, hrrn->now) && put_u64(out, hrrn->leaves) &&
+		sched_stream_write(out, hrrn->ready_at, hrrn->leaves * sizeof(uint64_t)) && put_u64(out, count);
+	for (size_t i = 0; ok && i < hrrn->leaves; ++i)
+	{
+		if (hrrn->winner[hrrn->leaves + i] != SIZE_MAX)
+		{
+			ok = put_u64(out, i);
+		}
+	}
+	return ok;
+}
+
+static bool hrrn_restore(void *state, const Scheduler_t *sched, sched_stream_t *in)
+{
+	hrrn_policy_t *hrrn = (hrrn_policy_t *)state;
+	uint64_t now;
+	uint64_t leaves;
+	uint64_t count;
+	if (!get_u64(in, &now) || !get_u64(in, &leaves) || leaves < hrrn->leaves || (leaves & (leaves - 1)) != 0 ||
+			leaves > SIZE_MAX / (2 * sizeof(uint64_t)) || (leaves > hrrn->leaves && !hrrn_resize(hrrn, (size_t)leaves)) ||
+			!sched_stream_read(in, hrrn->ready_at, hrrn->leaves * sizeof(uint64_t)) || !get_u64(in, &count))
+	{
+		return false;
+	}
+
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		size_t slot;
+		if (!sched_stream_read_waiting(in, sched, &slot) || slot >= hrrn->leaves)
+		{
+			return false;
+		}
+		hrrn->winner[hrrn->leaves + slot] = slot;
+	}
+	hrrn->now = now;
+	for (size_t node = hrrn->leaves - 1; node >= 1; --node)
+	{
+		hrrn_play(hrrn, node);
+	}
+	return true;
+}
+
+static const sched_policy_t fcfs_policy = {false, false, fcfs_create, fifo_destroy, fifo_push, fifo_pop, fifo_peek, NULL, NULL, NULL,
+										  fifo_remove, fifo_save, fifo_restore};
+static const sched_policy_t rr_policy = {false, false, rr_create, fifo_destroy, fifo_push, fifo_pop, fifo_peek, NULL, rr_budget, NULL,
+										fifo_remove, fifo_save, fifo_restore};
+static const sched_policy_t sjf_policy = {false, false, burst_create, keyed_destroy, keyed_push, keyed_pop, keyed_peek, NULL,
+										  NULL, NULL, keyed_remove, keyed_save, keyed_restore};
+static const sched_policy_t priority_policy = {false, false, priority_create, keyed_destroy, keyed_push, keyed_pop, keyed_peek,
+											   NULL, NULL, NULL, keyed_remove, keyed_save, keyed_restore};
+static const sched_policy_t srt_policy = {true, true, burst_create, keyed_destroy, keyed_push, keyed_pop, keyed_peek,
+										  keyed_strictly_before, NULL, NULL, keyed_remove, keyed_save, keyed_restore};
+static const sched_policy_t edf_policy = {false, false, deadline_create, keyed_destroy, keyed_push, keyed_pop, keyed_peek, NULL,
+										  NULL, NULL, keyed_remove, keyed_save, keyed_restore};
+static const sched_policy_t edf_preemptive_policy = {true, false, deadline_create, keyed_destroy, keyed_push, keyed_pop,
+													 keyed_peek, keyed_strictly_before, NULL, NULL, keyed_remove,
+													 keyed_save, keyed_restore};
+static const sched_policy_t priority_preemptive_policy = {true, false, aging_create, aging_destroy, aging_push, aging_pop,
+															aging_peek, aging_strictly_before, aging_budget, NULL,
+															aging_remove, aging_save, aging_restore};
+static const sched_policy_t mlfq_policy = {true, false, mlfq_create, mlfq_destroy, mlfq_push, mlfq_pop, mlfq_peek, mlfq_before,
+										   mlfq_budget, NULL, mlfq_remove, mlfq_save, mlfq_restore};
+static const sched_policy_t cfs_policy = {true, false, cfs_create, cfs_destroy, cfs_push, cfs_pop, cfs_peek, cfs_preempts,
+										  cfs_budget, cfs_stopped, cfs_remove, cfs_save, cfs_restore};
+static const sched_policy_t hrrn_policy = {false, false, hrrn_create, hrrn_destroy, hrrn_push, hrrn_pop, hrrn_peek, NULL,
+										   NULL, NULL, hrrn_remove, hrrn_save, hrrn_restore};
+
+const sched_policy_t *sched_policy_for(ScheduleAlgorithm_t algorithm)
+{
+	switch (algorithm)
+	{
+		case SCHEDULE_FCFS:
+			return &fcfs_policy;
+		case SCHEDULE_SJF:
+			return &sjf_policy;
+		case SCHEDULE_PRIORITY:
+			return &priority_policy;
+		case SCHEDULE_RR:
+			return &rr_policy;
+		case SCHEDULE_SRT:
+			return &srt_policy;
+		case SCHEDULE_PRIORITY_PREEMPTIVE:
+			return &priority_preemptive_policy;
+		case SCHEDULE_MLFQ:
+			return &mlfq_policy;
+		case SCHEDULE_CFS:
+			return &cfs_policy;
+		case SCHEDULE_EDF:
+			return &edf_policy;
+		case SCHEDULE_EDF_PREEMPTIVE:
+			return &edf_preemptive_policy;
+		case SCHEDULE_HRRN:
+			return &hrrn_policy;
+	}
+	return NULL;
+}
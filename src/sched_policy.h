@@ -0,0 +1,122 @@
+#ifndef SCHED_POLICY_H
+#define SCHED_POLICY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scheduler.h"
+
+// Internal interface between the simulator (scheduler.c) and its ready queue policies (sched_policies.c).
+// The simulator owns the clock, the PCBs and the metrics; a policy only decides which slot runs next
+// and for how long. PCBs are referred to by slot, the index of their sched_job_t in the simulator.
+
+typedef enum
+{
+	JOB_FREE,		// slot is on the free list
+	JOB_PENDING,	// submitted, arrival still in the future
+	JOB_READY,		// owned by the policy
+	JOB_RUNNING,	// on a CPU
+	JOB_BLOCKED		// queued for or using the IO device
+} sched_job_state_t;
+
+typedef struct
+{
+	ProcessControlBlock_t pcb;	// remaining_burst_time counts down as the job runs
+	uint64_t seq;				// submission order, breaks ties between equal keys
+	uint64_t first_dispatch;
+	uint64_t preemptions;
+	uint64_t io_ticket;			// IO queue order
+	uint64_t left_cpu;			// clock it was last switched out, for the cache warmup penalty
+	uint64_t work_left;			// of the current CPU burst, in 1 / SCHEDULE_SPEED_NOMINAL ticks
+	uint64_t cpu_burst;			// every CPU burst of the PCB added up, for wait_adds_time_off_cpu
+	size_t cpu;					// CPU it runs on or last ran on, SIZE_MAX before its first dispatch
+	uint32_t next_burst;		// index into pcb.next_bursts of the next IO burst
+	sched_job_state_t state;	// next to next_burst so neither is padded out to 8 bytes
+} sched_job_t;
+
+// Buffered checkpoint file, see sched_checkpoint. Errors are sticky: once a read or write fails every
+// later one does too, and the checkpoint as a whole is reported as failed.
+typedef struct sched_stream sched_stream_t;
+
+bool sched_stream_write(sched_stream_t *stream, const void *src, size_t count);
+bool sched_stream_read(sched_stream_t *stream, void *dst, size_t count);
+
+// Reads a slot written as a uint64_t and checks it is one the simulator has as waiting in the ready queue
+bool sched_stream_read_waiting(sched_stream_t *stream, const Scheduler_t *sched, size_t *slot);
+
+// Why a slot is (re)entering the ready queue
+typedef enum
+{
+	SCHED_PUSH_ARRIVED,		// newly arrived
+	SCHED_PUSH_WOKEN,		// finished an IO burst, pcb.remaining_burst_time is its next CPU burst
+	SCHED_PUSH_EXPIRED,		// used up the budget it was dispatched with
+	SCHED_PUSH_PREEMPTED	// displaced by a candidate the policy ranks before it
+} sched_push_reason_t;
+
+typedef struct
+{
+	// Whether an arrival may displace the running PCB (see before)
+	bool preempt_on_arrival;
+
+	// Whether a completed PCB's waiting time also counts its turnaround - burst, the time it spent off the
+	// CPU after arriving, as the original shortest_remaining_time_first loop reported it
+	bool wait_adds_time_off_cpu;
+
+	// Builds the policy state, NULL if the config is invalid for this policy
+	void *(*create)(const Scheduler_t *sched, const ScheduleConfig_t *config);
+	void (*destroy)(void *state);
+
+	// Ready queue operations, pop/peek return false when the queue is empty
+	bool (*push)(void *state, size_t slot, sched_push_reason_t reason);
+	bool (*pop)(void *state, size_t *slot);
+	bool (*peek)(void *state, size_t *slot);
+
+	// Only used when preempt_on_arrival: true if ready slot a should displace running slot b.
+	// With several CPUs the simulator asks about each running slot and lets placement pick among them.
+	bool (*before)(void *state, size_t a, size_t b);
+
+	// Ticks slot may run before the policy wants to decide again, NULL means until its burst completes.
+	// Asked at dispatch, and for preempt_on_arrival policies again after every arrival that doesn't preempt.
+	// Counted from sched_run_start, context switch overhead isn't part of it.
+	uint64_t (*budget)(void *state, size_t slot);
+
+	// The running slot left the CPU without going back to the policy (completed or blocked on IO), NULL to ignore
+	void (*stopped)(void *state, size_t slot);
+
+	// Takes a waiting slot out of the ready queue wherever it sits, for admission control shedding load
+	void (*remove)(void *state, size_t slot);
+
+	// Writes the ready queue and whatever per slot state the policy keeps, for a checkpoint
+	bool (*save)(const void *state, sched_stream_t *out);
+
+	// Reads back what save wrote into the state of a freshly created policy. The simulator has already
+	// restored its slots, so the policy's keys can be read from them.
+	bool (*restore)(void *state, const Scheduler_t *sched, sched_stream_t *in);
+} sched_policy_t;
+
+// \return the policy implementing algorithm, NULL if the simulator doesn't support it
+const sched_policy_t *sched_policy_for(ScheduleAlgorithm_t algorithm);
+
+// \return the simulator clock, for policies whose keys depend on time
+uint64_t sched_clock(const Scheduler_t *sched);
+
+// \return the number of CPUs, several slots can be running at once
+size_t sched_cpu_count(const Scheduler_t *sched);
+
+// \return the slot on cpu, SIZE_MAX when idle. While a slot is being requeued it is still the running one.
+size_t sched_running_on(const Scheduler_t *sched, size_t cpu);
+
+// \return the clock at which running slot is done switching in, later than sched_clock during the switch
+uint64_t sched_run_start(const Scheduler_t *sched, size_t slot);
+
+// \return ticks running slot has run its burst since it was dispatched, context switch overhead excluded
+uint64_t sched_ran(const Scheduler_t *sched, size_t slot);
+
+// \return the job in slot, for policies reading their keys
+const sched_job_t *sched_job(const Scheduler_t *sched, size_t slot);
+
+// Ties between equal policy keys go to the earlier arrival, then the earlier submission
+bool sched_job_fifo_before(const sched_job_t *a, const sched_job_t *b);
+
+#endif
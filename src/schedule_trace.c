@@ -0,0 +1,378 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "schedule_trace.h"
+
+// Big enough that a traced run only hits write() every few thousand records
+#define TRACE_BUFFER_SIZE (1 << 16)
+
+// A LEB128 encoded uint64_t never takes more than 10 bytes
+#define TRACE_VARINT_MAX 10
+
+// Largest record: tag + 5 varints
+#define TRACE_RECORD_MAX (1 + 5 * TRACE_VARINT_MAX)
+
+// What the writer keeps per CPU
+typedef struct
+{
+	bool pending;			// a slice is being extended
+	uint32_t pending_pid;
+	uint64_t pending_start;
+	uint64_t pending_length;
+	uint64_t last_end;		// end of the last slice written, the CPU's slices are delta encoded against it
+} trace_cpu_t;
+
+struct schedule_trace
+{
+	int fd;
+	bool failed;			// sticky, reported by close
+	trace_cpu_t *cpus;		// grown to the highest CPU seen
+	size_t cpu_count;
+	size_t length;
+	uint8_t buffer[TRACE_BUFFER_SIZE];
+};
+
+struct schedule_trace_reader
+{
+	int fd;
+	uint64_t *last_ends;	// per CPU, grown to the highest CPU seen
+	size_t cpu_count;
+	size_t offset;
+	size_t length;
+	uint8_t buffer[TRACE_BUFFER_SIZE];
+};
+
+static void trace_flush(ScheduleTrace_t *trace)
+{
+	size_t written = 0;
+	while (!trace->failed && written < trace->length)
+	{
+		ssize_t put = write(trace->fd, trace->buffer + written, trace->length - written);
+		if (put <= 0)
+		{
+			trace->failed = true;
+		}
+		else
+		{
+			written += (size_t)put;
+		}
+	}
+	trace->length = 0;
+}
+
+// Makes sure a whole record fits so the encoders below never check bounds
+static uint8_t *trace_reserve(ScheduleTrace_t *trace)
+{
+	if (TRACE_BUFFER_SIZE - trace->length < TRACE_RECORD_MAX)
+	{
+		trace_flush(trace);
+	}
+	return trace->buffer + trace->length;
+}
+
+static uint8_t *put_varint(uint8_t *out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		*out++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8_t)value;
+	return out;
+}
+
+static void trace_write_pending(ScheduleTrace_t *trace, const size_t cpu)
+{
+	trace_cpu_t *const state = &trace->cpus[cpu];
+	if (!state->pending)
+	{
+		return;
+	}
+
+	uint8_t *const start = trace_reserve(trace);
+	uint8_t *out = start;
+	*out++ = SCHEDULE_TRACE_SLICE;
+	out = put_varint(out, state->pending_pid);
+	out = put_varint(out, cpu);
+	out = put_varint(out, state->pending_start - state->last_end);
+	out = put_varint(out, state->pending_length);
+	trace->length += (size_t)(out - start);
+
+	state->last_end = state->pending_start + state->pending_length;
+	state->pending = false;
+}
+
+// Grows the per CPU state to hold cpu
+static bool trace_has_cpu(ScheduleTrace_t *trace, const uint32_t cpu)
+{
+	if (cpu < trace->cpu_count)
+	{
+		return true;
+	}
+	if (cpu >= SCHEDULE_TRACE_MAX_CPUS)
+	{
+		return false;
+	}
+	trace_cpu_t *cpus = (trace_cpu_t *)realloc(trace->cpus, ((size_t)cpu + 1) * sizeof(trace_cpu_t));
+	if (!cpus)
+	{
+		return false;
+	}
+	memset(cpus + trace->cpu_count, 0, ((size_t)cpu + 1 - trace->cpu_count) * sizeof(trace_cpu_t));
+	trace->cpus = cpus;
+	trace->cpu_count = (size_t)cpu + 1;
+	return true;
+}
+
+ScheduleTrace_t *schedule_trace_open(const char *output_file)
+{
+	if (!output_file)
+	{
+		return NULL;
+	}
+
+	ScheduleTrace_t *trace = (ScheduleTrace_t *)malloc(sizeof(ScheduleTrace_t));
+	if (!trace)
+	{
+		return NULL;
+	}
+
+	trace->fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (trace->fd == -1)
+	{
+		free(trace);
+		return NULL;
+	}
+
+	trace->failed = false;
+	trace->cpus = NULL;
+	trace->cpu_count = 0;
+
+	const uint32_t header[2] = {SCHEDULE_TRACE_MAGIC, SCHEDULE_TRACE_VERSION};
+	memcpy(trace->buffer, header, sizeof(header));
+	trace->length = sizeof(header);
+
+	return trace;
+}
+
+bool schedule_trace_close(ScheduleTrace_t *trace)
+{
+	if (!trace)
+	{
+		return true;
+	}
+
+	for (size_t cpu = 0; cpu < trace->cpu_count; ++cpu)
+	{
+		trace_write_pending(trace, cpu);
+	}
+	trace_flush(trace);
+
+	bool ok = !trace->failed;
+	ok = (close(trace->fd) == 0) && ok;
+	free(trace->cpus);
+	free(trace);
+	return ok;
+}
+
+void schedule_trace_slice(ScheduleTrace_t *trace, const uint32_t cpu, const uint32_t pid, const uint64_t start,
+						  const uint64_t length)
+{
+	if (!trace || length == 0)
+	{
+		return;
+	}
+	if (!trace_has_cpu(trace, cpu))
+	{
+		trace->failed = true;
+		return;
+	}
+
+	trace_cpu_t *const state = &trace->cpus[cpu];
+	if (state->pending && state->pending_pid == pid && state->pending_start + state->pending_length == start)
+	{
+		state->pending_length += length;
+		return;
+	}
+
+	trace_write_pending(trace, cpu);
+	state->pending = true;
+	state->pending_pid = pid;
+	state->pending_start = start;
+	state->pending_length = length;
+}
+
+void schedule_trace_job(ScheduleTrace_t *trace, const uint32_t pid, const uint64_t arrival,
+						const uint64_t first_dispatch, const uint64_t completion, const uint64_t preemptions)
+{
+	if (!trace)
+	{
+		return;
+	}
+
+	// The job's last slice ends at completion, get it out first so it precedes the JOB record
+	for (size_t cpu = 0; cpu < trace->cpu_count; ++cpu)
+	{
+		if (trace->cpus[cpu].pending && trace->cpus[cpu].pending_pid == pid)
+		{
+			trace_write_pending(trace, cpu);
+		}
+	}
+
+	uint8_t *const start = trace_reserve(trace);
+	uint8_t *out = start;
+	*out++ = SCHEDULE_TRACE_JOB;
+	out = put_varint(out, pid);
+	out = put_varint(out, arrival);
+	out = put_varint(out, first_dispatch - arrival);
+	out = put_varint(out, completion - first_dispatch);
+	out = put_varint(out, preemptions);
+	trace->length += (size_t)(out - start);
+}
+
+
+
+
+ScheduleTraceReader_t *schedule_trace_reader_open(const char *input_file)
+{
+	if (!input_file)
+	{
+		return NULL;
+	}
+
+	ScheduleTraceReader_t *reader = (ScheduleTraceReader_t *)malloc(sizeof(ScheduleTraceReader_t));
+	if (!reader)
+	{
+		return NULL;
+	}
+
+	reader->fd = open(input_file, O_RDONLY);
+	if (reader->fd == -1)
+	{
+		free(reader);
+		return NULL;
+	}
+
+	reader->last_ends = NULL;
+	reader->cpu_count = 0;
+	reader->offset = 0;
+	reader->length = 0;
+
+	uint32_t header[2];
+	if (read(reader->fd, header, sizeof(header)) != (ssize_t)sizeof(header) ||
+			header[0] != SCHEDULE_TRACE_MAGIC || header[1] != SCHEDULE_TRACE_VERSION)
+	{
+		schedule_trace_reader_close(reader);
+		return NULL;
+	}
+
+	return reader;
+}
+
+static bool reader_byte(ScheduleTraceReader_t *reader, uint8_t *byte)
+{
+	if (reader->offset == reader->length)
+	{
+		ssize_t got = read(reader->fd, reader->buffer, TRACE_BUFFER_SIZE);
+		if (got <= 0)
+		{
+			return false;
+		}
+		reader->offset = 0;
+		reader->length = (size_t)got;
+	}
+	*byte = reader->buffer[reader->offset++];
+	return true;
+}
+
+static bool reader_varint(ScheduleTraceReader_t *reader, uint64_t *value)
+{
+	uint64_t result = 0;
+	for (unsigned shift = 0; shift < 7 * TRACE_VARINT_MAX; shift += 7)
+	{
+		uint8_t byte;
+		if (!reader_byte(reader, &byte))
+		{
+			return false;
+		}
+		result |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			*value = result;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool schedule_trace_reader_next(ScheduleTraceReader_t *reader, ScheduleTraceRecord_t *record)
+{
+	if (!reader || !record)
+	{
+		return false;
+	}
+
+	uint8_t tag;
+	uint64_t pid;
+	if (!reader_byte(reader, &tag) || !reader_varint(reader, &pid) || pid > UINT32_MAX)
+	{
+		return false;
+	}
+
+	memset(record, 0, sizeof(ScheduleTraceRecord_t));
+	record->pid = (uint32_t)pid;
+
+	if (tag == SCHEDULE_TRACE_SLICE)
+	{
+		uint64_t cpu, gap;
+		if (!reader_varint(reader, &cpu) || cpu >= SCHEDULE_TRACE_MAX_CPUS || !reader_varint(reader, &gap) ||
+				!reader_varint(reader, &record->length))
+		{
+			return false;
+		}
+		if (cpu >= reader->cpu_count)
+		{
+			uint64_t *last_ends = (uint64_t *)realloc(reader->last_ends, ((size_t)cpu + 1) * sizeof(uint64_t));
+			if (!last_ends)
+			{
+				return false;
+			}
+			memset(last_ends + reader->cpu_count, 0, ((size_t)cpu + 1 - reader->cpu_count) * sizeof(uint64_t));
+			reader->last_ends = last_ends;
+			reader->cpu_count = (size_t)cpu + 1;
+		}
+		record->type = SCHEDULE_TRACE_SLICE;
+		record->cpu = (uint32_t)cpu;
+		record->start = reader->last_ends[cpu] + gap;
+		reader->last_ends[cpu] = record->start + record->length;
+		return true;
+	}
+
+	if (tag == SCHEDULE_TRACE_JOB)
+	{
+		uint64_t wait, run;
+		if (!reader_varint(reader, &record->arrival) || !reader_varint(reader, &wait) ||
+				!reader_varint(reader, &run) || !reader_varint(reader, &record->preemptions))
+		{
+			return false;
+		}
+		record->type = SCHEDULE_TRACE_JOB;
+		record->first_dispatch = record->arrival + wait;
+		record->completion = record->first_dispatch + run;
+		return true;
+	}
+
+	return false;
+}
+
+void schedule_trace_reader_close(ScheduleTraceReader_t *reader)
+{
+	if (reader)
+	{
+		close(reader->fd);
+		free(reader->last_ends);
+		free(reader);
+	}
+}
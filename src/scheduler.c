@@ -0,0 +1,1484 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "index_heap.h"
+#include "op_count.h"
+#include "sched_policy.h"
+#include "scheduler.h"
+
+// Marks an idle CPU
+#define NO_SLOT SIZE_MAX
+
+// "SCK3", the trailing digit being the layout version
+#define CHECKPOINT_MAGIC 0x334B4353u
+
+// One read()/write() per this many bytes of checkpoint
+#define CHECKPOINT_BUFFER_SIZE (1 << 16)
+
+typedef struct
+{
+	uint64_t speed;				// work done per tick, SCHEDULE_SPEED_NOMINAL for a nominal CPU
+	size_t running;				// slot on this CPU, NO_SLOT when idle
+	uint64_t slice_end;			// clock at which the running slot's budget runs out
+	uint64_t run_start;			// clock at which the running slot is done switching in and runs its burst
+	bool arrivals_unchecked;	// slots arrived or woke since the running slot was last checked for preemption
+	size_t requeued;			// slot this CPU just handed back to the policy, NO_SLOT if none
+	uint64_t last_seq;			// PCB that last held this CPU, UINT64_MAX before the first dispatch
+} sched_cpu_t;
+
+struct scheduler
+{
+	const sched_policy_t *policy;
+	void *policy_state;
+	ScheduleTrace_t *trace;
+
+	dyn_array_t *jobs;			// sched_job_t, indexed by slot
+	uint32_t *restored_bursts;	// next_bursts of the PCBs read from a checkpoint, NULL if none
+	dyn_array_t *free_slots;	// size_t, slots of completed jobs waiting to be reused
+	index_heap_t *pending;		// slots with an arrival still in the future, earliest first
+	index_heap_t *io_queue;		// blocked slots waiting for the IO device, first come first served
+	index_heap_t *shed_order;	// ready slots, lowest priority first, only when shedding for admission
+
+	sched_cpu_t *cpus;
+	size_t cpu_count;
+	size_t busy_cpus;
+	SchedulePlacement_t placement;
+
+	uint64_t config_hash;		// checkpoints only resume under the config they were taken with
+
+	uint64_t clock;
+	uint64_t next_seq;
+	size_t io_running;			// slot using the IO device, NO_SLOT when idle
+	uint64_t io_end;			// clock at which its IO burst completes
+	uint64_t next_io_ticket;
+
+	uint64_t switch_cost;
+	uint64_t warmup_cost;
+	uint64_t warmup_decay;
+
+	size_t ready_capacity;		// 0 for unbounded
+	ScheduleAdmission_t admission;
+
+	uint64_t submitted;
+	uint64_t completed;
+	uint64_t ready;
+	uint64_t busy_time;
+	uint64_t io_busy_time;
+	uint64_t context_switches;
+	uint64_t switch_overhead;
+	uint64_t migrations;
+	uint64_t total_waiting_time;
+	uint64_t total_turnaround_time;
+	uint64_t missed_deadlines;
+	uint64_t total_lateness;
+	uint64_t rejected;
+	uint64_t dropped;
+	uint64_t time_at_capacity;
+};
+
+static sched_job_t *job_at(const Scheduler_t *sched, const size_t slot)
+{
+	return (sched_job_t *)dyn_array_at(sched->jobs, slot);
+}
+
+const sched_job_t *sched_job(const Scheduler_t *sched, size_t slot)
+{
+	return job_at(sched, slot);
+}
+
+uint64_t sched_clock(const Scheduler_t *sched)
+{
+	return sched->clock;
+}
+
+size_t sched_cpu_count(const Scheduler_t *sched)
+{
+	return sched->cpu_count;
+}
+
+size_t sched_running_on(const Scheduler_t *sched, size_t cpu)
+{
+	return sched->cpus[cpu].running;
+}
+
+uint64_t sched_run_start(const Scheduler_t *sched, size_t slot)
+{
+	return sched->cpus[job_at(sched, slot)->cpu].run_start;
+}
+
+uint64_t sched_ran(const Scheduler_t *sched, size_t slot)
+{
+	const uint64_t start = sched_run_start(sched, slot);
+	return sched->clock > start ? sched->clock - start : 0;
+}
+
+bool sched_job_fifo_before(const sched_job_t *a, const sched_job_t *b)
+{
+	if (a->pcb.arrival != b->pcb.arrival)
+	{
+		return a->pcb.arrival < b->pcb.arrival;
+	}
+	return a->seq < b->seq;
+}
+
+static bool pending_before(size_t a, size_t b, void *context)
+{
+	const Scheduler_t *sched = (const Scheduler_t *)context;
+	return sched_job_fifo_before(job_at(sched, a), job_at(sched, b));
+}
+
+static bool io_before(size_t a, size_t b, void *context)
+{
+	const Scheduler_t *sched = (const Scheduler_t *)context;
+	return job_at(sched, a)->io_ticket < job_at(sched, b)->io_ticket;
+}
+
+// The lowest priority first, ties to the later arrival
+static bool shed_before(size_t a, size_t b, void *context)
+{
+	const Scheduler_t *sched = (const Scheduler_t *)context;
+	const sched_job_t *job_a = job_at(sched, a);
+	const sched_job_t *job_b = job_at(sched, b);
+	if (job_a->pcb.priority != job_b->pcb.priority)
+	{
+		return job_a->pcb.priority > job_b->pcb.priority;
+	}
+	return sched_job_fifo_before(job_b, job_a);
+}
+
+static uint64_t hash_u64(uint64_t hash, const uint64_t value)
+{
+	for (size_t byte = 0; byte < sizeof(uint64_t); ++byte)
+	{
+		hash = (hash ^ ((value >> (8 * byte)) & 0xff)) * 0x100000001b3u;
+	}
+	return hash;
+}
+
+// FNV-1a over the config fields that shape the simulation, the trace sink left out
+static uint64_t hash_config(const ScheduleConfig_t *config, const size_t cpu_count)
+{
+	const uint64_t fields[] = {config->algorithm, config->quantum, config->aging_interval, config->levels,
+							   config->boost_interval, config->target_latency, config->min_granularity,
+							   config->switch_cost, config->warmup_cost, config->warmup_decay, cpu_count,
+							   config->placement, config->ready_capacity, config->admission};
+	uint64_t hash = 0xcbf29ce484222325u;
+	for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i)
+	{
+		hash = hash_u64(hash, fields[i]);
+	}
+	for (size_t i = 0; config->level_quanta && i < config->levels; ++i)
+	{
+		hash = hash_u64(hash, config->level_quanta[i]);
+	}
+	for (size_t i = 0; i < cpu_count; ++i)
+	{
+		hash = hash_u64(hash, config->cpu_speeds ? config->cpu_speeds[i] : SCHEDULE_SPEED_NOMINAL);
+	}
+	return hash;
+}
+
+uint64_t sched_config_hash(const ScheduleConfig_t *config)
+{
+	return hash_config(config, config->cpu_count > 0 ? config->cpu_count : 1);
+}
+
+static uint64_t saturating_add(const uint64_t a, const uint64_t b)
+{
+	return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+// Work units still to run, bursts are measured in nominal ticks
+static uint64_t work_for(const uint32_t burst)
+{
+	return (uint64_t)burst * SCHEDULE_SPEED_NOMINAL;
+}
+
+// Keeps the burst the policies see in step with the work left, rounding partial ticks up
+static void sync_remaining(sched_job_t *job)
+{
+	job->pcb.remaining_burst_time = (uint32_t)((job->work_left + SCHEDULE_SPEED_NOMINAL - 1) / SCHEDULE_SPEED_NOMINAL);
+}
+
+Scheduler_t *sched_create(const ScheduleConfig_t *config)
+{
+	if (!config || config->placement > SCHEDULE_PLACE_AFFINITY || config->admission > SCHEDULE_ADMIT_DROP_LOWEST)
+	{
+		return NULL;
+	}
+
+	const sched_policy_t *policy = sched_policy_for(config->algorithm);
+	if (!policy)
+	{
+		return NULL;
+	}
+
+	const size_t cpu_count = config->cpu_count ? config->cpu_count : 1;
+	for (size_t i = 0; config->cpu_speeds && i < cpu_count; ++i)
+	{
+		if (config->cpu_speeds[i] == 0)
+		{
+			return NULL;
+		}
+	}
+
+	Scheduler_t *sched = (Scheduler_t *)calloc(1, sizeof(Scheduler_t));
+	if (!sched)
+	{
+		return NULL;
+	}
+
+	sched->policy = policy;
+	sched->config_hash = hash_config(config, cpu_count);
+	sched->trace = config->trace;
+	sched->placement = config->placement;
+	sched->io_running = NO_SLOT;
+	sched->switch_cost = config->switch_cost;
+	sched->warmup_cost = config->warmup_cost;
+	sched->warmup_decay = config->warmup_decay;
+	sched->ready_capacity = config->ready_capacity;
+	sched->admission = config->admission;
+	sched->cpus = (sched_cpu_t *)calloc(cpu_count, sizeof(sched_cpu_t));
+	sched->jobs = dyn_array_create(0, sizeof(sched_job_t), NULL);
+	sched->free_slots = dyn_array_create(0, sizeof(size_t), NULL);
+	sched->pending = index_heap_create(0, pending_before, sched);
+	sched->io_queue = index_heap_create(0, io_before, sched);
+	const bool shedding = config->ready_capacity > 0 && config->admission == SCHEDULE_ADMIT_DROP_LOWEST;
+	if (shedding)
+	{
+		sched->shed_order = index_heap_create(0, shed_before, sched);
+	}
+
+	if (sched->cpus && sched->jobs && sched->free_slots && sched->pending && sched->io_queue &&
+			(sched->shed_order || !shedding))
+	{
+		sched->cpu_count = cpu_count;
+		for (size_t i = 0; i < cpu_count; ++i)
+		{
+			sched->cpus[i].speed = config->cpu_speeds ? config->cpu_speeds[i] : SCHEDULE_SPEED_NOMINAL;
+			sched->cpus[i].running = NO_SLOT;
+			sched->cpus[i].requeued = NO_SLOT;
+			sched->cpus[i].last_seq = UINT64_MAX;
+		}
+
+		sched->policy_state = policy->create(sched, config);
+		if (sched->policy_state)
+		{
+			return sched;
+		}
+	}
+
+	sched_destroy(sched);
+	return NULL;
+}
+
+void sched_destroy(Scheduler_t *sched)
+{
+	if (sched)
+	{
+		if (sched->policy_state)
+		{
+			sched->policy->destroy(sched->policy_state);
+		}
+		index_heap_destroy(sched->pending);
+		index_heap_destroy(sched->io_queue);
+		index_heap_destroy(sched->shed_order);
+		dyn_array_destroy(sched->free_slots);
+		dyn_array_destroy(sched->jobs);
+		free(sched->restored_bursts);
+		free(sched->cpus);
+		free(sched);
+	}
+}
+
+// Puts a slot that is done with the simulator on the free list
+static void release_slot(Scheduler_t *sched, const size_t slot)
+{
+	job_at(sched, slot)->state = JOB_FREE;
+	dyn_array_push_back(sched->free_slots, &slot);
+}
+
+bool sched_submit(Scheduler_t *sched, const ProcessControlBlock_t *pcb)
+{
+	if (!sched || !pcb || pcb->arrival < sched->clock || pcb->next_burst_count % 2 != 0 ||
+			(pcb->next_burst_count > 0 && !pcb->next_bursts))
+	{
+		return false;
+	}
+
+	sched_job_t job;
+	memset(&job, 0, sizeof(job));
+	job.pcb = *pcb;
+	job.pcb.started = false;
+	job.seq = sched->next_seq;
+	job.state = JOB_PENDING;
+	job.work_left = work_for(pcb->remaining_burst_time);
+	job.cpu_burst = pcb->remaining_burst_time;
+	for (uint32_t i = 1; i < pcb->next_burst_count; i += 2)
+	{
+		job.cpu_burst += pcb->next_bursts[i];
+	}
+	job.cpu = NO_SLOT;
+
+	// Reuse the slot of a completed job when there is one
+	size_t slot;
+	if (dyn_array_extract_back(sched->free_slots, &slot))
+	{
+		*job_at(sched, slot) = job;
+	}
+	else
+	{
+		slot = dyn_array_size(sched->jobs);
+		if (!dyn_array_push_back(sched->jobs, &job))
+		{
+			return false;
+		}
+	}
+
+	if (!index_heap_push(sched->pending, slot))
+	{
+		release_slot(sched, slot);
+		return false;
+	}
+
+	++sched->next_seq;
+	++sched->submitted;
+	return true;
+}
+
+static bool at_capacity(const Scheduler_t *sched)
+{
+	return sched->ready_capacity > 0 && sched->ready >= sched->ready_capacity;
+}
+
+// Hands slot to the policy's ready queue
+static bool enqueue(Scheduler_t *sched, const size_t slot, const sched_push_reason_t reason)
+{
+	if (!sched->policy->push(sched->policy_state, slot, reason) ||
+			(sched->shed_order && !index_heap_push(sched->shed_order, slot)))
+	{
+		return false;
+	}
+	++sched->ready;
+	return true;
+}
+
+// Accounts for slot having left the policy's ready queue
+static void dequeued(Scheduler_t *sched, const size_t slot)
+{
+	--sched->ready;
+	if (sched->shed_order)
+	{
+		index_heap_remove(sched->shed_order, slot);
+	}
+}
+
+// Evicts the lowest priority ready slot in favour of arrival when arrival ranks above it
+// \return true if there is room for arrival now else false
+static bool shed_for(Scheduler_t *sched, const size_t arrival)
+{
+	size_t victim;
+	if (sched->admission != SCHEDULE_ADMIT_DROP_LOWEST || !index_heap_peek(sched->shed_order, &victim) ||
+			job_at(sched, arrival)->pcb.priority >= job_at(sched, victim)->pcb.priority)
+	{
+		return false;
+	}
+	sched->policy->remove(sched->policy_state, victim);
+	dequeued(sched, victim);
+	release_slot(sched, victim);
+	++sched->dropped;
+	return true;
+}
+
+// Moves every pending slot whose arrival has come into the policy's ready queue, as far as the
+// admission policy lets it. A delayed slot holds back the arrivals behind it.
+// \param overdue_only only take the slots that arrived before the current tick
+// \return number of slots admitted, SIZE_MAX on error
+static size_t admit_arrivals(Scheduler_t *sched, const bool overdue_only)
+{
+	size_t admitted = 0;
+	size_t slot;
+	while (index_heap_peek(sched->pending, &slot) && (job_at(sched, slot)->pcb.arrival < sched->clock ||
+				(!overdue_only && job_at(sched, slot)->pcb.arrival == sched->clock)))
+	{
+		if (at_capacity(sched) && sched->admission == SCHEDULE_ADMIT_DELAY)
+		{
+			break;
+		}
+		index_heap_pop(sched->pending, &slot);
+		if (at_capacity(sched) && !shed_for(sched, slot))
+		{
+			release_slot(sched, slot);
+			++sched->rejected;
+			continue;
+		}
+
+		job_at(sched, slot)->state = JOB_READY;
+		if (!enqueue(sched, slot, SCHED_PUSH_ARRIVED))
+		{
+			return SIZE_MAX;
+		}
+		++admitted;
+	}
+	return admitted;
+}
+
+// Starts the first queued IO burst if the device is free
+static void start_io(Scheduler_t *sched)
+{
+	size_t slot;
+	if (sched->io_running == NO_SLOT && index_heap_pop(sched->io_queue, &slot))
+	{
+		const sched_job_t *job = job_at(sched, slot);
+		sched->io_running = slot;
+		sched->io_end = sched->clock + job->pcb.next_bursts[job->next_burst];
+	}
+}
+
+// Hands every slot whose IO burst is over back to the policy, with its next CPU burst
+// \return number of slots woken, SIZE_MAX on error
+static size_t finish_io(Scheduler_t *sched)
+{
+	size_t woken = 0;
+	while (sched->io_running != NO_SLOT && sched->io_end <= sched->clock)
+	{
+		const size_t slot = sched->io_running;
+		sched_job_t *job = job_at(sched, slot);
+		sched->io_busy_time += job->pcb.next_bursts[job->next_burst];
+		job->pcb.remaining_burst_time = job->pcb.next_bursts[job->next_burst + 1];
+		job->work_left = work_for(job->pcb.remaining_burst_time);
+		job->next_burst += 2;
+		job->state = JOB_READY;
+		sched->io_running = NO_SLOT;
+
+		if (!enqueue(sched, slot, SCHED_PUSH_WOKEN))
+		{
+			return SIZE_MAX;
+		}
+		++woken;
+		start_io(sched);
+	}
+	return woken;
+}
+
+// Clock at which the running slot's budget runs out, a zero budget still runs for a tick.
+// The budget starts once the slot is switched in.
+static uint64_t slice_end_for(const Scheduler_t *sched, const sched_cpu_t *cpu)
+{
+	const uint64_t start = sched->clock > cpu->run_start ? sched->clock : cpu->run_start;
+	uint64_t budget = UINT64_MAX;
+	if (sched->policy->budget)
+	{
+		budget = sched->policy->budget(sched->policy_state, cpu->running);
+		if (budget == 0)
+		{
+			budget = 1;
+		}
+	}
+	return saturating_add(start, budget);
+}
+
+// Switch overhead for putting job on cpu: the fixed cost plus refilling the cache, which has decayed
+// in proportion to how long the job was away. A job that never ran, or last ran on another CPU,
+// starts fully cold.
+static uint64_t switch_overhead_for(const Scheduler_t *sched, const sched_job_t *job, const size_t cpu)
+{
+	uint64_t warmup = sched->warmup_cost;
+	const uint64_t away = sched->clock - job->left_cpu;
+	if (job->pcb.started && job->cpu == cpu && sched->warmup_decay > 0 && away < sched->warmup_decay)
+	{
+		warmup = (uint64_t)((unsigned __int128)warmup * away / sched->warmup_decay);
+	}
+	return saturating_add(sched->switch_cost, warmup);
+}
+
+static void dispatch(Scheduler_t *sched, const size_t cpu_index, const size_t slot)
+{
+	sched_cpu_t *cpu = &sched->cpus[cpu_index];
+	sched_job_t *job = job_at(sched, slot);
+	cpu->run_start = sched->clock;
+	if (job->seq != cpu->last_seq)
+	{
+		const uint64_t overhead = switch_overhead_for(sched, job, cpu_index);
+		cpu->run_start = saturating_add(sched->clock, overhead);
+		sched->switch_overhead += overhead;
+		++sched->context_switches;
+		cpu->last_seq = job->seq;
+	}
+	if (job->pcb.started && job->cpu != cpu_index)
+	{
+		++sched->migrations;
+	}
+
+	job->state = JOB_RUNNING;
+	job->cpu = cpu_index;
+	if (!job->pcb.started)
+	{
+		job->pcb.started = true;
+		job->first_dispatch = sched->clock;
+	}
+
+	cpu->running = slot;
+	cpu->arrivals_unchecked = false;
+	++sched->busy_cpus;
+	cpu->slice_end = slice_end_for(sched, cpu);
+}
+
+// Empties cpu, the slot it ran must already be accounted for elsewhere
+static void vacate(Scheduler_t *sched, sched_cpu_t *cpu)
+{
+	cpu->running = NO_SLOT;
+	--sched->busy_cpus;
+}
+
+// Hands the slot running on cpu back to the policy, leaving the CPU idle for the next pick.
+// Picking the same slot again is a fresh budget, not a preemption.
+static bool requeue_running(Scheduler_t *sched, sched_cpu_t *cpu, const sched_push_reason_t reason)
+{
+	const size_t previous = cpu->running;
+	sched_job_t *job = job_at(sched, previous);
+	job->state = JOB_READY;
+	job->left_cpu = sched->clock;
+	if (!enqueue(sched, previous, reason))
+	{
+		return false;
+	}
+	cpu->requeued = previous;
+	vacate(sched, cpu);
+	return true;
+}
+
+// Sends the slot running on cpu, whose CPU burst just ended, to wait for the IO device
+static bool block_running(Scheduler_t *sched, sched_cpu_t *cpu)
+{
+	const size_t slot = cpu->running;
+	sched_job_t *job = job_at(sched, slot);
+	if (sched->policy->stopped)
+	{
+		sched->policy->stopped(sched->policy_state, slot);
+	}
+
+	job->state = JOB_BLOCKED;
+	job->left_cpu = sched->clock;
+	job->io_ticket = sched->next_io_ticket++;
+	if (!index_heap_push(sched->io_queue, slot))
+	{
+		return false;
+	}
+	vacate(sched, cpu);
+	start_io(sched);
+	return true;
+}
+
+static void complete_running(Scheduler_t *sched, sched_cpu_t *cpu)
+{
+	const size_t slot = cpu->running;
+	sched_job_t *job = job_at(sched, slot);
+	if (sched->policy->stopped)
+	{
+		sched->policy->stopped(sched->policy_state, slot);
+	}
+
+	sched->total_waiting_time += job->first_dispatch - job->pcb.arrival;
+	if (sched->policy->wait_adds_time_off_cpu)
+	{
+		// Fast CPUs can finish in fewer ticks than the burst, there is no time off the CPU to add then
+		const uint64_t turnaround = sched->clock - job->pcb.arrival;
+		sched->total_waiting_time += turnaround > job->cpu_burst ? turnaround - job->cpu_burst : 0;
+	}
+	sched->total_turnaround_time += sched->clock - job->pcb.arrival;
+	++sched->completed;
+	if (job->pcb.deadline != PCB_NO_DEADLINE && sched->clock > job->pcb.deadline)
+	{
+		++sched->missed_deadlines;
+		sched->total_lateness += sched->clock - job->pcb.deadline;
+	}
+
+	schedule_trace_job(sched->trace, job->pcb.pid, job->pcb.arrival, job->first_dispatch, sched->clock,
+					   job->preemptions);
+
+	release_slot(sched, slot);
+	vacate(sched, cpu);
+}
+
+// Whether CPU a suits slot better than CPU b under the placement policy. CPUs of equal speed go
+// by index, an affine slot prefers the CPU it last ran on and is otherwise placed like fastest.
+static bool placed_before(const Scheduler_t *sched, const size_t slot, const size_t a, const size_t b)
+{
+	if (sched->placement == SCHEDULE_PLACE_AFFINITY)
+	{
+		const size_t last = job_at(sched, slot)->cpu;
+		if ((a == last) != (b == last))
+		{
+			return a == last;
+		}
+	}
+
+	const uint64_t speed_a = sched->cpus[a].speed;
+	const uint64_t speed_b = sched->cpus[b].speed;
+	if (speed_a != speed_b)
+	{
+		return sched->placement == SCHEDULE_PLACE_ENERGY ? speed_a < speed_b : speed_a > speed_b;
+	}
+	return a < b;
+}
+
+// \return the idle CPU placement picks for slot, SIZE_MAX if every CPU is busy
+static size_t place_idle(const Scheduler_t *sched, const size_t slot)
+{
+	size_t best = SIZE_MAX;
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		if (sched->cpus[i].running == NO_SLOT && (best == SIZE_MAX || placed_before(sched, slot, i, best)))
+		{
+			best = i;
+		}
+	}
+	return best;
+}
+
+// \return the CPU placement picks for candidate among those whose running slot it displaces,
+// SIZE_MAX if none. CPUs still switching or not yet told about the arrivals are left alone.
+static size_t place_preempting(const Scheduler_t *sched, const size_t candidate)
+{
+	size_t best = SIZE_MAX;
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		const sched_cpu_t *cpu = &sched->cpus[i];
+		if (cpu->running != NO_SLOT && cpu->arrivals_unchecked && sched->clock >= cpu->run_start &&
+				sched->policy->before(sched->policy_state, candidate, cpu->running) &&
+				(best == SIZE_MAX || placed_before(sched, candidate, i, best)))
+		{
+			best = i;
+		}
+	}
+	return best;
+}
+
+// Hands the policy's picks to the idle CPUs. A requeued slot that didn't get a CPU back was preempted.
+static void fill_idle_cpus(Scheduler_t *sched)
+{
+	size_t slot;
+	while (sched->busy_cpus < sched->cpu_count && sched->policy->pop(sched->policy_state, &slot))
+	{
+		dequeued(sched, slot);
+		dispatch(sched, place_idle(sched, slot), slot);
+	}
+
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		sched_cpu_t *cpu = &sched->cpus[i];
+		if (cpu->requeued != NO_SLOT)
+		{
+			sched_job_t *job = job_at(sched, cpu->requeued);
+			if (job->state != JOB_RUNNING || job->cpu != i)
+			{
+				++job->preemptions;
+			}
+			cpu->requeued = NO_SLOT;
+		}
+	}
+}
+
+// Lets the best waiting slots displace running ones, one CPU at a time, until none does.
+// The CPUs that keep their slot get their budget recomputed as the newcomers may catch up later instead.
+static bool preempt_on_arrivals(Scheduler_t *sched)
+{
+	// Peeking has side effects for some policies (MLFQ boosts), so don't unless there is something to check
+	bool unchecked = false;
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		const sched_cpu_t *cpu = &sched->cpus[i];
+		unchecked = unchecked || (cpu->running != NO_SLOT && cpu->arrivals_unchecked && sched->clock >= cpu->run_start);
+	}
+	if (!unchecked)
+	{
+		return true;
+	}
+
+	const sched_policy_t *policy = sched->policy;
+	for (size_t round = 0; round < sched->cpu_count; ++round)
+	{
+		size_t candidate;
+		if (!policy->peek(sched->policy_state, &candidate))
+		{
+			break;
+		}
+		const size_t victim = place_preempting(sched, candidate);
+		if (victim == SIZE_MAX)
+		{
+			break;
+		}
+		if (!requeue_running(sched, &sched->cpus[victim], SCHED_PUSH_PREEMPTED))
+		{
+			return false;
+		}
+		policy->pop(sched->policy_state, &candidate);
+		dequeued(sched, candidate);
+		dispatch(sched, victim, candidate);
+		fill_idle_cpus(sched);
+	}
+
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		sched_cpu_t *cpu = &sched->cpus[i];
+		if (cpu->running != NO_SLOT && cpu->arrivals_unchecked && sched->clock >= cpu->run_start)
+		{
+			cpu->arrivals_unchecked = false;
+			if (policy->budget)
+			{
+				cpu->slice_end = slice_end_for(sched, cpu);
+			}
+		}
+	}
+	return true;
+}
+
+// Ticks cpu needs for the rest of its slot's burst
+static uint64_t ticks_to_finish(const sched_cpu_t *cpu, const sched_job_t *job)
+{
+	return job->work_left / cpu->speed + (job->work_left % cpu->speed != 0 ? 1 : 0);
+}
+
+// The event loop. Every iteration handles the decisions due at the current clock, then jumps
+// to the next event: completion or budget expiry on any CPU, the end of a context switch, the end
+// of the IO burst in progress, the next arrival (for policies that preempt on arrival, while the IO
+// device is busy, while a CPU is idle, or when the ready queue is bounded), or the target time. Slots finishing IO at a tick queue
+// ahead of that tick's arrivals. A context switch can't be interrupted: arrivals during it are only
+// checked for preemption once the incoming slot is switched in.
+// When drain is set it stops as soon as nothing is left to run instead of idling up to target.
+static bool run_until(Scheduler_t *sched, const uint64_t target, const bool drain)
+{
+	const sched_policy_t *policy = sched->policy;
+
+	for (;;)
+	{
+		OP_COUNT(OP_EVENTS);
+		// Arrivals held back while they couldn't change anything still queue ahead of this tick's wakeups
+		const size_t overdue = admit_arrivals(sched, true);
+		if (overdue == SIZE_MAX)
+		{
+			return false;
+		}
+		const size_t woken = finish_io(sched);
+		if (woken == SIZE_MAX)
+		{
+			return false;
+		}
+		const size_t admitted = admit_arrivals(sched, false);
+		if (admitted == SIZE_MAX)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < sched->cpu_count; ++i)
+		{
+			sched_cpu_t *cpu = &sched->cpus[i];
+			if (cpu->running == NO_SLOT)
+			{
+				continue;
+			}
+			cpu->arrivals_unchecked = cpu->arrivals_unchecked || overdue + admitted + woken > 0;
+			if (sched->clock >= cpu->run_start && sched->clock >= cpu->slice_end &&
+					!requeue_running(sched, cpu, SCHED_PUSH_EXPIRED))
+			{
+				return false;
+			}
+		}
+		fill_idle_cpus(sched);
+		if (policy->preempt_on_arrival && !preempt_on_arrivals(sched))
+		{
+			return false;
+		}
+
+		// Delayed arrivals wait for a dispatch to free a place, then are due right away
+		size_t next_slot;
+		uint64_t next_arrival = UINT64_MAX;
+		if (index_heap_peek(sched->pending, &next_slot) &&
+				!(at_capacity(sched) && sched->admission == SCHEDULE_ADMIT_DELAY))
+		{
+			next_arrival = job_at(sched, next_slot)->pcb.arrival;
+			if (next_arrival < sched->clock)
+			{
+				next_arrival = sched->clock;
+			}
+		}
+		const uint64_t next_io = sched->io_running != NO_SLOT ? sched->io_end : UINT64_MAX;
+
+		if (sched->busy_cpus == 0)
+		{
+			if (drain && index_heap_size(sched->pending) == 0 && sched->io_running == NO_SLOT)
+			{
+				return true;
+			}
+			const uint64_t next_event = next_arrival < next_io ? next_arrival : next_io;
+			if (next_event > target)
+			{
+				OP_COUNT_ADD(OP_TICKS, target - sched->clock);
+				sched->clock = target;
+				return true;
+			}
+			OP_COUNT_ADD(OP_TICKS, next_event - sched->clock);
+			sched->clock = next_event;
+			continue;
+		}
+
+		if (sched->clock >= target)
+		{
+			return true;
+		}
+
+		uint64_t stop = target;
+		for (size_t i = 0; i < sched->cpu_count; ++i)
+		{
+			const sched_cpu_t *cpu = &sched->cpus[i];
+			if (cpu->running == NO_SLOT)
+			{
+				continue;
+			}
+			uint64_t event = cpu->run_start;
+			if (sched->clock >= cpu->run_start)
+			{
+				event = saturating_add(sched->clock, ticks_to_finish(cpu, job_at(sched, cpu->running)));
+				if (event > cpu->slice_end)
+				{
+					event = cpu->slice_end;
+				}
+			}
+			if (stop > event)
+			{
+				stop = event;
+			}
+		}
+		// Arrivals are taken in time order whenever they could change a decision, queue against wakeups
+		// or fill the ready queue
+		if ((policy->preempt_on_arrival || next_io != UINT64_MAX || sched->busy_cpus < sched->cpu_count ||
+					sched->ready_capacity > 0) && stop > next_arrival)
+		{
+			stop = next_arrival;
+		}
+		if (stop > next_io)
+		{
+			stop = next_io;
+		}
+
+		// Consume the whole chunk at once on every CPU past its switch
+		const uint64_t ticks = stop - sched->clock;
+		OP_COUNT_ADD(OP_TICKS, ticks);
+		if (at_capacity(sched))
+		{
+			sched->time_at_capacity += ticks;
+		}
+		for (size_t i = 0; i < sched->cpu_count; ++i)
+		{
+			const sched_cpu_t *cpu = &sched->cpus[i];
+			if (cpu->running == NO_SLOT || sched->clock < cpu->run_start)
+			{
+				continue;
+			}
+			sched_job_t *job = job_at(sched, cpu->running);
+			const unsigned __int128 work = (unsigned __int128)ticks * cpu->speed;
+			job->work_left -= work < job->work_left ? (uint64_t)work : job->work_left;
+			sync_remaining(job);
+			sched->busy_time += ticks;
+			schedule_trace_slice(sched->trace, (uint32_t)i, job->pcb.pid, sched->clock, ticks);
+		}
+		sched->clock = stop;
+
+		for (size_t i = 0; i < sched->cpu_count; ++i)
+		{
+			sched_cpu_t *cpu = &sched->cpus[i];
+			if (cpu->running == NO_SLOT || sched->clock < cpu->run_start)
+			{
+				continue;
+			}
+			sched_job_t *job = job_at(sched, cpu->running);
+			if (job->work_left > 0)
+			{
+				continue;
+			}
+			if (job->next_burst < job->pcb.next_burst_count)
+			{
+				if (!block_running(sched, cpu))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				complete_running(sched, cpu);
+			}
+		}
+	}
+}
+
+bool sched_advance_to(Scheduler_t *sched, uint64_t time)
+{
+	if (!sched || time < sched->clock)
+	{
+		return false;
+	}
+	return run_until(sched, time, false);
+}
+
+bool sched_drain(Scheduler_t *sched)
+{
+	if (!sched)
+	{
+		return false;
+	}
+	return run_until(sched, UINT64_MAX, true);
+}
+
+bool sched_drain_until(Scheduler_t *sched, uint64_t time)
+{
+	if (!sched || time < sched->clock)
+	{
+		return false;
+	}
+	return run_until(sched, time, true);
+}
+
+bool sched_snapshot_metrics(const Scheduler_t *sched, ScheduleMetrics_t *metrics)
+{
+	if (!sched || !metrics)
+	{
+		return false;
+	}
+
+	metrics->clock = sched->clock;
+	metrics->submitted = sched->submitted;
+	metrics->completed = sched->completed;
+	metrics->ready = sched->ready;
+	metrics->pending = index_heap_size(sched->pending);
+	metrics->blocked = index_heap_size(sched->io_queue) + (sched->io_running != NO_SLOT ? 1 : 0);
+	metrics->busy_time = sched->busy_time;
+	metrics->io_busy_time = sched->io_busy_time;
+	metrics->migrations = sched->migrations;
+	metrics->total_waiting_time = sched->total_waiting_time;
+	metrics->total_turnaround_time = sched->total_turnaround_time;
+
+	const double completed = sched->completed ? (double)sched->completed : 1.0;
+	metrics->result.average_waiting_time = (double)sched->total_waiting_time / completed;
+	metrics->result.average_turnaround_time = (double)sched->total_turnaround_time / completed;
+	metrics->result.total_run_time = sched->clock;
+	metrics->result.missed_deadlines = sched->missed_deadlines;
+	metrics->result.total_lateness = sched->total_lateness;
+	metrics->result.context_switches = sched->context_switches;
+	metrics->result.switch_overhead = sched->switch_overhead;
+	metrics->result.rejected = sched->rejected;
+	metrics->result.dropped = sched->dropped;
+	metrics->result.time_at_capacity = sched->time_at_capacity;
+
+	const double elapsed = sched->clock ? (double)sched->clock : 1.0;
+	metrics->result.cpu_utilization = (double)sched->busy_time / (elapsed * (double)sched->cpu_count);
+	metrics->result.io_utilization = (double)sched->io_busy_time / elapsed;
+	metrics->result.throughput = (double)sched->completed / elapsed;
+	return true;
+}
+
+bool sched_run(const dyn_array_t *ready_queue, const ScheduleConfig_t *config, ScheduleResult_t *result)
+{
+	if (!ready_queue || !result || dyn_array_size(ready_queue) == 0)
+	{
+		return false;
+	}
+
+	Scheduler_t *sched = sched_create(config);
+	if (!sched)
+	{
+		return false;
+	}
+
+	// Input in arrival order, as loaded files usually are, is fed as the clock reaches each arrival, so
+	// completed PCBs free their slots for later ones and the slots follow the PCBs in the system instead
+	// of the whole input. Anything else is submitted up front and the pending heap orders it, which is
+	// the run's sort and is timed as one along with the check.
+	const size_t count = dyn_array_size(ready_queue);
+	const ProcessControlBlock_t *pcbs = (const ProcessControlBlock_t *)dyn_array_export(ready_queue);
+#ifndef OP_COUNTERS_DISABLED
+	const uint64_t sort_start = op_counters_clock();
+#endif
+	bool in_order = true;
+	for (size_t i = 1; in_order && i < count; ++i)
+	{
+		in_order = pcbs[i - 1].arrival <= pcbs[i].arrival;
+	}
+
+	bool ok = true;
+	for (size_t i = 0; ok && !in_order && i < count; ++i)
+	{
+		ok = sched_submit(sched, &pcbs[i]);
+	}
+#ifndef OP_COUNTERS_DISABLED
+	OP_COUNT_ADD(OP_SORT_NANOSECONDS, op_counters_clock() - sort_start);
+#endif
+
+	for (size_t i = 0; ok && in_order && i < count; ++i)
+	{
+		if (pcbs[i].arrival > sched->clock + 1)
+		{
+			ok = sched_advance_to(sched, pcbs[i].arrival - 1);
+		}
+		ok = ok && sched_submit(sched, &pcbs[i]);
+	}
+
+	ScheduleMetrics_t metrics;
+	ok = ok && sched_drain(sched) && sched_snapshot_metrics(sched, &metrics);
+	if (ok)
+	{
+		*result = metrics.result;
+	}
+
+	sched_destroy(sched);
+	return ok;
+}
+
+//
+// Checkpoints
+//
+// Layout, native byte order: magic, config hash, input id, PCBs submitted, the engine counters, the CPUs, every slot
+// (its state, then the job with its IO bursts unless it is free), the free list, the policy's own state
+// and the magic again. The pending, IO and shedding heaps are rebuilt from the slot states.
+//
+
+struct sched_stream
+{
+	int fd;
+	bool failed;
+	size_t offset;
+	size_t length;
+	uint8_t buffer[CHECKPOINT_BUFFER_SIZE];
+};
+
+static bool stream_flush(sched_stream_t *stream)
+{
+	size_t written = 0;
+	while (!stream->failed && written < stream->length)
+	{
+		const ssize_t put = write(stream->fd, stream->buffer + written, stream->length - written);
+		if (put <= 0)
+		{
+			stream->failed = true;
+		}
+		else
+		{
+			written += (size_t)put;
+		}
+	}
+	stream->length = 0;
+	return !stream->failed;
+}
+
+bool sched_stream_write(sched_stream_t *stream, const void *src, size_t count)
+{
+	const uint8_t *in = (const uint8_t *)src;
+	while (!stream->failed && count > 0)
+	{
+		if (stream->length == CHECKPOINT_BUFFER_SIZE && !stream_flush(stream))
+		{
+			break;
+		}
+		size_t chunk = CHECKPOINT_BUFFER_SIZE - stream->length;
+		if (chunk > count)
+		{
+			chunk = count;
+		}
+		memcpy(stream->buffer + stream->length, in, chunk);
+		stream->length += chunk;
+		in += chunk;
+		count -= chunk;
+	}
+	return !stream->failed;
+}
+
+bool sched_stream_read(sched_stream_t *stream, void *dst, size_t count)
+{
+	uint8_t *out = (uint8_t *)dst;
+	while (!stream->failed && count > 0)
+	{
+		if (stream->offset == stream->length)
+		{
+			const ssize_t got = read(stream->fd, stream->buffer, CHECKPOINT_BUFFER_SIZE);
+			if (got <= 0)
+			{
+				stream->failed = true;
+				break;
+			}
+			stream->offset = 0;
+			stream->length = (size_t)got;
+		}
+		size_t chunk = stream->length - stream->offset;
+		if (chunk > count)
+		{
+			chunk = count;
+		}
+		memcpy(out, stream->buffer + stream->offset, chunk);
+		stream->offset += chunk;
+		out += chunk;
+		count -= chunk;
+	}
+	return !stream->failed;
+}
+
+static bool put_u64(sched_stream_t *out, const uint64_t value)
+{
+	return sched_stream_write(out, &value, sizeof(value));
+}
+
+static bool get_u64(sched_stream_t *in, uint64_t *value)
+{
+	return sched_stream_read(in, value, sizeof(*value));
+}
+
+bool sched_stream_read_waiting(sched_stream_t *stream, const Scheduler_t *sched, size_t *slot)
+{
+	uint64_t value;
+	if (!get_u64(stream, &value) || value >= dyn_array_size(sched->jobs) || job_at(sched, value)->state != JOB_READY)
+	{
+		return false;
+	}
+	*slot = (size_t)value;
+	return true;
+}
+
+#define CHECKPOINT_COUNTERS 18
+
+// The engine's counters in checkpoint order
+static void checkpoint_counters(Scheduler_t *sched, uint64_t *counters[CHECKPOINT_COUNTERS])
+{
+	uint64_t *const fields[CHECKPOINT_COUNTERS] = {
+		&sched->clock, &sched->next_seq, &sched->next_io_ticket, &sched->io_end, &sched->submitted,
+		&sched->completed, &sched->busy_time, &sched->io_busy_time, &sched->context_switches,
+		&sched->switch_overhead, &sched->migrations, &sched->total_waiting_time, &sched->total_turnaround_time,
+		&sched->missed_deadlines, &sched->total_lateness, &sched->rejected, &sched->dropped,
+		&sched->time_at_capacity
+	};
+	memcpy(counters, fields, sizeof(fields));
+}
+
+static bool put_job(sched_stream_t *out, const sched_job_t *job)
+{
+	const ProcessControlBlock_t *pcb = &job->pcb;
+	const uint8_t started = pcb->started;
+	return sched_stream_write(out, &pcb->remaining_burst_time, sizeof(uint32_t)) &&
+		sched_stream_write(out, &pcb->priority, sizeof(uint32_t)) && put_u64(out, pcb->arrival) &&
+		sched_stream_write(out, &started, sizeof(uint8_t)) && sched_stream_write(out, &pcb->pid, sizeof(uint32_t)) &&
+		put_u64(out, pcb->deadline) && sched_stream_write(out, &pcb->next_burst_count, sizeof(uint32_t)) &&
+		sched_stream_write(out, pcb->next_bursts, pcb->next_burst_count * sizeof(uint32_t)) &&
+		put_u64(out, job->seq) && put_u64(out, job->first_dispatch) && put_u64(out, job->preemptions) &&
+		sched_stream_write(out, &job->next_burst, sizeof(uint32_t)) && put_u64(out, job->io_ticket) &&
+		put_u64(out, job->left_cpu) && put_u64(out, job->work_left) && put_u64(out, job->cpu_burst) &&
+		put_u64(out, job->cpu);
+}
+
+// Reads a job whose IO bursts go to the restored burst storage at *burst_used, which is moved past them
+static bool get_job(sched_stream_t *in, Scheduler_t *sched, sched_job_t *job, size_t *burst_used,
+					const size_t burst_total)
+{
+	ProcessControlBlock_t *pcb = &job->pcb;
+	uint8_t started;
+	if (!sched_stream_read(in, &pcb->remaining_burst_time, sizeof(uint32_t)) ||
+			!sched_stream_read(in, &pcb->priority, sizeof(uint32_t)) || !get_u64(in, &pcb->arrival) ||
+			!sched_stream_read(in, &started, sizeof(uint8_t)) || !sched_stream_read(in, &pcb->pid, sizeof(uint32_t)) ||
+			!get_u64(in, &pcb->deadline) || !sched_stream_read(in, &pcb->next_burst_count, sizeof(uint32_t)) ||
+			pcb->next_burst_count % 2 != 0 || pcb->next_burst_count > burst_total - *burst_used)
+	{
+		return false;
+	}
+	pcb->started = started != 0;
+	pcb->next_bursts = NULL;
+	if (pcb->next_burst_count > 0)
+	{
+		pcb->next_bursts = sched->restored_bursts + *burst_used;
+		if (!sched_stream_read(in, sched->restored_bursts + *burst_used, pcb->next_burst_count * sizeof(uint32_t)))
+		{
+			return false;
+		}
+		*burst_used += pcb->next_burst_count;
+	}
+
+	uint64_t cpu;
+	if (!get_u64(in, &job->seq) || !get_u64(in, &job->first_dispatch) || !get_u64(in, &job->preemptions) ||
+			!sched_stream_read(in, &job->next_burst, sizeof(uint32_t)) || job->next_burst > pcb->next_burst_count ||
+			!get_u64(in, &job->io_ticket) || !get_u64(in, &job->left_cpu) || !get_u64(in, &job->work_left) ||
+			!get_u64(in, &job->cpu_burst) || !get_u64(in, &cpu) || (cpu >= sched->cpu_count && cpu != NO_SLOT))
+	{
+		return false;
+	}
+	job->cpu = (size_t)cpu;
+	return true;
+}
+
+static bool save_state(const Scheduler_t *sched, sched_stream_t *out, const uint64_t input_id,
+					   const uint64_t pcbs_submitted)
+{
+	const uint32_t magic = CHECKPOINT_MAGIC;
+	bool ok = sched_stream_write(out, &magic, sizeof(magic)) && put_u64(out, sched->config_hash) &&
+		put_u64(out, input_id) && put_u64(out, pcbs_submitted);
+
+	// Only read through, the table is shared with restore_state
+	uint64_t *counters[CHECKPOINT_COUNTERS];
+	checkpoint_counters((Scheduler_t *)sched, counters);
+	for (size_t i = 0; ok && i < CHECKPOINT_COUNTERS; ++i)
+	{
+		ok = put_u64(out, *counters[i]);
+	}
+	ok = ok && put_u64(out, sched->io_running);
+
+	for (size_t i = 0; ok && i < sched->cpu_count; ++i)
+	{
+		const sched_cpu_t *cpu = &sched->cpus[i];
+		const uint8_t unchecked = cpu->arrivals_unchecked;
+		ok = put_u64(out, cpu->running) && put_u64(out, cpu->slice_end) && put_u64(out, cpu->run_start) &&
+			sched_stream_write(out, &unchecked, sizeof(uint8_t)) && put_u64(out, cpu->last_seq);
+	}
+
+	const size_t slots = dyn_array_size(sched->jobs);
+	uint64_t burst_total = 0;
+	for (size_t slot = 0; slot < slots; ++slot)
+	{
+		const sched_job_t *job = job_at(sched, slot);
+		burst_total += job->state != JOB_FREE ? job->pcb.next_burst_count : 0;
+	}
+	ok = ok && put_u64(out, slots) && put_u64(out, burst_total);
+	for (size_t slot = 0; ok && slot < slots; ++slot)
+	{
+		const sched_job_t *job = job_at(sched, slot);
+		const uint32_t state = job->state;
+		ok = sched_stream_write(out, &state, sizeof(state)) && (job->state == JOB_FREE || put_job(out, job));
+	}
+
+	const size_t free_count = dyn_array_size(sched->free_slots);
+	ok = ok && put_u64(out, free_count);
+	for (size_t i = 0; ok && i < free_count; ++i)
+	{
+		ok = put_u64(out, *(const size_t *)dyn_array_at(sched->free_slots, i));
+	}
+
+	return ok && sched->policy->save(sched->policy_state, out) && sched_stream_write(out, &magic, sizeof(magic));
+}
+
+// Puts every restored slot back where its state says it waits
+static bool requeue_restored(Scheduler_t *sched)
+{
+	for (size_t slot = 0; slot < dyn_array_size(sched->jobs); ++slot)
+	{
+		const sched_job_t *job = job_at(sched, slot);
+		bool ok = true;
+		switch (job->state)
+		{
+			case JOB_PENDING:
+				ok = index_heap_push(sched->pending, slot);
+				break;
+			case JOB_READY:
+				ok = !sched->shed_order || index_heap_push(sched->shed_order, slot);
+				++sched->ready;
+				break;
+			case JOB_BLOCKED:
+				ok = slot == sched->io_running || index_heap_push(sched->io_queue, slot);
+				break;
+			case JOB_RUNNING:
+				ok = job->cpu < sched->cpu_count && sched->cpus[job->cpu].running == slot;
+				break;
+			case JOB_FREE:
+				break;
+		}
+		if (!ok)
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		const size_t running = sched->cpus[i].running;
+		if (running != NO_SLOT)
+		{
+			if (running >= dyn_array_size(sched->jobs) || job_at(sched, running)->state != JOB_RUNNING)
+			{
+				return false;
+			}
+			++sched->busy_cpus;
+		}
+	}
+	return sched->io_running == NO_SLOT ||
+		(sched->io_running < dyn_array_size(sched->jobs) && job_at(sched, sched->io_running)->state == JOB_BLOCKED);
+}
+
+static bool restore_state(Scheduler_t *sched, sched_stream_t *in, const uint64_t input_id, uint64_t *pcbs_submitted)
+{
+	uint32_t magic;
+	uint64_t config_hash;
+	uint64_t checkpoint_input;
+	if (!sched_stream_read(in, &magic, sizeof(magic)) || magic != CHECKPOINT_MAGIC || !get_u64(in, &config_hash) ||
+			config_hash != sched->config_hash || !get_u64(in, &checkpoint_input) || checkpoint_input != input_id ||
+			!get_u64(in, pcbs_submitted))
+	{
+		return false;
+	}
+
+	uint64_t *counters[CHECKPOINT_COUNTERS];
+	checkpoint_counters(sched, counters);
+	for (size_t i = 0; i < CHECKPOINT_COUNTERS; ++i)
+	{
+		if (!get_u64(in, counters[i]))
+		{
+			return false;
+		}
+	}
+
+	uint64_t value;
+	if (!get_u64(in, &value))
+	{
+		return false;
+	}
+	sched->io_running = (size_t)value;
+
+	for (size_t i = 0; i < sched->cpu_count; ++i)
+	{
+		sched_cpu_t *cpu = &sched->cpus[i];
+		uint8_t unchecked;
+		if (!get_u64(in, &value) || !get_u64(in, &cpu->slice_end) || !get_u64(in, &cpu->run_start) ||
+				!sched_stream_read(in, &unchecked, sizeof(uint8_t)) || !get_u64(in, &cpu->last_seq))
+		{
+			return false;
+		}
+		cpu->running = (size_t)value;
+		cpu->arrivals_unchecked = unchecked != 0;
+	}
+
+	uint64_t slots;
+	uint64_t burst_total;
+	if (!get_u64(in, &slots) || !get_u64(in, &burst_total) || burst_total > SIZE_MAX / sizeof(uint32_t))
+	{
+		return false;
+	}
+	if (burst_total > 0)
+	{
+		sched->restored_bursts = (uint32_t *)malloc((size_t)burst_total * sizeof(uint32_t));
+		if (!sched->restored_bursts)
+		{
+			return false;
+		}
+	}
+
+	size_t burst_used = 0;
+	for (uint64_t slot = 0; slot < slots; ++slot)
+	{
+		sched_job_t job;
+		uint32_t state;
+		memset(&job, 0, sizeof(job));
+		if (!sched_stream_read(in, &state, sizeof(state)) || state > JOB_BLOCKED)
+		{
+			return false;
+		}
+		job.state = (sched_job_state_t)state;
+		if ((job.state != JOB_FREE && !get_job(in, sched, &job, &burst_used, (size_t)burst_total)) ||
+				!dyn_array_push_back(sched->jobs, &job))
+		{
+			return false;
+		}
+	}
+
+	uint64_t free_count;
+	if (!get_u64(in, &free_count))
+	{
+		return false;
+	}
+	for (uint64_t i = 0; i < free_count; ++i)
+	{
+		size_t slot;
+		if (!get_u64(in, &value) || value >= slots || job_at(sched, value)->state != JOB_FREE)
+		{
+			return false;
+		}
+		slot = (size_t)value;
+		if (!dyn_array_push_back(sched->free_slots, &slot))
+		{
+			return false;
+		}
+	}
+
+	return requeue_restored(sched) && sched->policy->restore(sched->policy_state, sched, in) &&
+		sched_stream_read(in, &magic, sizeof(magic)) && magic == CHECKPOINT_MAGIC;
+}
+
+bool sched_checkpoint(const Scheduler_t *sched, const char *path, uint64_t input_id, uint64_t pcbs_submitted)
+{
+	if (!sched || !path)
+	{
+		return false;
+	}
+
+	// Written beside path and renamed over it, so path always holds a whole checkpoint
+	const size_t length = strlen(path);
+	char *partial = (char *)malloc(length + sizeof(".partial"));
+	sched_stream_t *out = (sched_stream_t *)malloc(sizeof(sched_stream_t));
+	if (!partial || !out)
+	{
+		free(partial);
+		free(out);
+		return false;
+	}
+	memcpy(partial, path, length);
+	memcpy(partial + length, ".partial", sizeof(".partial"));
+
+	out->failed = false;
+	out->offset = 0;
+	out->length = 0;
+	out->fd = open(partial, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	bool ok = out->fd != -1;
+	if (ok)
+	{
+		ok = save_state(sched, out, input_id, pcbs_submitted) && stream_flush(out) && fsync(out->fd) == 0;
+		ok = close(out->fd) == 0 && ok;
+		ok = ok && rename(partial, path) == 0;
+		if (!ok)
+		{
+			remove(partial);
+		}
+	}
+
+	free(partial);
+	free(out);
+	return ok;
+}
+
+Scheduler_t *sched_restore(const ScheduleConfig_t *config, const char *path, uint64_t input_id,
+						   uint64_t *pcbs_submitted)
+{
+	if (!path || !pcbs_submitted)
+	{
+		return NULL;
+	}
+
+	Scheduler_t *sched = sched_create(config);
+	sched_stream_t *in = (sched_stream_t *)malloc(sizeof(sched_stream_t));
+	bool ok = sched && in;
+	if (ok)
+	{
+		in->failed = false;
+		in->offset = 0;
+		in->length = 0;
+		in->fd = open(path, O_RDONLY);
+		ok = in->fd != -1;
+		if (ok)
+		{
+			ok = restore_state(sched, in, input_id, pcbs_submitted);
+			close(in->fd);
+		}
+	}
+
+	free(in);
+	if (!ok)
+	{
+		sched_destroy(sched);
+		return NULL;
+	}
+	return sched;
+}
@@ -0,0 +1,507 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_import.h"
+
+// Bytes of text read at a time, also the longest line parsed, longer ones are skipped
+#define READ_BUFFER_SIZE (1 << 20)
+
+#define MIN_TASKS 1024
+
+// Kernel prio of nice 0 is 120, the normal class starts at nice -20
+#define KERNEL_NORMAL_PRIO 100
+
+typedef struct
+{
+	uint32_t pid;
+	uint32_t priority;
+	bool used;
+	bool runnable;			// a PCB is open for it
+	bool running;
+	uint64_t arrival;		// ns it became runnable
+	uint64_t run_ns;		// ns it ran since
+	uint64_t run_start;		// ns it was last switched in
+} task_t;
+
+typedef struct
+{
+	task_t *tasks;			// open addressing by pid
+	size_t capacity;		// a power of 2
+	PcbWriter_t *writer;
+	uint64_t tick_ns;
+	bool started;			// origin is set
+	uint64_t origin;		// ns of the first event
+	uint64_t last;			// ns of the latest event
+	TraceImportStats_t stats;
+	bool failed;
+} importer_t;
+
+// Finds needle in [text, end). memchr, which libc vectorizes, skips straight to the candidates for its
+// first byte, so most of a line is never looked at byte by byte.
+static const char *find(const char *text, const char *end, const char *needle, const size_t length)
+{
+	while ((size_t)(end - text) >= length)
+	{
+		const char *hit = (const char *)memchr(text, needle[0], (size_t)(end - text) - length + 1);
+		if (!hit)
+		{
+			return NULL;
+		}
+		if (memcmp(hit, needle, length) == 0)
+		{
+			return hit;
+		}
+		text = hit + 1;
+	}
+	return NULL;
+}
+
+#define FIND(text, end, literal) find(text, end, literal, sizeof(literal) - 1)
+
+// \return the value after key= (key given with its leading space and =), NULL if the line has none
+static const char *field(const char *text, const char *end, const char *key, const size_t length)
+{
+	const char *hit = find(text, end, key, length);
+	return hit ? hit + length : NULL;
+}
+
+#define FIELD(text, end, literal) field(text, end, literal, sizeof(literal) - 1)
+
+static bool parse_u64(const char *text, const char *end, uint64_t *value)
+{
+	uint64_t result = 0;
+	const char *start = text;
+	while (text < end && *text >= '0' && *text <= '9')
+	{
+		const uint64_t digit = (uint64_t)(*text++ - '0');
+		if (result > (UINT64_MAX - digit) / 10)
+		{
+			return false;
+		}
+		result = result * 10 + digit;
+	}
+	*value = result;
+	return text > start;
+}
+
+// Maps a kernel prio (negative for deadline tasks) to a PCB priority
+static bool parse_priority(const char *text, const char *end, uint32_t *priority)
+{
+	const bool negative = text && text < end && *text == '-';
+	uint64_t prio;
+	if (!text || !parse_u64(text + negative, end, &prio))
+	{
+		return false;
+	}
+	*priority = negative || prio < KERNEL_NORMAL_PRIO ? 0 : (uint32_t)(prio - KERNEL_NORMAL_PRIO);
+	return true;
+}
+
+static bool parse_pid(const char *text, const char *end, uint32_t *pid)
+{
+	uint64_t value;
+	if (!text || !parse_u64(text, end, &value) || value > UINT32_MAX)
+	{
+		return false;
+	}
+	*pid = (uint32_t)value;
+	return true;
+}
+
+// Reads the "seconds.fraction:" stamp that ends right before the event name, in ns
+static bool parse_timestamp(const char *line, const char *event, uint64_t *ns)
+{
+	// perf prefixes the event with its subsystem
+	if (event - line >= 6 && memcmp(event - 6, "sched:", 6) == 0)
+	{
+		event -= 6;
+	}
+	while (event > line && event[-1] == ' ')
+	{
+		--event;
+	}
+	if (event == line || event[-1] != ':')
+	{
+		return false;
+	}
+	const char *stamp_end = event - 1;
+	const char *stamp = stamp_end;
+	while (stamp > line && ((stamp[-1] >= '0' && stamp[-1] <= '9') || stamp[-1] == '.'))
+	{
+		--stamp;
+	}
+
+	uint64_t seconds;
+	const char *dot = (const char *)memchr(stamp, '.', (size_t)(stamp_end - stamp));
+	if (!dot || !parse_u64(stamp, dot, &seconds) || seconds > UINT64_MAX / 1000000000u)
+	{
+		return false;
+	}
+	uint64_t fraction = 0;
+	size_t digits = 0;
+	for (const char *c = dot + 1; c < stamp_end; ++c)
+	{
+		if (*c < '0' || *c > '9')
+		{
+			return false;
+		}
+		// Past ns precision digits are dropped
+		if (digits < 9)
+		{
+			fraction = fraction * 10 + (uint64_t)(*c - '0');
+			++digits;
+		}
+	}
+	while (digits++ < 9)
+	{
+		fraction *= 10;
+	}
+	*ns = seconds * 1000000000u + fraction;
+	return true;
+}
+
+// \return the task of pid, added if it is new, NULL if the table can't grow
+static task_t *lookup(importer_t *importer, const uint32_t pid)
+{
+	size_t mask = importer->capacity - 1;
+	size_t i = (size_t)(pid * 2654435761u) & mask;
+	while (importer->tasks[i].used && importer->tasks[i].pid != pid)
+	{
+		i = (i + 1) & mask;
+	}
+	if (importer->tasks[i].used)
+	{
+		return &importer->tasks[i];
+	}
+
+	// Kept at most half full
+	if (2 * (importer->stats.tasks + 1) > importer->capacity)
+	{
+		const size_t capacity = importer->capacity * 2;
+		task_t *tasks = (task_t *)calloc(capacity, sizeof(task_t));
+		if (!tasks)
+		{
+			return NULL;
+		}
+		for (size_t k = 0; k < importer->capacity; ++k)
+		{
+			if (importer->tasks[k].used)
+			{
+				size_t j = (size_t)(importer->tasks[k].pid * 2654435761u) & (capacity - 1);
+				while (tasks[j].used)
+				{
+					j = (j + 1) & (capacity - 1);
+				}
+				tasks[j] = importer->tasks[k];
+			}
+		}
+		free(importer->tasks);
+		importer->tasks = tasks;
+		importer->capacity = capacity;
+		mask = capacity - 1;
+		i = (size_t)(pid * 2654435761u) & mask;
+		while (tasks[i].used)
+		{
+			i = (i + 1) & mask;
+		}
+	}
+
+	++importer->stats.tasks;
+	task_t *task = &importer->tasks[i];
+	memset(task, 0, sizeof(*task));
+	task->used = true;
+	task->pid = pid;
+	return task;
+}
+
+static void become_runnable(importer_t *importer, task_t *task, const uint64_t now)
+{
+	if (!task->runnable)
+	{
+		task->runnable = true;
+		task->arrival = now - importer->origin;
+		task->run_ns = 0;
+	}
+}
+
+// Writes the task's open PCB, a task that never ran has nothing to replay
+static void end_pcb(importer_t *importer, task_t *task)
+{
+	if (task->runnable && task->run_ns > 0)
+	{
+		const uint64_t ticks = (task->run_ns + importer->tick_ns / 2) / importer->tick_ns;
+		ProcessControlBlock_t pcb;
+		memset(&pcb, 0, sizeof(pcb));
+		pcb.remaining_burst_time = ticks == 0 ? 1 : ticks > UINT32_MAX ? UINT32_MAX : (uint32_t)ticks;
+		pcb.priority = task->priority;
+		pcb.arrival = task->arrival / importer->tick_ns;
+		pcb.deadline = PCB_NO_DEADLINE;
+		if (!pcb_writer_append(importer->writer, &pcb))
+		{
+			importer->failed = true;
+		}
+		++importer->stats.pcbs;
+	}
+	task->runnable = false;
+	task->running = false;
+}
+
+static void switch_out(importer_t *importer, task_t *task, const uint64_t now, const bool preempted)
+{
+	if (task->running)
+	{
+		task->run_ns += now > task->run_start ? now - task->run_start : 0;
+		task->running = false;
+	}
+	if (preempted)
+	{
+		become_runnable(importer, task, now);
+	}
+	else
+	{
+		end_pcb(importer, task);
+	}
+}
+
+// Reads the "comm:pid [prio]" form perf's event plugins print, taking the last " [" in [text, end) so
+// the comm may hold anything else
+// \param after destination for the end of the "]"
+static bool parse_compact_task(const char *text, const char *end, uint32_t *pid, uint32_t *priority,
+							   const char **after)
+{
+	const char *open = end;
+	while (open - text >= 2 && !(open[-2] == ' ' && open[-1] == '['))
+	{
+		--open;
+	}
+	if (open - text < 2)
+	{
+		return false;
+	}
+	const char *close = (const char *)memchr(open, ']', (size_t)(end - open));
+	const char *digits = open - 2;
+	while (digits > text && digits[-1] >= '0' && digits[-1] <= '9')
+	{
+		--digits;
+	}
+	if (!close || digits == text || digits[-1] != ':' || !parse_pid(digits, open - 2, pid) ||
+			!parse_priority(open, close, priority))
+	{
+		return false;
+	}
+	*after = close + 1;
+	return true;
+}
+
+// A wakeup as "comm=foo pid=1 prio=120 ..." or "foo:1 [120] ..."
+static bool parse_wakeup(const char *text, const char *end, uint32_t *pid, uint32_t *priority)
+{
+	const char *pid_field = FIELD(text, end, " pid=");
+	if (pid_field)
+	{
+		return parse_pid(pid_field, end, pid) && parse_priority(FIELD(text, end, " prio="), end, priority);
+	}
+	const char *after;
+	return parse_compact_task(text, end, pid, priority, &after);
+}
+
+// A switch as "prev_comm=a prev_pid=1 prev_prio=120 prev_state=S ==> next_comm=b next_pid=2 next_prio=120"
+// or "a:1 [120] S ==> b:2 [120]"
+static bool parse_switch(const char *text, const char *end, uint32_t pids[2], uint32_t priorities[2],
+						 char *state)
+{
+	const char *next = FIND(text, end, " ==> ");
+	if (!next)
+	{
+		return false;
+	}
+	const char *state_field = FIELD(text, next, " prev_state=");
+	if (state_field)
+	{
+		*state = *state_field;
+		return parse_pid(FIELD(text, next, " prev_pid="), next, &pids[0]) &&
+			parse_priority(FIELD(text, next, " prev_prio="), next, &priorities[0]) &&
+			parse_pid(FIELD(next, end, " next_pid="), end, &pids[1]) &&
+			parse_priority(FIELD(next, end, " next_prio="), end, &priorities[1]);
+	}
+
+	const char *after;
+	if (!parse_compact_task(text, next, &pids[0], &priorities[0], &after) || after == next)
+	{
+		return false;
+	}
+	while (after < next && *after == ' ')
+	{
+		++after;
+	}
+	*state = *after;
+	return parse_compact_task(next, end, &pids[1], &priorities[1], &after);
+}
+
+static void parse_line(importer_t *importer, const char *line, const char *end)
+{
+	++importer->stats.lines;
+
+	// The event name follows the timestamp's ':' and a space (ftrace), or perf's "sched:", so a comm that
+	// merely contains sched_ is passed over
+	const char *event = line;
+	bool is_switch = false;
+	bool is_wakeup = false;
+	const char *fields = NULL;
+	while (!is_switch && !is_wakeup && (event = FIND(event, end, "sched_")) != NULL)
+	{
+		const char *name = event + 6;
+		const bool named = event > line && (event[-1] == ' ' || event[-1] == ':');
+		if (named && end - name >= 7 && memcmp(name, "switch:", 7) == 0)
+		{
+			is_switch = true;
+			fields = name + 7;
+		}
+		else if (named && end - name >= 7 && memcmp(name, "wakeup:", 7) == 0)
+		{
+			is_wakeup = true;
+			fields = name + 7;
+		}
+		else if (named && end - name >= 11 && memcmp(name, "wakeup_new:", 11) == 0)
+		{
+			is_wakeup = true;
+			fields = name + 11;
+		}
+		else
+		{
+			event = name;
+		}
+	}
+	if (!event)
+	{
+		return;
+	}
+
+	uint64_t now;
+	uint32_t pids[2];
+	uint32_t priorities[2];
+	char state = 0;
+	if (!parse_timestamp(line, event, &now) ||
+			(is_wakeup ? !parse_wakeup(fields, end, &pids[0], &priorities[0]) :
+			 !parse_switch(fields, end, pids, priorities, &state)))
+	{
+		++importer->stats.skipped;
+		return;
+	}
+	++importer->stats.events;
+
+	if (!importer->started)
+	{
+		importer->started = true;
+		importer->origin = now;
+	}
+	// Events the tracer stamped before the first one are taken to happen at it
+	now = now < importer->origin ? importer->origin : now;
+	importer->last = now > importer->last ? now : importer->last;
+
+	task_t *task = pids[0] ? lookup(importer, pids[0]) : NULL;
+	importer->failed = importer->failed || (pids[0] && !task);
+	if (task && is_wakeup)
+	{
+		if (!task->runnable)
+		{
+			task->priority = priorities[0];
+			become_runnable(importer, task, now);
+		}
+		return;
+	}
+	if (task)
+	{
+		task->priority = priorities[0];
+		switch_out(importer, task, now, state == 'R');
+	}
+
+	task = pids[1] ? lookup(importer, pids[1]) : NULL;
+	importer->failed = importer->failed || (pids[1] && !task);
+	if (task)
+	{
+		task->priority = priorities[1];
+		become_runnable(importer, task, now);
+		task->running = true;
+		task->run_start = now;
+	}
+}
+
+bool trace_import(FILE *input, const char *output_file, const uint64_t tick_ns, const bool v1,
+				  TraceImportStats_t *stats)
+{
+	if (!input || !output_file || tick_ns == 0)
+	{
+		return false;
+	}
+
+	importer_t importer;
+	memset(&importer, 0, sizeof(importer));
+	importer.tick_ns = tick_ns;
+	importer.capacity = MIN_TASKS;
+	importer.tasks = (task_t *)calloc(MIN_TASKS, sizeof(task_t));
+	char *buffer = (char *)malloc(READ_BUFFER_SIZE);
+	importer.writer = pcb_writer_open(output_file, v1);
+	importer.failed = !importer.tasks || !buffer || !importer.writer;
+
+	size_t length = 0;
+	bool skipping = false;		// in a line longer than the buffer
+	while (!importer.failed)
+	{
+		const size_t got = fread(buffer + length, 1, READ_BUFFER_SIZE - length, input);
+		length += got;
+		const char *line = buffer;
+		const char *limit = buffer + length;
+		for (const char *newline; (newline = (const char *)memchr(line, '\n', (size_t)(limit - line))) != NULL;
+			 line = newline + 1)
+		{
+			if (skipping)
+			{
+				skipping = false;
+			}
+			else
+			{
+				parse_line(&importer, line, newline);
+			}
+		}
+
+		size_t rest = (size_t)(limit - line);
+		if (got == 0)
+		{
+			// The last line may lack its newline
+			if (rest > 0 && !skipping)
+			{
+				parse_line(&importer, line, limit);
+			}
+			break;
+		}
+		if (rest == READ_BUFFER_SIZE)
+		{
+			importer.stats.lines += !skipping;
+			importer.stats.skipped += !skipping;
+			skipping = true;
+			rest = 0;
+		}
+		memmove(buffer, line, rest);
+		length = rest;
+	}
+	importer.failed = importer.failed || ferror(input);
+
+	for (size_t i = 0; !importer.failed && i < importer.capacity; ++i)
+	{
+		task_t *task = &importer.tasks[i];
+		if (task->used && task->runnable)
+		{
+			switch_out(&importer, task, importer.last, false);
+		}
+	}
+
+	const bool ok = pcb_writer_close(importer.writer) && !importer.failed;
+	if (stats)
+	{
+		*stats = importer.stats;
+	}
+	free(importer.tasks);
+	free(buffer);
+	return ok;
+}
@@ -0,0 +1,517 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dyn_array.h"
+#include "scheduler.h"
+#include "what_if.h"
+
+// Empty subtree
+#define NIL SIZE_MAX
+
+/*
+	How the treap answers FCFS (and equal-arrival SJF) totals.
+
+	In dispatch order, job k starts at S_k = max(C_{k-1}, a_k) and completes at C_k = S_k + b_k.
+	Inside any run of jobs, with P_k the bursts up to and including k, feeding the run a completion
+	time x gives
+		C_k = max(x + P_k, max over j <= k of (a_j + P_k - P_{j-1}))
+	so everything depends on x only through gap = max over j of (a_j - P_{j-1}), the latest the
+	CPU can free up and still leave the run idle somewhere. If x >= gap, nothing in the run idles
+	and sum C_k = count * x + sum P_k. If x < gap, the run leaves at burst_sum + gap whatever x was.
+
+	Each node keeps those two aggregates for its subtree, plus the completion sum of itself and its
+	right subtree for the case where its left subtree idles (that input is then fixed). Summing
+	completions below a node then walks a single root-to-leaf path, and refreshing a node costs one
+	such walk, so an edit touching O(log n) nodes is O(log^2 n).
+*/
+
+typedef struct
+{
+	ProcessControlBlock_t pcb;
+	bool present;
+	uint32_t heap_priority;			// random, keeps the treap balanced
+	size_t left;
+	size_t right;
+
+	// Aggregates over the subtree, in dispatch order
+	uint64_t count;
+	uint64_t burst_sum;
+	int64_t gap;					// max over j of (a_j - bursts before j), >= 0
+	uint64_t prefix_sum;			// sum over k of the bursts up to and including k
+	uint64_t tail_completion_sum;	// with a left subtree: sum of C over this node and the right
+									// subtree given the left subtree's idle output
+} what_if_node_t;
+
+struct what_if
+{
+	ScheduleAlgorithm_t algorithm;
+	dyn_array_t *nodes;				// what_if_node_t, indexed by id
+	size_t root;
+	uint64_t rng;
+
+	uint64_t live;
+	uint64_t arrival_sum;
+	uint64_t burst_sum;
+
+	// SJF only: arrival shared by the PCBs and how many live PCBs don't have it
+	uint64_t release;
+	uint64_t off_release;
+
+	// SJF fallback: result of the last full run, valid until the next edit
+	bool cached;
+	ScheduleResult_t cache;
+};
+
+static what_if_node_t *node_at(const WhatIf_t *what_if, const size_t id)
+{
+	return (what_if_node_t *)dyn_array_at(what_if->nodes, id);
+}
+
+static uint32_t next_priority(WhatIf_t *what_if)
+{
+	// xorshift64
+	what_if->rng ^= what_if->rng << 13;
+	what_if->rng ^= what_if->rng >> 7;
+	what_if->rng ^= what_if->rng << 17;
+	return (uint32_t)(what_if->rng >> 32);
+}
+
+// Dispatch order: FCFS by arrival, SJF by burst, ties by id
+static bool key_before(const WhatIf_t *what_if, const size_t a, const size_t b)
+{
+	const ProcessControlBlock_t *pcb_a = &node_at(what_if, a)->pcb;
+	const ProcessControlBlock_t *pcb_b = &node_at(what_if, b)->pcb;
+	const uint64_t key_a = what_if->algorithm == SCHEDULE_FCFS ? pcb_a->arrival : pcb_a->remaining_burst_time;
+	const uint64_t key_b = what_if->algorithm == SCHEDULE_FCFS ? pcb_b->arrival : pcb_b->remaining_burst_time;
+
+	if (key_a != key_b)
+	{
+		return key_a < key_b;
+	}
+	return a < b;
+}
+
+// Sum of completion times of the subtree when the CPU frees up at x before it
+static uint64_t completion_sum(const WhatIf_t *what_if, size_t id, uint64_t x)
+{
+	uint64_t sum = 0;
+	while (id != NIL)
+	{
+		const what_if_node_t *node = node_at(what_if, id);
+		if ((int64_t)x >= node->gap)
+		{
+			return sum + node->count * x + node->prefix_sum;
+		}
+
+		if (node->left != NIL)
+		{
+			const what_if_node_t *left = node_at(what_if, node->left);
+			if ((int64_t)x < left->gap)
+			{
+				// The left subtree idles, so what follows it doesn't depend on x
+				sum += node->tail_completion_sum;
+				id = node->left;
+				continue;
+			}
+			sum += left->count * x + left->prefix_sum;
+			x += left->burst_sum;
+		}
+
+		const uint64_t start = x > node->pcb.arrival ? x : node->pcb.arrival;
+		x = start + node->pcb.remaining_burst_time;
+		sum += x;
+		id = node->right;
+	}
+	return sum;
+}
+
+static void pull(WhatIf_t *what_if, const size_t id)
+{
+	what_if_node_t *node = node_at(what_if, id);
+	const what_if_node_t *left = node->left != NIL ? node_at(what_if, node->left) : NULL;
+	const what_if_node_t *right = node->right != NIL ? node_at(what_if, node->right) : NULL;
+	const uint64_t burst = node->pcb.remaining_burst_time;
+	const uint64_t left_bursts = left ? left->burst_sum : 0;
+	const uint64_t through_self = left_bursts + burst;
+
+	node->count = 1 + (left ? left->count : 0) + (right ? right->count : 0);
+	node->burst_sum = through_self + (right ? right->burst_sum : 0);
+
+	node->gap = (int64_t)node->pcb.arrival - (int64_t)left_bursts;
+	if (left && left->gap > node->gap)
+	{
+		node->gap = left->gap;
+	}
+	if (right && right->gap - (int64_t)through_self > node->gap)
+	{
+		node->gap = right->gap - (int64_t)through_self;
+	}
+
+	node->prefix_sum = (left ? left->prefix_sum : 0) + through_self;
+	if (right)
+	{
+		node->prefix_sum += right->prefix_sum + right->count * through_self;
+	}
+
+	node->tail_completion_sum = 0;
+	if (left)
+	{
+		const uint64_t left_out = left_bursts + (uint64_t)left->gap;
+		const uint64_t start = left_out > node->pcb.arrival ? left_out : node->pcb.arrival;
+		const uint64_t completion = start + burst;
+		node->tail_completion_sum = completion + completion_sum(what_if, node->right, completion);
+	}
+}
+
+// Splits the subtree into the nodes ordered before key (and key itself when inclusive) and the rest
+static void split(WhatIf_t *what_if, const size_t id, const size_t key, const bool inclusive, size_t *before,
+				  size_t *after)
+{
+	if (id == NIL)
+	{
+		*before = NIL;
+		*after = NIL;
+		return;
+	}
+
+	what_if_node_t *node = node_at(what_if, id);
+	if (key_before(what_if, id, key) || (inclusive && id == key))
+	{
+		split(what_if, node->right, key, inclusive, &node->right, after);
+		*before = id;
+	}
+	else
+	{
+		split(what_if, node->left, key, inclusive, before, &node->left);
+		*after = id;
+	}
+	pull(what_if, id);
+}
+
+// Joins two subtrees where every node of a is ordered before every node of b
+static size_t merge(WhatIf_t *what_if, const size_t a, const size_t b)
+{
+	if (a == NIL)
+	{
+		return b;
+	}
+	if (b == NIL)
+	{
+		return a;
+	}
+
+	what_if_node_t *node_a = node_at(what_if, a);
+	what_if_node_t *node_b = node_at(what_if, b);
+	if (node_a->heap_priority > node_b->heap_priority)
+	{
+		node_a->right = merge(what_if, node_a->right, b);
+		pull(what_if, a);
+		return a;
+	}
+	node_b->left = merge(what_if, a, node_b->left);
+	pull(what_if, b);
+	return b;
+}
+
+static void track_add(WhatIf_t *what_if, const ProcessControlBlock_t *pcb)
+{
+	if (what_if->live == 0)
+	{
+		what_if->release = pcb->arrival;
+	}
+	++what_if->live;
+	what_if->arrival_sum += pcb->arrival;
+	what_if->burst_sum += pcb->remaining_burst_time;
+	if (pcb->arrival != what_if->release)
+	{
+		++what_if->off_release;
+	}
+	what_if->cached = false;
+}
+
+static void track_remove(WhatIf_t *what_if, const ProcessControlBlock_t *pcb)
+{
+	--what_if->live;
+	what_if->arrival_sum -= pcb->arrival;
+	what_if->burst_sum -= pcb->remaining_burst_time;
+	if (pcb->arrival != what_if->release)
+	{
+		--what_if->off_release;
+	}
+	what_if->cached = false;
+}
+
+static void link_node(WhatIf_t *what_if, const size_t id)
+{
+	size_t before, after;
+	split(what_if, what_if->root, id, false, &before, &after);
+	what_if->root = merge(what_if, merge(what_if, before, id), after);
+}
+
+static void unlink_node(WhatIf_t *what_if, const size_t id)
+{
+	// Everything before id, then id alone, then the rest
+	size_t before, rest, self, after;
+	split(what_if, what_if->root, id, false, &before, &rest);
+	split(what_if, rest, id, true, &self, &after);
+	what_if->root = merge(what_if, before, after);
+}
+
+typedef struct
+{
+	uint64_t key;
+	size_t id;
+} what_if_order_t;
+
+static int compare_order(const void *a, const void *b)
+{
+	const what_if_order_t *order_a = (const what_if_order_t *)a;
+	const what_if_order_t *order_b = (const what_if_order_t *)b;
+
+	if (order_a->key != order_b->key) return order_a->key < order_b->key ? -1 : 1;
+	if (order_a->id != order_b->id) return order_a->id < order_b->id ? -1 : 1;
+	return 0;
+}
+
+static void pull_subtree(WhatIf_t *what_if, const size_t id)
+{
+	if (id != NIL)
+	{
+		what_if_node_t *node = node_at(what_if, id);
+		pull_subtree(what_if, node->left);
+		pull_subtree(what_if, node->right);
+		pull(what_if, id);
+	}
+}
+
+// Builds the treap over the sorted ids in O(n) with the usual Cartesian tree stack
+static bool build(WhatIf_t *what_if, const what_if_order_t *order, const size_t n)
+{
+	size_t *stack = malloc(sizeof(size_t) * (n ? n : 1));
+	if (!stack)
+	{
+		return false;
+	}
+
+	size_t depth = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const size_t id = order[i].id;
+		what_if_node_t *node = node_at(what_if, id);
+		size_t last = NIL;
+		while (depth > 0 && node_at(what_if, stack[depth - 1])->heap_priority < node->heap_priority)
+		{
+			last = stack[--depth];
+		}
+		node->left = last;
+		if (depth > 0)
+		{
+			node_at(what_if, stack[depth - 1])->right = id;
+		}
+		stack[depth++] = id;
+	}
+
+	what_if->root = depth > 0 ? stack[0] : NIL;
+	free(stack);
+	pull_subtree(what_if, what_if->root);
+	return true;
+}
+
+WhatIf_t *what_if_create(const dyn_array_t *baseline, ScheduleAlgorithm_t algorithm)
+{
+	if (!baseline || (algorithm != SCHEDULE_FCFS && algorithm != SCHEDULE_SJF))
+	{
+		return NULL;
+	}
+
+	WhatIf_t *what_if = (WhatIf_t *)calloc(1, sizeof(WhatIf_t));
+	if (!what_if)
+	{
+		return NULL;
+	}
+
+	const size_t n = dyn_array_size(baseline);
+	what_if->algorithm = algorithm;
+	what_if->root = NIL;
+	what_if->rng = 0x9E3779B97F4A7C15ULL;
+	what_if->nodes = dyn_array_create(n, sizeof(what_if_node_t), NULL);
+	what_if_order_t *order = malloc(sizeof(what_if_order_t) * (n ? n : 1));
+	if (!what_if->nodes || !order)
+	{
+		free(order);
+		what_if_destroy(what_if);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (((const ProcessControlBlock_t *)dyn_array_at(baseline, i))->next_burst_count > 0)
+		{
+			free(order);
+			what_if_destroy(what_if);
+			return NULL;
+		}
+
+		what_if_node_t node;
+		memset(&node, 0, sizeof(node));
+		node.pcb = *(const ProcessControlBlock_t *)dyn_array_at(baseline, i);
+		node.present = true;
+		node.heap_priority = next_priority(what_if);
+		node.left = NIL;
+		node.right = NIL;
+		dyn_array_push_back(what_if->nodes, &node);
+		track_add(what_if, &node.pcb);
+
+		order[i].key = algorithm == SCHEDULE_FCFS ? node.pcb.arrival : node.pcb.remaining_burst_time;
+		order[i].id = i;
+	}
+
+	qsort(order, n, sizeof(what_if_order_t), compare_order);
+	const bool built = build(what_if, order, n);
+	free(order);
+	if (!built)
+	{
+		what_if_destroy(what_if);
+		return NULL;
+	}
+	return what_if;
+}
+
+void what_if_destroy(WhatIf_t *what_if)
+{
+	if (what_if)
+	{
+		dyn_array_destroy(what_if->nodes);
+		free(what_if);
+	}
+}
+
+bool what_if_update(WhatIf_t *what_if, size_t id, const ProcessControlBlock_t *pcb)
+{
+	if (!what_if || !pcb || pcb->next_burst_count > 0 || id >= dyn_array_size(what_if->nodes) ||
+			!node_at(what_if, id)->present)
+	{
+		return false;
+	}
+
+	unlink_node(what_if, id);
+	what_if_node_t *node = node_at(what_if, id);
+	track_remove(what_if, &node->pcb);
+	node->pcb = *pcb;
+	track_add(what_if, &node->pcb);
+	pull(what_if, id);
+	link_node(what_if, id);
+	return true;
+}
+
+bool what_if_insert(WhatIf_t *what_if, const ProcessControlBlock_t *pcb, size_t *id)
+{
+	if (!what_if || !pcb || !id || pcb->next_burst_count > 0)
+	{
+		return false;
+	}
+
+	what_if_node_t node;
+	memset(&node, 0, sizeof(node));
+	node.pcb = *pcb;
+	node.present = true;
+	node.heap_priority = next_priority(what_if);
+	node.left = NIL;
+	node.right = NIL;
+
+	*id = dyn_array_size(what_if->nodes);
+	if (!dyn_array_push_back(what_if->nodes, &node))
+	{
+		return false;
+	}
+
+	track_add(what_if, pcb);
+	pull(what_if, *id);
+	link_node(what_if, *id);
+	return true;
+}
+
+bool what_if_remove(WhatIf_t *what_if, size_t id)
+{
+	if (!what_if || id >= dyn_array_size(what_if->nodes) || !node_at(what_if, id)->present)
+	{
+		return false;
+	}
+
+	unlink_node(what_if, id);
+	what_if_node_t *node = node_at(what_if, id);
+	node->present = false;
+	track_remove(what_if, &node->pcb);
+	return true;
+}
+
+// Full rerun over the live PCBs, for SJF while the arrivals differ
+static bool rerun(WhatIf_t *what_if, ScheduleResult_t *result)
+{
+	if (!what_if->cached)
+	{
+		dyn_array_t *live = dyn_array_create((size_t)what_if->live, sizeof(ProcessControlBlock_t), NULL);
+		if (!live)
+		{
+			return false;
+		}
+
+		for (size_t id = 0; id < dyn_array_size(what_if->nodes); ++id)
+		{
+			const what_if_node_t *node = node_at(what_if, id);
+			if (node->present && !dyn_array_push_back(live, &node->pcb))
+			{
+				dyn_array_destroy(live);
+				return false;
+			}
+		}
+
+		const ScheduleConfig_t config = {.algorithm = what_if->algorithm};
+		what_if->cached = sched_run(live, &config, &what_if->cache);
+		dyn_array_destroy(live);
+		if (!what_if->cached)
+		{
+			return false;
+		}
+	}
+
+	*result = what_if->cache;
+	return true;
+}
+
+bool what_if_result(WhatIf_t *what_if, ScheduleResult_t *result)
+{
+	if (!what_if || !result || what_if->live == 0)
+	{
+		return false;
+	}
+
+	if (what_if->algorithm == SCHEDULE_SJF && what_if->off_release > 0)
+	{
+		return rerun(what_if, result);
+	}
+
+	const what_if_node_t *root = node_at(what_if, what_if->root);
+	const uint64_t completions = completion_sum(what_if, what_if->root, 0);
+	const uint64_t total_turnaround = completions - what_if->arrival_sum;
+	const uint64_t total_wait = total_turnaround - what_if->burst_sum;
+
+	result->average_waiting_time = (double)total_wait / (double)what_if->live;
+	result->average_turnaround_time = (double)total_turnaround / (double)what_if->live;
+	result->total_run_time = (uint64_t)root->gap + root->burst_sum;
+	// Deadlines aren't tracked by the treap
+	result->missed_deadlines = 0;
+	result->total_lateness = 0;
+
+	const double elapsed = result->total_run_time ? (double)result->total_run_time : 1.0;
+	result->cpu_utilization = (double)root->burst_sum / elapsed;
+	result->io_utilization = 0.0;
+	result->throughput = (double)what_if->live / elapsed;
+	// Non-preemptive: every PCB is switched in exactly once
+	result->context_switches = what_if->live;
+	result->switch_overhead = 0;
+	result->rejected = 0;
+	result->dropped = 0;
+	result->time_at_capacity = 0;
+	return true;
+}
@@ -1,8 +1,20 @@
 #include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
 #include <stdio.h>
 #include <pthread.h>
 #include "gtest/gtest.h"
 #include "../include/processing_scheduling.h"
+#include "../include/scheduler.h"
+#include "../include/what_if.h"
+#include "../include/monte_carlo.h"
+#include "../include/result_cache.h"
+#include "../include/trace_import.h"
+#include "../include/op_counters.h"
+#include "../include/pcb_shards.h"
+#include "../include/pcb_stream.h"
 
 // Using a C library requires extern "C" to prevent function mangling
 extern "C"
@@ -13,6 +25,16 @@ extern "C"
 #define NUM_PCB 30
 #define QUANTUM 5 // Used for Robin Round for process as the run time limit
 
+// A config running algorithm with every knob the test doesn't set off
+static ScheduleConfig_t make_config(ScheduleAlgorithm_t algorithm, size_t quantum = 0, ScheduleTrace_t *trace = NULL)
+{
+	ScheduleConfig_t config = {};
+	config.algorithm = algorithm;
+	config.quantum = quantum;
+	config.trace = trace;
+	return config;
+}
+
 /*
 unsigned int score;
 unsigned int total;
@@ -64,6 +86,151 @@ TEST (load_process_control_blocks, IncorrectFilename)
 	ASSERT_EQ(array, nullptr);
 }
 
+// v2 files carry 64-bit arrivals; saving and reloading must preserve them
+TEST (load_process_control_blocks, RoundTripsV2Format)
+{
+	const char *query_filename = "pcb_v2_roundtrip.bin";
+	dyn_array_t *array = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(array, nullptr);
+
+	ProcessControlBlock_t pcbs[2] = {
+		{7, 3, (1ULL << 40) + 5, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{UINT32_MAX, 1, 12, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_push_back(array, &pcbs[0]);
+	dyn_array_push_back(array, &pcbs[1]);
+
+	ASSERT_EQ(save_process_control_blocks(query_filename, array), true);
+	dyn_array_destroy(array);
+
+	array = load_process_control_blocks(query_filename);
+	ASSERT_NE(array, nullptr);
+	ASSERT_EQ(dyn_array_size(array), (size_t)2);
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		ProcessControlBlock_t *block = (ProcessControlBlock_t *)dyn_array_at(array, i);
+		EXPECT_EQ(block->remaining_burst_time, pcbs[i].remaining_burst_time);
+		EXPECT_EQ(block->priority, pcbs[i].priority);
+		EXPECT_EQ(block->arrival, pcbs[i].arrival);
+		EXPECT_EQ(block->started, false);
+	}
+
+	dyn_array_destroy(array);
+	remove(query_filename);
+}
+
+TEST (load_process_control_blocks, RoundTripsDeadlineColumn)
+{
+	const char *query_filename = "pcb_deadline_roundtrip.bin";
+	dyn_array_t *array = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(array, nullptr);
+
+	ProcessControlBlock_t pcbs[2] = {
+		{7, 3, 5, false, 0, 40, NULL, 0},
+		{2, 1, 12, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_push_back(array, &pcbs[0]);
+	dyn_array_push_back(array, &pcbs[1]);
+
+	ASSERT_EQ(save_process_control_blocks(query_filename, array), true);
+	dyn_array_destroy(array);
+
+	// Header (16 bytes) and two records with the extra column
+	FILE *file = fopen(query_filename, "rb");
+	ASSERT_NE(file, nullptr);
+	uint32_t header[2];
+	ASSERT_EQ(fread(header, sizeof(uint32_t), 2, file), (size_t)2);
+	EXPECT_EQ(header[1], PCB_FILE_FLAG_DEADLINE);
+	fseek(file, 0, SEEK_END);
+	EXPECT_EQ(ftell(file), 16 + 2 * 24);
+	fclose(file);
+
+	array = load_process_control_blocks(query_filename);
+	ASSERT_NE(array, nullptr);
+	ASSERT_EQ(dyn_array_size(array), (size_t)2);
+	for (size_t i = 0; i < 2; ++i)
+	{
+		ProcessControlBlock_t *block = (ProcessControlBlock_t *)dyn_array_at(array, i);
+		EXPECT_EQ(block->arrival, pcbs[i].arrival);
+		EXPECT_EQ(block->deadline, pcbs[i].deadline);
+	}
+
+	dyn_array_destroy(array);
+	remove(query_filename);
+}
+
+TEST (load_pcb_workload, RoundTripsBurstSequences)
+{
+	const char *query_filename = "pcb_bursts_roundtrip.bin";
+	dyn_array_t *array = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(array, nullptr);
+
+	const uint32_t bursts[] = {4, 2, 6, 1};
+	ProcessControlBlock_t pcbs[3] = {
+		{3, 0, 0, false, 0, PCB_NO_DEADLINE, bursts, 4},
+		{5, 1, 2, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 2, 3, false, 0, PCB_NO_DEADLINE, bursts + 2, 2}
+	};
+	for (size_t i = 0; i < 3; ++i)
+	{
+		dyn_array_push_back(array, &pcbs[i]);
+	}
+	ASSERT_EQ(save_process_control_blocks(query_filename, array), true);
+	dyn_array_destroy(array);
+
+	// The plain loader can't hold the bursts so it refuses the file
+	EXPECT_EQ(load_process_control_blocks(query_filename), nullptr);
+
+	PcbWorkload_t *workload = load_pcb_workload(query_filename);
+	ASSERT_NE(workload, nullptr);
+	ASSERT_EQ(dyn_array_size(workload->pcbs), (size_t)3);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		const ProcessControlBlock_t *block = (const ProcessControlBlock_t *)dyn_array_at(workload->pcbs, i);
+		EXPECT_EQ(block->remaining_burst_time, pcbs[i].remaining_burst_time);
+		EXPECT_EQ(block->arrival, pcbs[i].arrival);
+		ASSERT_EQ(block->next_burst_count, pcbs[i].next_burst_count);
+		for (uint32_t j = 0; j < block->next_burst_count; ++j)
+		{
+			EXPECT_EQ(block->next_bursts[j], pcbs[i].next_bursts[j]);
+		}
+	}
+
+	pcb_workload_destroy(workload);
+	remove(query_filename);
+}
+
+// Odd burst lists would leave a PCB blocked forever, the file isn't written
+TEST (save_process_control_blocks, RejectsOddBurstCount)
+{
+	const char *query_filename = "pcb_bursts_odd.bin";
+	dyn_array_t *array = dyn_array_create(1, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(array, nullptr);
+
+	const uint32_t bursts[] = {4};
+	ProcessControlBlock_t pcb = {3, 0, 0, false, 0, PCB_NO_DEADLINE, bursts, 1};
+	dyn_array_push_back(array, &pcb);
+	EXPECT_EQ(save_process_control_blocks(query_filename, array), false);
+	EXPECT_EQ(fopen(query_filename, "rb"), nullptr);
+	dyn_array_destroy(array);
+}
+
+// A count larger than the file can hold is rejected instead of allocated for
+TEST (load_process_control_blocks, TruncatedFile)
+{
+	const char *query_filename = "pcb_truncated.bin";
+	FILE *file = fopen(query_filename, "wb");
+	ASSERT_NE(file, nullptr);
+
+	const uint32_t header[4] = {1000000, 5, 0, 0};
+	fwrite(header, sizeof(uint32_t), 4, file);
+	fclose(file);
+
+	ASSERT_EQ(load_process_control_blocks(query_filename), nullptr);
+	remove(query_filename);
+}
+
 // FCFS Test 1: Verify correct scheduling with a known set of processes
 TEST (first_come_first_serve, ValidProcesses)
 {
@@ -78,9 +245,9 @@ TEST (first_come_first_serve, ValidProcesses)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[3] = {
-		{5, 0, 0, false},
-		{3, 0, 1, false},
-		{8, 0, 2, false}
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{8, 0, 2, false, 0, PCB_NO_DEADLINE, NULL, 0}
 	};
 
 	dyn_array_push_back(ready_queue, &pcbs[0]);
@@ -116,6 +283,65 @@ TEST (first_come_first_serve, NullInputs)
 	dyn_array_destroy(ready_queue);
 }
 
+// FCFS Test 3: Sums past 2^24 must not be rounded away
+TEST (first_come_first_serve, ExactLargeSums)
+{
+	// waits are 0, 2^24 + 1 and 2^24 + 2, which a float accumulator can't hold exactly
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{(1U << 24) + 1, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	for (int i = 0; i < 3; ++i)
+	{
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+	}
+
+	ScheduleResult_t result;
+	ASSERT_EQ(first_come_first_serve(ready_queue, &result), true);
+	EXPECT_DOUBLE_EQ(result.average_waiting_time, 33554435.0 / 3.0);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, (16777217.0 + 16777218.0 + 16777219.0) / 3.0);
+	EXPECT_EQ(result.total_run_time, (uint64_t)16777219);
+
+	dyn_array_destroy(ready_queue);
+}
+
+// FCFS Test 4: Arrivals rewritten in place between runs are honoured by the next run
+TEST (first_come_first_serve, ArrivalsChangedInPlace)
+{
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{8, 0, 2, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	for (int i = 0; i < 3; ++i)
+	{
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+	}
+
+	ScheduleResult_t result;
+	ASSERT_EQ(first_come_first_serve(ready_queue, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 3.33f, 0.1f);
+
+	// P2 now arrives first and P0 last: P2 runs 0-8, P1 8-11 (wait 7), P0 11-16 (wait 9)
+	((ProcessControlBlock_t *)dyn_array_at(ready_queue, 0))->arrival = 2;
+	((ProcessControlBlock_t *)dyn_array_at(ready_queue, 2))->arrival = 0;
+	ASSERT_EQ(first_come_first_serve(ready_queue, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 5.33f, 0.1f);
+	EXPECT_NEAR(result.average_turnaround_time, 10.67f, 0.1f);
+	EXPECT_EQ(result.total_run_time, (unsigned long)16);
+
+	dyn_array_destroy(ready_queue);
+}
+
 // SRT Test 1: Verify correct scheduling behavior
 TEST(shortest_remaining_time_first, ValidProcesses)
 {
@@ -123,9 +349,9 @@ TEST(shortest_remaining_time_first, ValidProcesses)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[3] = {
-		{8, 0, 0, false},
-		{4, 0, 1, false},
-		{2, 0, 2, false}
+		{8, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 2, false, 0, PCB_NO_DEADLINE, NULL, 0}
 	};
 
 	dyn_array_push_back(ready_queue, &pcbs[0]);
@@ -164,8 +390,8 @@ TEST(round_robin, ValidProcesses)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[2] = {
-		{5, 0, 0, false},
-		{3, 0, 1, false}
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0}
 	};
 
 	dyn_array_push_back(ready_queue, &pcbs[0]);
@@ -196,6 +422,29 @@ TEST(round_robin, NullInputs)
 	dyn_array_destroy(ready_queue);
 }
 
+// RR Test 3: Idle gaps beyond 32 bits are skipped, not stepped through
+TEST(round_robin, LargeIdleGap)
+{
+	dyn_array_t* ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[2] = {
+		{2, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 1ULL << 40, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	ScheduleResult_t result;
+	ASSERT_EQ(round_robin(ready_queue, &result, 2), true);
+	EXPECT_NEAR(result.average_waiting_time, 0.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 2.5, 0.01);
+	EXPECT_EQ(result.total_run_time, (1ULL << 40) + 3);
+
+	dyn_array_destroy(ready_queue);
+}
+
 // SJF Test 1: Verify correct scheduling with same arrival times
 TEST(shortest_job_first, ValidProcessesSameArrivals)
 {
@@ -203,10 +452,10 @@ TEST(shortest_job_first, ValidProcessesSameArrivals)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[4] = {
-		{10, 0, 0, false},
-		{5, 0, 0, false},
-		{1, 0, 0, false},
-		{15, 0, 0, false},
+		{10, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{15, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
 	};
 
 	for (int i = 0; i < 4; ++i) 
@@ -232,11 +481,11 @@ TEST(shortest_job_first, ValidProcessesDifferentArrivals)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[5] = {
-		{10, 0, 0, false},
-		{5, 0, 0, false},
-		{1, 0, 10, false},
-		{2, 0, 10, false},
-		{15, 0, 0, false}
+		{10, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 10, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 10, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{15, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0}
 	};
 
 	for (int i = 0; i < 5; ++i) 
@@ -274,10 +523,10 @@ TEST(priority, ValidProcessesSameArrivals)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[4] = {
-		{10, 1, 0, false},
-		{5, 2, 0, false},
-		{1, 3, 0, false},
-		{15, 4, 0, false},
+		{10, 1, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{5, 2, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 3, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{15, 4, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
 	};
 
 	for (int i = 0; i < 4; ++i) 
@@ -303,11 +552,11 @@ TEST(priority, ValidProcessesDifferentArrivals)
 	ASSERT_NE(ready_queue, nullptr);
 
 	ProcessControlBlock_t pcbs[5] = {
-		{10, 1, 0, false},
-		{5, 2, 15, false},
-		{10, 1, 15, false},
-		{1, 3, 0, false},
-		{15, 4, 0, false},
+		{10, 1, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{5, 2, 15, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{10, 1, 15, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 3, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{15, 4, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
 	};
 
 	for (int i = 0; i < 5; ++i) 
@@ -340,6 +589,1919 @@ TEST(priority, NullInputs)
 	dyn_array_destroy(ready_queue);
 }
 
+// Prio Test 4: Verify preemption on arrival with and without aging
+TEST(priority, PreemptiveWithAging)
+{
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{10, 3, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 1, 2, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 2, 3, false, 0, PCB_NO_DEADLINE, NULL, 0},
+	};
+
+	for (int i = 0; i < 3; ++i) 
+	{
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+	}
+
+	// P0 0-2, P1 2-6, P2 6-9, P0 9-17
+	ScheduleResult_t result;
+	ASSERT_EQ(priority_preemptive(ready_queue, &result, 0), true);
+	EXPECT_NEAR(result.average_waiting_time, 1.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 9.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)17);
+
+	// One level per tick waited: P0 0-2, P1 2-5, P0 5-6, P2 6-8, P0 8-9, P1 9-10, P0 10-11, P2 11-12, P0 12-17
+	ASSERT_EQ(priority_preemptive(ready_queue, &result, 1), true);
+	EXPECT_NEAR(result.average_waiting_time, 1.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 34.0 / 3.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)17);
+
+	EXPECT_EQ(priority_preemptive(NULL, &result, 1), false);
+
+	dyn_array_destroy(ready_queue);
+}
+
+// Trace Test 1: Round Robin slices, preemptions and per-PCB lifetimes are streamed out
+TEST(schedule_trace, RoundRobinRecords)
+{
+	const char *trace_filename = "rr_trace.bin";
+	dyn_array_t* ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[2] = {
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 1, false, 1, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_RR, 2, schedule_trace_open(trace_filename));
+	ASSERT_NE(config.trace, nullptr);
+
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	ASSERT_EQ(schedule_trace_close(config.trace), true);
+
+	// Expected timeline: P0 0-2, P1 2-4, P0 4-6, P1 6-7 (done), P0 7-8 (done)
+	const ScheduleTraceRecord_t expected[7] = {
+		{SCHEDULE_TRACE_SLICE, 0, 0, 0, 2, 0, 0, 0, 0},
+		{SCHEDULE_TRACE_SLICE, 1, 0, 2, 2, 0, 0, 0, 0},
+		{SCHEDULE_TRACE_SLICE, 0, 0, 4, 2, 0, 0, 0, 0},
+		{SCHEDULE_TRACE_SLICE, 1, 0, 6, 1, 0, 0, 0, 0},
+		{SCHEDULE_TRACE_JOB, 1, 0, 0, 0, 1, 2, 7, 1},
+		{SCHEDULE_TRACE_SLICE, 0, 0, 7, 1, 0, 0, 0, 0},
+		{SCHEDULE_TRACE_JOB, 0, 0, 0, 0, 0, 0, 8, 2},
+	};
+
+	ScheduleTraceReader_t *reader = schedule_trace_reader_open(trace_filename);
+	ASSERT_NE(reader, nullptr);
+
+	ScheduleTraceRecord_t record;
+	for (int i = 0; i < 7; ++i)
+	{
+		ASSERT_EQ(schedule_trace_reader_next(reader, &record), true);
+		EXPECT_EQ(record.type, expected[i].type);
+		EXPECT_EQ(record.pid, expected[i].pid);
+		EXPECT_EQ(record.cpu, expected[i].cpu);
+		EXPECT_EQ(record.start, expected[i].start);
+		EXPECT_EQ(record.length, expected[i].length);
+		EXPECT_EQ(record.arrival, expected[i].arrival);
+		EXPECT_EQ(record.first_dispatch, expected[i].first_dispatch);
+		EXPECT_EQ(record.completion, expected[i].completion);
+		EXPECT_EQ(record.preemptions, expected[i].preemptions);
+	}
+	EXPECT_EQ(schedule_trace_reader_next(reader, &record), false);
+
+	schedule_trace_reader_close(reader);
+	dyn_array_destroy(ready_queue);
+	remove(trace_filename);
+}
+
+// Trace Test 2: SRTF runs one tick at a time, the trace holds one slice per dispatch
+TEST(schedule_trace, ShortestRemainingTimeRunLengths)
+{
+	const char *trace_filename = "srt_trace.bin";
+	dyn_array_t* ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{8, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 0, 1, false, 1, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 2, false, 2, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	for (int i = 0; i < 3; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_SRT, 0, schedule_trace_open(trace_filename));
+	ASSERT_NE(config.trace, nullptr);
+
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	ASSERT_EQ(schedule_trace_close(config.trace), true);
+
+	ScheduleTraceReader_t *reader = schedule_trace_reader_open(trace_filename);
+	ASSERT_NE(reader, nullptr);
+
+	// P0 0-1, P1 1-2, P2 2-4, P1 4-7, P0 7-14
+	size_t slices = 0;
+	uint64_t busy = 0;
+	uint64_t preemptions[3] = {0, 0, 0};
+	ScheduleTraceRecord_t record;
+	while (schedule_trace_reader_next(reader, &record))
+	{
+		if (record.type == SCHEDULE_TRACE_SLICE)
+		{
+			++slices;
+			busy += record.length;
+		}
+		else
+		{
+			ASSERT_LT(record.pid, (uint32_t)3);
+			preemptions[record.pid] = record.preemptions;
+		}
+	}
+
+	EXPECT_EQ(slices, (size_t)5);
+	EXPECT_EQ(busy, (uint64_t)14);
+	EXPECT_EQ(preemptions[0], (uint64_t)1);
+	EXPECT_EQ(preemptions[1], (uint64_t)1);
+	EXPECT_EQ(preemptions[2], (uint64_t)0);
+
+	schedule_trace_reader_close(reader);
+	dyn_array_destroy(ready_queue);
+	remove(trace_filename);
+}
+
+// Trace Test 3: CPUs run side by side, each keeps its own slices in order and they round-trip exactly
+TEST(schedule_trace, TwoCpusRoundTrip)
+{
+	const char *trace_filename = "two_cpu_trace.bin";
+	dyn_array_t* ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 0, false, 1, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 1, false, 2, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	for (int i = 0; i < 3; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_FCFS, 0, schedule_trace_open(trace_filename));
+	ASSERT_NE(config.trace, nullptr);
+	config.cpu_count = 2;
+
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	ASSERT_EQ(schedule_trace_close(config.trace), true);
+
+	ScheduleTraceReader_t *reader = schedule_trace_reader_open(trace_filename);
+	ASSERT_NE(reader, nullptr);
+
+	// P0 0-5 on one CPU, P1 0-3 then P2 3-5 on the other
+	const uint64_t starts[3] = {0, 0, 3};
+	uint32_t cpu_of[3] = {2, 2, 2};
+	uint64_t cpu_end[2] = {0, 0};
+	size_t jobs = 0;
+	ScheduleTraceRecord_t record;
+	while (schedule_trace_reader_next(reader, &record))
+	{
+		ASSERT_LT(record.pid, (uint32_t)3);
+		if (record.type == SCHEDULE_TRACE_SLICE)
+		{
+			ASSERT_LT(record.cpu, (uint32_t)2);
+			EXPECT_GE(record.start, cpu_end[record.cpu]);
+			EXPECT_EQ(record.start, starts[record.pid]);
+			EXPECT_EQ(record.length, (uint64_t)pcbs[record.pid].remaining_burst_time);
+			cpu_end[record.cpu] = record.start + record.length;
+			cpu_of[record.pid] = record.cpu;
+		}
+		else
+		{
+			++jobs;
+			EXPECT_EQ(record.first_dispatch, starts[record.pid]);
+			EXPECT_EQ(record.completion, starts[record.pid] + pcbs[record.pid].remaining_burst_time);
+		}
+	}
+
+	EXPECT_EQ(jobs, (size_t)3);
+	EXPECT_NE(cpu_of[0], cpu_of[1]);
+	EXPECT_EQ(cpu_of[1], cpu_of[2]);
+	EXPECT_EQ(cpu_end[0], (uint64_t)5);
+	EXPECT_EQ(cpu_end[1], (uint64_t)5);
+
+	schedule_trace_reader_close(reader);
+	dyn_array_destroy(ready_queue);
+	remove(trace_filename);
+}
+
+static void expect_same_result(const ScheduleResult_t &actual, const ScheduleResult_t &expected, const char *what)
+{
+	EXPECT_DOUBLE_EQ(actual.average_waiting_time, expected.average_waiting_time) << what;
+	EXPECT_DOUBLE_EQ(actual.average_turnaround_time, expected.average_turnaround_time) << what;
+	EXPECT_EQ(actual.total_run_time, expected.total_run_time) << what;
+	EXPECT_EQ(actual.missed_deadlines, expected.missed_deadlines) << what;
+	EXPECT_EQ(actual.total_lateness, expected.total_lateness) << what;
+	EXPECT_DOUBLE_EQ(actual.cpu_utilization, expected.cpu_utilization) << what;
+	EXPECT_DOUBLE_EQ(actual.io_utilization, expected.io_utilization) << what;
+	EXPECT_DOUBLE_EQ(actual.throughput, expected.throughput) << what;
+	EXPECT_EQ(actual.context_switches, expected.context_switches) << what;
+	EXPECT_EQ(actual.switch_overhead, expected.switch_overhead) << what;
+	EXPECT_EQ(actual.rejected, expected.rejected) << what;
+	EXPECT_EQ(actual.dropped, expected.dropped) << what;
+	EXPECT_EQ(actual.time_at_capacity, expected.time_at_capacity) << what;
+}
+
+// One config that every policy can run with, each reads only its own knobs
+static ScheduleConfig_t config_for(ScheduleAlgorithm_t algorithm)
+{
+	ScheduleConfig_t config = {};
+	config.algorithm = algorithm;
+	config.quantum = 1;
+	config.aging_interval = 4;
+	config.levels = 3;
+	config.target_latency = 12;
+	config.min_granularity = 2;
+	return config;
+}
+
+// Online Test 1: Metrics can be read between submissions and partial advances
+TEST(scheduler, IncrementalSubmitAndAdvance)
+{
+	const ScheduleConfig_t config = make_config(SCHEDULE_FCFS);
+	Scheduler_t *sched = sched_create(&config);
+	ASSERT_NE(sched, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{5, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 0, 1, false, 1, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 10, false, 2, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	ASSERT_EQ(sched_submit(sched, &pcbs[0]), true);
+	ASSERT_EQ(sched_submit(sched, &pcbs[1]), true);
+
+	ScheduleMetrics_t metrics;
+	ASSERT_EQ(sched_advance_to(sched, 3), true);
+	ASSERT_EQ(sched_snapshot_metrics(sched, &metrics), true);
+	EXPECT_EQ(metrics.clock, (uint64_t)3);
+	EXPECT_EQ(metrics.completed, (uint64_t)0);
+	EXPECT_EQ(metrics.ready, (uint64_t)1);
+	EXPECT_EQ(metrics.busy_time, (uint64_t)3);
+
+	ASSERT_EQ(sched_advance_to(sched, 9), true);
+	ASSERT_EQ(sched_snapshot_metrics(sched, &metrics), true);
+	EXPECT_EQ(metrics.completed, (uint64_t)2);
+	EXPECT_EQ(metrics.total_waiting_time, (uint64_t)4);
+	EXPECT_EQ(metrics.total_turnaround_time, (uint64_t)12);
+
+	// The past can't be changed, but the future can
+	ProcessControlBlock_t late = {1, 0, 4, false, 3, PCB_NO_DEADLINE, NULL, 0};
+	EXPECT_EQ(sched_submit(sched, &late), false);
+	ASSERT_EQ(sched_submit(sched, &pcbs[2]), true);
+	EXPECT_EQ(sched_advance_to(sched, 5), false);
+
+	ASSERT_EQ(sched_advance_to(sched, 20), true);
+	ASSERT_EQ(sched_snapshot_metrics(sched, &metrics), true);
+	EXPECT_EQ(metrics.clock, (uint64_t)20);
+	EXPECT_EQ(metrics.submitted, (uint64_t)3);
+	EXPECT_EQ(metrics.completed, (uint64_t)3);
+	EXPECT_EQ(metrics.pending, (uint64_t)0);
+	EXPECT_EQ(metrics.busy_time, (uint64_t)10);
+	EXPECT_NEAR(metrics.result.average_waiting_time, 4.0 / 3.0, 0.01);
+	EXPECT_NEAR(metrics.result.average_turnaround_time, 14.0 / 3.0, 0.01);
+
+	sched_destroy(sched);
+}
+
+// Online Test 2: Batch runs through the simulator agree with the classic SJF and Priority schedules
+TEST(scheduler, BatchMatchesNonPreemptive)
+{
+	dyn_array_t *ready_queue = dyn_array_create(5, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[5] = {
+		{10, 1, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{5, 2, 15, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{10, 1, 15, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 3, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{15, 4, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+	};
+
+	for (int i = 0; i < 5; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	ScheduleResult_t result;
+	const ScheduleConfig_t priority_config = make_config(SCHEDULE_PRIORITY);
+	ASSERT_EQ(sched_run(ready_queue, &priority_config, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 10.6, 0.1);
+	EXPECT_NEAR(result.average_turnaround_time, 18.8, 0.1);
+	EXPECT_EQ(result.total_run_time, (uint64_t)41);
+
+	// sched_run leaves the queue untouched, so the same PCBs can go through SJF
+	// 1: 0-1, 10: 1-11, 15: 11-26, 5: 26-31, 10: 31-41
+	const ScheduleConfig_t sjf_config = make_config(SCHEDULE_SJF);
+	ASSERT_EQ(sched_run(ready_queue, &sjf_config, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 7.8, 0.1);
+	EXPECT_NEAR(result.average_turnaround_time, 16.0, 0.1);
+	EXPECT_EQ(result.total_run_time, (uint64_t)41);
+
+	dyn_array_destroy(ready_queue);
+}
+
+// Online Test 3: SRT preempts at arrivals and Round Robin cycles through a FIFO queue
+TEST(scheduler, Preemptive)
+{
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{8, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 2, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+
+	for (int i = 0; i < 3; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	// P0 0-1, P1 1-2, P2 2-4, P1 4-7, P0 7-14, everyone is dispatched on arrival. SRT's waiting time adds
+	// the time spent preempted, turnaround - burst: (6 + 2 + 0) / 3
+	ScheduleResult_t result;
+	const ScheduleConfig_t srt_config = make_config(SCHEDULE_SRT);
+	ASSERT_EQ(sched_run(ready_queue, &srt_config, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 8.0 / 3.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 22.0 / 3.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)14);
+
+	// q = 3: P0 0-3, P1 3-6, P2 6-8, P0 8-11, P1 11-12, P0 12-14
+	const ScheduleConfig_t rr_config = make_config(SCHEDULE_RR, 3);
+	ASSERT_EQ(sched_run(ready_queue, &rr_config, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 2.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 31.0 / 3.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)14);
+
+	const ScheduleConfig_t no_quantum = make_config(SCHEDULE_RR);
+	EXPECT_EQ(sched_create(&no_quantum), nullptr);
+
+	dyn_array_destroy(ready_queue);
+}
+
+// Online Test 4: sched_run feeds input in arrival order as the clock reaches it, which must give what
+// submitting every PCB up front gives, ties between equal arrivals included
+TEST(scheduler, InOrderInputMatchesUpFront)
+{
+	const size_t n = 2000;
+	dyn_array_t *ready_queue = dyn_array_create(n, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	uint32_t seed = 26;
+	uint64_t arrival = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		arrival += (seed >> 10) % 3 == 0 ? 0 : (seed >> 12) % 9;
+		ProcessControlBlock_t pcb = {1 + (seed >> 16) % 12, (seed >> 20) % 8, arrival, false, (uint32_t)i,
+									 PCB_NO_DEADLINE, NULL, 0};
+		pcb.deadline = arrival + 30;
+		ASSERT_TRUE(dyn_array_push_back(ready_queue, &pcb));
+	}
+
+	for (int algorithm = SCHEDULE_FCFS; algorithm <= SCHEDULE_HRRN; ++algorithm)
+	{
+		const ScheduleConfig_t config = config_for((ScheduleAlgorithm_t)algorithm);
+		const char *name = schedule_algorithm_name(config.algorithm);
+		ScheduleResult_t fed;
+		ASSERT_TRUE(sched_run(ready_queue, &config, &fed)) << name;
+
+		Scheduler_t *sched = sched_create(&config);
+		ASSERT_NE(sched, nullptr) << name;
+		for (size_t i = 0; i < n; ++i)
+		{
+			ASSERT_TRUE(sched_submit(sched, (const ProcessControlBlock_t *)dyn_array_at(ready_queue, i)));
+		}
+		ScheduleMetrics_t metrics;
+		ASSERT_TRUE(sched_drain(sched) && sched_snapshot_metrics(sched, &metrics)) << name;
+		expect_same_result(fed, metrics.result, name);
+		sched_destroy(sched);
+	}
+	dyn_array_destroy(ready_queue);
+}
+
+TEST(multi_level_feedback_queue, DemotionAndPreemption)
+{
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{6, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 5, false, 0, PCB_NO_DEADLINE, NULL, 0},
+	};
+
+	for (int i = 0; i < 3; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	// Slices 2 and 4: P0 0-2 drops a level, P1 2-4, P0 4-5, P2 preempts 5-6, P0 6-9 on a fresh slice
+	ScheduleResult_t result;
+	ASSERT_EQ(multi_level_feedback_queue(ready_queue, &result, 2, 2, 0), true);
+	EXPECT_NEAR(result.average_waiting_time, 1.0 / 3.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 13.0 / 3.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)9);
+
+	// Explicit slices for a single level is plain Round Robin
+	const uint64_t quanta[1] = {3};
+	ScheduleConfig_t config = {};
+	config.algorithm = SCHEDULE_MLFQ;
+	config.levels = 1;
+	config.level_quanta = quanta;
+	const ScheduleConfig_t rr_config = make_config(SCHEDULE_RR, 3);
+	ScheduleResult_t rr_result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	ASSERT_EQ(sched_run(ready_queue, &rr_config, &rr_result), true);
+	EXPECT_NEAR(result.average_turnaround_time, rr_result.average_turnaround_time, 0.01);
+
+	EXPECT_EQ(multi_level_feedback_queue(ready_queue, &result, 0, 2, 0), false);
+	EXPECT_EQ(multi_level_feedback_queue(ready_queue, &result, 65, 2, 0), false);
+	EXPECT_EQ(multi_level_feedback_queue(ready_queue, &result, 2, 0, 0), false);
+
+	dyn_array_destroy(ready_queue);
+}
+
+TEST(multi_level_feedback_queue, BoostLetsDemotedJobsCompete)
+{
+	dyn_array_t *ready_queue = dyn_array_create(5, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	// A long job against a stream of short ones that keep the top level busy
+	ProcessControlBlock_t pcbs[5] = {
+		{10, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 2, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 4, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 6, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 8, false, 0, PCB_NO_DEADLINE, NULL, 0},
+	};
+
+	for (int i = 0; i < 5; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	// Without a boost P0 waits in the lower level until the stream ends at 10
+	ScheduleResult_t result;
+	ASSERT_EQ(multi_level_feedback_queue(ready_queue, &result, 2, 2, 0), true);
+	EXPECT_NEAR(result.average_waiting_time, 0.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 26.0 / 5.0, 0.01);
+
+	// Boosting every 3 ticks puts P0 back ahead of P2 and P4
+	ASSERT_EQ(multi_level_feedback_queue(ready_queue, &result, 2, 2, 3), true);
+	EXPECT_NEAR(result.average_waiting_time, 6.0 / 5.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 32.0 / 5.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)18);
+
+	dyn_array_destroy(ready_queue);
+}
+
+TEST(completely_fair_scheduler, WeightedSlices)
+{
+	dyn_array_t *ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[2] = {
+		{6, 20, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{6, 20, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+	};
+
+	for (int i = 0; i < 2; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	// Equal weights split the 6 tick period: P0 0-3, P1 3-6, P0 6-9, P1 9-12
+	ScheduleResult_t result;
+	ASSERT_EQ(completely_fair_scheduler(ready_queue, &result, 6, 1), true);
+	EXPECT_NEAR(result.average_waiting_time, 1.5, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 10.5, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)12);
+
+	// Nice -5 against nice 0 gets 6 of every 8 ticks: P0 0-6, P1 6-8, P0 8-14, P1 14-16
+	pcbs[0] = {12, 15, 0, false, 0, PCB_NO_DEADLINE, NULL, 0};
+	pcbs[1] = {4, 20, 0, false, 0, PCB_NO_DEADLINE, NULL, 0};
+	dyn_array_clear(ready_queue);
+	for (int i = 0; i < 2; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+	ASSERT_EQ(completely_fair_scheduler(ready_queue, &result, 8, 1), true);
+	EXPECT_NEAR(result.average_waiting_time, 3.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 15.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)16);
+
+	// An arrival starts level with the running PCB, so it runs once the (now halved) slice is over: P0 0-6, P1 6-8, P0 8-12
+	pcbs[0] = {10, 20, 0, false, 0, PCB_NO_DEADLINE, NULL, 0};
+	pcbs[1] = {2, 20, 5, false, 0, PCB_NO_DEADLINE, NULL, 0};
+	dyn_array_clear(ready_queue);
+	for (int i = 0; i < 2; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+	ASSERT_EQ(completely_fair_scheduler(ready_queue, &result, 6, 1), true);
+	EXPECT_NEAR(result.average_waiting_time, 0.5, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 7.5, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)12);
+
+	EXPECT_EQ(completely_fair_scheduler(ready_queue, &result, 0, 1), false);
+	EXPECT_EQ(completely_fair_scheduler(ready_queue, &result, 6, 0), false);
+
+	dyn_array_destroy(ready_queue);
+}
+
+TEST(earliest_deadline_first, MissesAndLateness)
+{
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{4, 0, 0, false, 0, 10, NULL, 0},
+		{2, 0, 1, false, 0, 4, NULL, 0},
+		{3, 0, 2, false, 0, 20, NULL, 0},
+	};
+
+	for (int i = 0; i < 3; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	// P0 0-4, P1 4-6 finishing 2 late, P2 6-9
+	ScheduleResult_t result;
+	ASSERT_EQ(earliest_deadline_first(ready_queue, &result, false), true);
+	EXPECT_NEAR(result.average_waiting_time, 7.0 / 3.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 16.0 / 3.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)9);
+	EXPECT_EQ(result.missed_deadlines, (uint64_t)1);
+	EXPECT_EQ(result.total_lateness, (uint64_t)2);
+
+	// P1 preempts at 1: P0 0-1, P1 1-3, P0 3-6, P2 6-9, nobody is late
+	ASSERT_EQ(earliest_deadline_first(ready_queue, &result, true), true);
+	EXPECT_NEAR(result.average_waiting_time, 4.0 / 3.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 5.0, 0.01);
+	EXPECT_EQ(result.missed_deadlines, (uint64_t)0);
+	EXPECT_EQ(result.total_lateness, (uint64_t)0);
+
+	// The other algorithms report misses too: FCFS is the non-preemptive order here
+	ASSERT_EQ(first_come_first_serve(ready_queue, &result), true);
+	EXPECT_EQ(result.missed_deadlines, (uint64_t)1);
+	EXPECT_EQ(result.total_lateness, (uint64_t)2);
+
+	dyn_array_destroy(ready_queue);
+}
+
+TEST(highest_response_ratio_next, LongJobsAgeAhead)
+{
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	ProcessControlBlock_t pcbs[3] = {
+		{10, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{6, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 9, false, 0, PCB_NO_DEADLINE, NULL, 0},
+	};
+
+	for (int i = 0; i < 3; ++i)
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+
+	// At 10 P1 has ratio 15/6 against P2's 3/2, so it goes first where SJF would pick P2: P0 0-10, P1 10-16, P2 16-18
+	ScheduleResult_t result;
+	ASSERT_EQ(highest_response_ratio_next(ready_queue, &result), true);
+	EXPECT_NEAR(result.average_waiting_time, 16.0 / 3.0, 0.01);
+	EXPECT_NEAR(result.average_turnaround_time, 34.0 / 3.0, 0.01);
+	EXPECT_EQ(result.total_run_time, (uint64_t)18);
+
+	EXPECT_EQ(highest_response_ratio_next(NULL, &result), false);
+
+	dyn_array_destroy(ready_queue);
+}
+
+// Plain rescan of the arrived PCBs for the highest ratio, to check the kinetic tree against
+static double reference_hrrn_waiting_time(std::vector<ProcessControlBlock_t> pcbs)
+{
+	uint64_t clock = 0, total_wait = 0;
+	std::vector<bool> done(pcbs.size(), false);
+	for (size_t completed = 0; completed < pcbs.size(); ++completed)
+	{
+		size_t best = pcbs.size();
+		uint64_t earliest = UINT64_MAX;
+		for (size_t i = 0; i < pcbs.size(); ++i)
+			if (!done[i] && pcbs[i].arrival < earliest)
+				earliest = pcbs[i].arrival;
+		if (clock < earliest)
+			clock = earliest;
+
+		for (size_t i = 0; i < pcbs.size(); ++i)
+		{
+			if (done[i] || pcbs[i].arrival > clock)
+				continue;
+			if (best == pcbs.size())
+			{
+				best = i;
+				continue;
+			}
+			// (clock - a_i) / b_i against (clock - a_best) / b_best, ties to the earlier arrival then index
+			const __int128 lhs = (__int128)(clock - pcbs[i].arrival) * pcbs[best].remaining_burst_time;
+			const __int128 rhs = (__int128)(clock - pcbs[best].arrival) * pcbs[i].remaining_burst_time;
+			if (lhs > rhs || (lhs == rhs && pcbs[i].arrival < pcbs[best].arrival))
+				best = i;
+		}
+
+		total_wait += clock - pcbs[best].arrival;
+		clock += pcbs[best].remaining_burst_time;
+		done[best] = true;
+	}
+	return (double)total_wait / (double)pcbs.size();
+}
+
+TEST(highest_response_ratio_next, MatchesRescan)
+{
+	srand(34);
+	for (int round = 0; round < 20; ++round)
+	{
+		std::vector<ProcessControlBlock_t> pcbs;
+		dyn_array_t *ready_queue = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+		for (int i = 0; i < 300; ++i)
+		{
+			ProcessControlBlock_t pcb = {(uint32_t)(1 + rand() % 30), 0, (uint64_t)(rand() % 3000), false, 0,
+										 PCB_NO_DEADLINE, NULL, 0};
+			pcbs.push_back(pcb);
+			dyn_array_push_back(ready_queue, &pcb);
+		}
+
+		ScheduleResult_t result;
+		ASSERT_EQ(highest_response_ratio_next(ready_queue, &result), true);
+		EXPECT_NEAR(result.average_waiting_time, reference_hrrn_waiting_time(pcbs), 1e-9);
+		dyn_array_destroy(ready_queue);
+	}
+}
+
+// Applies random edits to a what-if state and checks every result against a full rerun
+static void check_what_if_against_rerun(ScheduleAlgorithm_t algorithm, uint32_t max_arrival)
+{
+	srand(520);
+	std::vector<ProcessControlBlock_t> pcbs;
+	std::vector<bool> live;
+	dyn_array_t *baseline = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(baseline, nullptr);
+	for (uint32_t i = 0; i < 200; ++i)
+	{
+		ProcessControlBlock_t pcb = {(uint32_t)(rand() % 20), 0, (uint64_t)(rand() % (max_arrival + 1)), false, 0,
+									 PCB_NO_DEADLINE, NULL, 0};
+		pcbs.push_back(pcb);
+		live.push_back(true);
+		dyn_array_push_back(baseline, &pcb);
+	}
+
+	WhatIf_t *what_if = what_if_create(baseline, algorithm);
+	ASSERT_NE(what_if, nullptr);
+	dyn_array_destroy(baseline);
+
+	const ScheduleConfig_t config = make_config(algorithm);
+	for (int step = 0; step < 300; ++step)
+	{
+		const size_t id = (size_t)rand() % pcbs.size();
+		ProcessControlBlock_t pcb = {(uint32_t)(rand() % 20), 0, (uint64_t)(rand() % (max_arrival + 1)), false, 0,
+									 PCB_NO_DEADLINE, NULL, 0};
+		switch (rand() % 3)
+		{
+			case 0:
+				ASSERT_EQ(what_if_update(what_if, id, &pcb), (bool)live[id]);
+				if (live[id])
+					pcbs[id] = pcb;
+				break;
+			case 1:
+				ASSERT_EQ(what_if_remove(what_if, id), (bool)live[id]);
+				live[id] = false;
+				break;
+			default:
+				size_t new_id;
+				ASSERT_EQ(what_if_insert(what_if, &pcb, &new_id), true);
+				ASSERT_EQ(new_id, pcbs.size());
+				pcbs.push_back(pcb);
+				live.push_back(true);
+				break;
+		}
+
+		dyn_array_t *current = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+		for (size_t i = 0; i < pcbs.size(); ++i)
+			if (live[i])
+				dyn_array_push_back(current, &pcbs[i]);
+
+		ScheduleResult_t expected, actual;
+		ASSERT_EQ(sched_run(current, &config, &expected), true);
+		ASSERT_EQ(what_if_result(what_if, &actual), true);
+		EXPECT_NEAR(actual.average_waiting_time, expected.average_waiting_time, 1e-9);
+		EXPECT_NEAR(actual.average_turnaround_time, expected.average_turnaround_time, 1e-9);
+		EXPECT_EQ(actual.total_run_time, expected.total_run_time);
+		dyn_array_destroy(current);
+	}
+
+	what_if_destroy(what_if);
+}
+
+TEST(what_if, FirstComeFirstServeMatchesRerun)
+{
+	check_what_if_against_rerun(SCHEDULE_FCFS, 2000);
+}
+
+TEST(what_if, ShortestJobFirstMatchesRerun)
+{
+	// Shared arrival takes the incremental path, spread arrivals the full rerun
+	check_what_if_against_rerun(SCHEDULE_SJF, 0);
+	check_what_if_against_rerun(SCHEDULE_SJF, 500);
+}
+
+TEST(what_if, NullInputs)
+{
+	dyn_array_t *baseline = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(baseline, nullptr);
+	EXPECT_EQ(what_if_create(NULL, SCHEDULE_FCFS), nullptr);
+	EXPECT_EQ(what_if_create(baseline, SCHEDULE_RR), nullptr);
+
+	WhatIf_t *what_if = what_if_create(baseline, SCHEDULE_FCFS);
+	ASSERT_NE(what_if, nullptr);
+	ScheduleResult_t result;
+	EXPECT_EQ(what_if_result(what_if, &result), false);
+	EXPECT_EQ(what_if_remove(what_if, 0), false);
+	EXPECT_EQ(what_if_update(what_if, 0, NULL), false);
+
+	what_if_destroy(what_if);
+	dyn_array_destroy(baseline);
+}
+
+// A blocks for IO after 3 ticks while B runs, the CPU idles 5-7 until A's IO is done
+TEST(io_bursts, FirstComeFirstServeTimeline)
+{
+	const uint32_t bursts[] = {4, 2};
+	ProcessControlBlock_t pcbs[2] = {
+		{3, 0, 0, false, 0, PCB_NO_DEADLINE, bursts, 2},
+		{2, 0, 1, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	const ScheduleConfig_t config = make_config(SCHEDULE_FCFS);
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.total_run_time, (uint64_t)9);
+	EXPECT_DOUBLE_EQ(result.average_waiting_time, 1.0);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, 6.5);
+	EXPECT_DOUBLE_EQ(result.cpu_utilization, 7.0 / 9.0);
+	EXPECT_DOUBLE_EQ(result.io_utilization, 4.0 / 9.0);
+	EXPECT_DOUBLE_EQ(result.throughput, 2.0 / 9.0);
+
+	// The batch FCFS can't model IO, the what-if state refuses it
+	EXPECT_EQ(what_if_create(ready_queue, SCHEDULE_FCFS), nullptr);
+	dyn_array_destroy(ready_queue);
+}
+
+// Every switch costs a tick: A 1-3, B 4-6, A 7-9
+TEST(context_switch, RoundRobinFixedCost)
+{
+	ProcessControlBlock_t pcbs[2] = {
+		{4, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 0, false, 1, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_RR, 2);
+	ScheduleResult_t free_switches;
+	ASSERT_EQ(sched_run(ready_queue, &config, &free_switches), true);
+	EXPECT_EQ(free_switches.context_switches, (uint64_t)3);
+	EXPECT_EQ(free_switches.switch_overhead, (uint64_t)0);
+
+	config.switch_cost = 1;
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.total_run_time, (uint64_t)9);
+	EXPECT_EQ(result.context_switches, (uint64_t)3);
+	EXPECT_EQ(result.switch_overhead, (uint64_t)3);
+	EXPECT_DOUBLE_EQ(result.average_waiting_time, 1.5);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, 7.5);
+	EXPECT_DOUBLE_EQ(result.cpu_utilization, 6.0 / 9.0);
+
+	// Without the cost round_robin counts switches the same way
+	ASSERT_EQ(round_robin(ready_queue, &result, 2), true);
+	EXPECT_EQ(result.context_switches, (uint64_t)3);
+	dyn_array_destroy(ready_queue);
+}
+
+// Both start cold (4 ticks), A comes back after 6 of the 8 decay ticks and pays 3
+TEST(context_switch, WarmupDecaysWithTimeAway)
+{
+	ProcessControlBlock_t pcbs[2] = {
+		{4, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 0, 0, false, 1, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_RR, 2);
+	config.warmup_cost = 4;
+	config.warmup_decay = 8;
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.total_run_time, (uint64_t)17);
+	EXPECT_EQ(result.switch_overhead, (uint64_t)11);
+	dyn_array_destroy(ready_queue);
+}
+
+// B arrives mid-switch and only preempts once A is switched in
+TEST(context_switch, SwitchIsNotInterrupted)
+{
+	ProcessControlBlock_t pcbs[2] = {
+		{10, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 1, false, 1, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_SRT);
+	config.switch_cost = 2;
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.total_run_time, (uint64_t)17);
+	EXPECT_EQ(result.context_switches, (uint64_t)3);
+	EXPECT_EQ(result.switch_overhead, (uint64_t)6);
+	// B waits from 1 to its dispatch at 2, completes at 5
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, (17.0 + 4.0) / 2.0);
+	dyn_array_destroy(ready_queue);
+}
+
+// Free switches give the same results through the legacy entry points, schedule_processes with the cost
+// knobs spelled out and the simulator fed one PCB at a time
+TEST(context_switch, FreeSwitchesMatchEveryPath)
+{
+	dyn_array_t *ready_queue = load_process_control_blocks("pcb.bin");
+	ASSERT_NE(ready_queue, nullptr);
+
+	for (int algorithm = SCHEDULE_FCFS; algorithm <= SCHEDULE_HRRN; ++algorithm)
+	{
+		const ScheduleConfig_t config = config_for((ScheduleAlgorithm_t)algorithm);
+		const char *name = schedule_algorithm_name(config.algorithm);
+		ScheduleResult_t expected;
+		ASSERT_TRUE(schedule_processes(ready_queue, &config, &expected)) << name;
+
+		ScheduleConfig_t spelled_out = config;
+		spelled_out.switch_cost = 0;
+		spelled_out.warmup_cost = 0;
+		spelled_out.warmup_decay = 10;
+		ScheduleResult_t result;
+		ASSERT_TRUE(schedule_processes(ready_queue, &spelled_out, &result)) << name;
+		expect_same_result(result, expected, name);
+
+		Scheduler_t *sched = sched_create(&config);
+		ASSERT_NE(sched, nullptr) << name;
+		for (size_t i = 0; i < dyn_array_size(ready_queue); ++i)
+		{
+			ASSERT_TRUE(sched_submit(sched, (const ProcessControlBlock_t *)dyn_array_at(ready_queue, i)));
+		}
+		ScheduleMetrics_t metrics;
+		ASSERT_TRUE(sched_drain(sched) && sched_snapshot_metrics(sched, &metrics)) << name;
+		expect_same_result(metrics.result, expected, name);
+		sched_destroy(sched);
+	}
+
+	ScheduleResult_t legacy, expected;
+	ScheduleConfig_t config = config_for(SCHEDULE_RR);
+	ASSERT_TRUE(round_robin(ready_queue, &legacy, config.quantum));
+	ASSERT_TRUE(schedule_processes(ready_queue, &config, &expected));
+	expect_same_result(legacy, expected, "RR");
+	config = config_for(SCHEDULE_SRT);
+	ASSERT_TRUE(shortest_remaining_time_first(ready_queue, &legacy));
+	ASSERT_TRUE(schedule_processes(ready_queue, &config, &expected));
+	expect_same_result(legacy, expected, "SRT");
+	dyn_array_destroy(ready_queue);
+}
+
+// A nominal and a half speed CPU: the fastest placement leaves the late PCB the slow CPU,
+// energy first puts the early one there and the late one finishes on the fast CPU
+TEST(multi_cpu, PlacementBySpeed)
+{
+	ProcessControlBlock_t pcbs[2] = {
+		{4, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 0, 1, false, 1, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_create(2, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	dyn_array_push_back(ready_queue, &pcbs[0]);
+	dyn_array_push_back(ready_queue, &pcbs[1]);
+
+	const uint32_t speeds[2] = {SCHEDULE_SPEED_NOMINAL, SCHEDULE_SPEED_NOMINAL / 2};
+	ScheduleConfig_t config = make_config(SCHEDULE_FCFS);
+	config.cpu_count = 2;
+	config.cpu_speeds = speeds;
+	ScheduleResult_t result;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.total_run_time, (uint64_t)9);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, 6.0);
+	EXPECT_DOUBLE_EQ(result.cpu_utilization, 12.0 / 18.0);
+
+	config.placement = SCHEDULE_PLACE_ENERGY;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.total_run_time, (uint64_t)8);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, 6.0);
+	dyn_array_destroy(ready_queue);
+}
+
+// B goes to the slow CPU, blocks, and wakes with both CPUs idle: only affinity keeps it there
+TEST(multi_cpu, AffinityAvoidsMigration)
+{
+	const uint32_t bursts[] = {5, 1};
+	const ProcessControlBlock_t pcbs[2] = {
+		{4, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 0, 0, false, 1, PCB_NO_DEADLINE, bursts, 2}
+	};
+	const uint32_t speeds[2] = {2 * SCHEDULE_SPEED_NOMINAL, SCHEDULE_SPEED_NOMINAL};
+	const SchedulePlacement_t placements[3] = {SCHEDULE_PLACE_FASTEST, SCHEDULE_PLACE_ENERGY, SCHEDULE_PLACE_AFFINITY};
+	const uint64_t migrations[3] = {1, 1, 0};
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		ScheduleConfig_t config = make_config(SCHEDULE_FCFS);
+		config.cpu_count = 2;
+		config.cpu_speeds = speeds;
+		config.placement = placements[i];
+		Scheduler_t *sched = sched_create(&config);
+		ASSERT_NE(sched, nullptr);
+		ASSERT_EQ(sched_submit(sched, &pcbs[0]), true);
+		ASSERT_EQ(sched_submit(sched, &pcbs[1]), true);
+		ASSERT_EQ(sched_drain(sched), true);
+
+		ScheduleMetrics_t metrics;
+		ASSERT_EQ(sched_snapshot_metrics(sched, &metrics), true);
+		EXPECT_EQ(metrics.migrations, migrations[i]);
+		EXPECT_EQ(metrics.completed, (uint64_t)2);
+		sched_destroy(sched);
+	}
+}
+
+// One CPU at nominal speed spelled out is the default, under every policy
+TEST(multi_cpu, OneNominalCpuMatchesDefault)
+{
+	dyn_array_t *ready_queue = load_process_control_blocks("pcb.bin");
+	ASSERT_NE(ready_queue, nullptr);
+	const uint32_t nominal = SCHEDULE_SPEED_NOMINAL;
+	for (int algorithm = SCHEDULE_FCFS; algorithm <= SCHEDULE_HRRN; ++algorithm)
+	{
+		ScheduleConfig_t config = config_for((ScheduleAlgorithm_t)algorithm);
+		const char *name = schedule_algorithm_name(config.algorithm);
+		ScheduleResult_t expected, result;
+		ASSERT_TRUE(schedule_processes(ready_queue, &config, &expected)) << name;
+		config.cpu_count = 1;
+		ASSERT_TRUE(schedule_processes(ready_queue, &config, &result)) << name;
+		expect_same_result(result, expected, name);
+		config.cpu_speeds = &nominal;
+		config.placement = SCHEDULE_PLACE_AFFINITY;
+		ASSERT_TRUE(schedule_processes(ready_queue, &config, &result)) << name;
+		expect_same_result(result, expected, name);
+	}
+	dyn_array_destroy(ready_queue);
+}
+
+// A runs while B waits in a queue of one; C arrives to a full queue and is turned away, waits for B to be
+// dispatched, or takes the place of B, which has a lower priority
+TEST(admission, FullQueuePolicies)
+{
+	ProcessControlBlock_t pcbs[3] = {
+		{4, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 5, 1, false, 1, PCB_NO_DEADLINE, NULL, 0},
+		{2, 1, 2, false, 2, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_create(3, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		dyn_array_push_back(ready_queue, &pcbs[i]);
+	}
+
+	ScheduleConfig_t config = make_config(SCHEDULE_FCFS);
+	config.ready_capacity = 1;
+	ScheduleResult_t result;
+
+	config.admission = SCHEDULE_ADMIT_REJECT;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.rejected, (uint64_t)1);
+	EXPECT_EQ(result.dropped, (uint64_t)0);
+	EXPECT_EQ(result.time_at_capacity, (uint64_t)3);
+	EXPECT_EQ(result.total_run_time, (uint64_t)6);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, 4.5);
+
+	config.admission = SCHEDULE_ADMIT_DELAY;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.rejected, (uint64_t)0);
+	EXPECT_EQ(result.time_at_capacity, (uint64_t)5);
+	EXPECT_EQ(result.total_run_time, (uint64_t)8);
+	EXPECT_DOUBLE_EQ(result.average_waiting_time, 7.0 / 3.0);
+
+	config.admission = SCHEDULE_ADMIT_DROP_LOWEST;
+	ASSERT_EQ(schedule_processes(ready_queue, &config, &result), true);
+	EXPECT_EQ(result.rejected, (uint64_t)0);
+	EXPECT_EQ(result.dropped, (uint64_t)1);
+	EXPECT_EQ(result.time_at_capacity, (uint64_t)3);
+	EXPECT_EQ(result.total_run_time, (uint64_t)6);
+	EXPECT_DOUBLE_EQ(result.average_turnaround_time, 4.0);
+	dyn_array_destroy(ready_queue);
+}
+
+// A capacity the queue never reaches changes nothing, whatever the admission policy
+TEST(admission, NonBindingCapacityMatchesUnbounded)
+{
+	dyn_array_t *ready_queue = load_process_control_blocks("pcb.bin");
+	ASSERT_NE(ready_queue, nullptr);
+	const ScheduleAdmission_t admissions[] = {SCHEDULE_ADMIT_REJECT, SCHEDULE_ADMIT_DELAY, SCHEDULE_ADMIT_DROP_LOWEST};
+	for (int algorithm = SCHEDULE_FCFS; algorithm <= SCHEDULE_HRRN; ++algorithm)
+	{
+		ScheduleConfig_t config = config_for((ScheduleAlgorithm_t)algorithm);
+		const char *name = schedule_algorithm_name(config.algorithm);
+		ScheduleResult_t expected, result;
+		ASSERT_TRUE(schedule_processes(ready_queue, &config, &expected)) << name;
+		config.ready_capacity = 1000000;
+		for (ScheduleAdmission_t admission : admissions)
+		{
+			config.admission = admission;
+			ASSERT_TRUE(schedule_processes(ready_queue, &config, &result)) << name;
+			expect_same_result(result, expected, name);
+		}
+	}
+	dyn_array_destroy(ready_queue);
+}
+
+// D arrives to a full queue of three and evicts B from the middle of it, under every policy
+TEST(admission, DropLowestFromEveryPolicy)
+{
+	const ProcessControlBlock_t pcbs[4] = {
+		{3, 0, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{1, 9, 0, false, 1, PCB_NO_DEADLINE, NULL, 0},
+		{1, 2, 0, false, 2, PCB_NO_DEADLINE, NULL, 0},
+		{1, 1, 0, false, 3, PCB_NO_DEADLINE, NULL, 0}
+	};
+	const ScheduleAlgorithm_t algorithms[] = {SCHEDULE_FCFS, SCHEDULE_SJF, SCHEDULE_PRIORITY, SCHEDULE_RR,
+											  SCHEDULE_SRT, SCHEDULE_PRIORITY_PREEMPTIVE, SCHEDULE_MLFQ, SCHEDULE_CFS,
+											  SCHEDULE_EDF, SCHEDULE_EDF_PREEMPTIVE, SCHEDULE_HRRN};
+
+	for (const ScheduleAlgorithm_t algorithm : algorithms)
+	{
+		ScheduleConfig_t config = make_config(algorithm);
+		config.quantum = 1;
+		config.levels = 3;
+		config.target_latency = 4;
+		config.min_granularity = 1;
+		config.ready_capacity = 3;
+		config.admission = SCHEDULE_ADMIT_DROP_LOWEST;
+		Scheduler_t *sched = sched_create(&config);
+		ASSERT_NE(sched, nullptr);
+		for (const ProcessControlBlock_t &pcb : pcbs)
+		{
+			ASSERT_EQ(sched_submit(sched, &pcb), true);
+		}
+		ASSERT_EQ(sched_drain(sched), true);
+
+		ScheduleMetrics_t metrics;
+		ASSERT_EQ(sched_snapshot_metrics(sched, &metrics), true);
+		EXPECT_EQ(metrics.completed, (uint64_t)3) << schedule_algorithm_name(algorithm);
+		EXPECT_EQ(metrics.result.dropped, (uint64_t)1) << schedule_algorithm_name(algorithm);
+		if (algorithm == SCHEDULE_RR)
+		{
+			// C, D, then A's remaining two ticks
+			EXPECT_EQ(metrics.total_turnaround_time, (uint64_t)10);
+		}
+		sched_destroy(sched);
+	}
+}
+
+// Stops half way through, checkpoints, and finishes from the checkpoint in a fresh simulator,
+// the PCBs arriving after the checkpoint fed only after the restore
+TEST(checkpoint, ResumeMatchesUninterrupted)
+{
+	const uint32_t bursts[] = {3, 2, 4, 1};
+	const ProcessControlBlock_t pcbs[5] = {
+		{6, 3, 0, false, 0, PCB_NO_DEADLINE, bursts, 4},
+		{4, 1, 1, false, 1, PCB_NO_DEADLINE, NULL, 0},
+		{2, 7, 2, false, 2, PCB_NO_DEADLINE, bursts, 2},
+		{5, 0, 9, false, 3, PCB_NO_DEADLINE, NULL, 0},
+		{1, 2, 12, false, 4, PCB_NO_DEADLINE, NULL, 0}
+	};
+	const ScheduleAlgorithm_t algorithms[] = {SCHEDULE_RR, SCHEDULE_SRT, SCHEDULE_PRIORITY_PREEMPTIVE, SCHEDULE_MLFQ,
+											  SCHEDULE_CFS, SCHEDULE_HRRN};
+	const char *path = "sched_checkpoint.ck";
+
+	for (const ScheduleAlgorithm_t algorithm : algorithms)
+	{
+		ScheduleConfig_t config = make_config(algorithm);
+		config.quantum = 2;
+		config.aging_interval = 3;
+		config.levels = 3;
+		config.target_latency = 6;
+		config.min_granularity = 1;
+		config.switch_cost = 1;
+
+		Scheduler_t *sched = sched_create(&config);
+		ASSERT_NE(sched, nullptr);
+		for (const ProcessControlBlock_t &pcb : pcbs)
+		{
+			ASSERT_EQ(sched_submit(sched, &pcb), true);
+		}
+		ScheduleMetrics_t expected;
+		ASSERT_EQ(sched_drain(sched), true);
+		ASSERT_EQ(sched_snapshot_metrics(sched, &expected), true);
+		sched_destroy(sched);
+
+		sched = sched_create(&config);
+		ASSERT_NE(sched, nullptr);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			ASSERT_EQ(sched_submit(sched, &pcbs[i]), true);
+		}
+		ASSERT_EQ(sched_advance_to(sched, 8), true);
+		ASSERT_EQ(sched_checkpoint(sched, path, 5, 3), true);
+		sched_destroy(sched);
+
+		uint64_t fed = 0;
+		sched = sched_restore(&config, path, 5, &fed);
+		ASSERT_NE(sched, nullptr) << schedule_algorithm_name(algorithm);
+		ASSERT_EQ(fed, (uint64_t)3);
+		for (size_t i = fed; i < 5; ++i)
+		{
+			ASSERT_EQ(sched_submit(sched, &pcbs[i]), true);
+		}
+		ScheduleMetrics_t resumed;
+		ASSERT_EQ(sched_drain(sched), true);
+		ASSERT_EQ(sched_snapshot_metrics(sched, &resumed), true);
+		sched_destroy(sched);
+
+		EXPECT_EQ(resumed.clock, expected.clock) << schedule_algorithm_name(algorithm);
+		EXPECT_EQ(resumed.total_waiting_time, expected.total_waiting_time) << schedule_algorithm_name(algorithm);
+		EXPECT_EQ(resumed.total_turnaround_time, expected.total_turnaround_time) << schedule_algorithm_name(algorithm);
+		EXPECT_EQ(resumed.busy_time, expected.busy_time) << schedule_algorithm_name(algorithm);
+		EXPECT_EQ(resumed.io_busy_time, expected.io_busy_time) << schedule_algorithm_name(algorithm);
+		EXPECT_EQ(resumed.result.context_switches, expected.result.context_switches)
+			<< schedule_algorithm_name(algorithm);
+	}
+	remove(path);
+}
+
+TEST(checkpoint, RejectsOtherConfigOrInput)
+{
+	const char *path = "sched_checkpoint_config.ck";
+	ScheduleConfig_t config = make_config(SCHEDULE_RR);
+	config.quantum = 3;
+	Scheduler_t *sched = sched_create(&config);
+	ASSERT_NE(sched, nullptr);
+	ASSERT_EQ(sched_checkpoint(sched, path, 11, 0), true);
+	sched_destroy(sched);
+
+	uint64_t fed;
+	config.quantum = 4;
+	EXPECT_EQ(sched_restore(&config, path, 11, &fed), nullptr);
+	EXPECT_EQ(sched_restore(&config, "missing.ck", 11, &fed), nullptr);
+
+	config.quantum = 3;
+	EXPECT_EQ(sched_restore(&config, path, 12, &fed), nullptr);
+	sched = sched_restore(&config, path, 11, &fed);
+	EXPECT_NE(sched, nullptr);
+	sched_destroy(sched);
+	remove(path);
+}
+
+// Each workload only depends on the seed and its index, so the thread count can't change a summary
+TEST(monte_carlo, SameSummariesForAnyThreadCount)
+{
+	ScheduleConfig_t configs[3] = {make_config(SCHEDULE_SRT), make_config(SCHEDULE_RR),
+								   make_config(SCHEDULE_EDF_PREEMPTIVE)};
+	configs[1].quantum = 3;
+	configs[1].switch_cost = 1;
+	MonteCarloSweep_t sweep = {{50, 6.0, 5.0, 8, 2, 4.0, 2.5}, 24, 7, configs, 3, 1};
+	MonteCarloSummary_t single[3];
+	MonteCarloSummary_t pooled[3];
+	ASSERT_EQ(monte_carlo_sweep(&sweep, single), true);
+	sweep.threads = 4;
+	ASSERT_EQ(monte_carlo_sweep(&sweep, pooled), true);
+
+	for (size_t c = 0; c < 3; ++c)
+	{
+		for (size_t m = 0; m < MONTE_CARLO_METRIC_COUNT; ++m)
+		{
+			EXPECT_EQ(single[c].metrics[m].mean, pooled[c].metrics[m].mean) << monte_carlo_metric_name((MonteCarloMetric_t)m);
+			EXPECT_EQ(single[c].metrics[m].half_width, pooled[c].metrics[m].half_width);
+		}
+	}
+	EXPECT_GT(single[0].metrics[MONTE_CARLO_WAITING_TIME].half_width, 0.0);
+	EXPECT_GT(single[1].metrics[MONTE_CARLO_CONTEXT_SWITCHES].mean, 0.0);
+	EXPECT_GT(single[2].metrics[MONTE_CARLO_IO_UTILIZATION].mean, 0.0);
+
+	sweep.seed = 8;
+	ASSERT_EQ(monte_carlo_sweep(&sweep, pooled), true);
+	EXPECT_NE(single[0].metrics[MONTE_CARLO_WAITING_TIME].mean, pooled[0].metrics[MONTE_CARLO_WAITING_TIME].mean);
+}
+
+// The summary is the plain mean and t interval of running each generated workload on its own
+TEST(monte_carlo, MatchesSeparateRuns)
+{
+	ScheduleConfig_t config = make_config(SCHEDULE_SJF);
+	const MonteCarloWorkload_t shape = {30, 4.0, 6.0, 0, 0, 0.0, 0.0};
+	MonteCarloSweep_t sweep = {shape, 5, 42, &config, 1, 2};
+	MonteCarloSummary_t summary;
+	ASSERT_EQ(monte_carlo_sweep(&sweep, &summary), true);
+
+	double waits[5];
+	double sum = 0.0;
+	for (size_t k = 0; k < 5; ++k)
+	{
+		PcbWorkload_t *workload = monte_carlo_workload(&shape, 42, k);
+		ASSERT_NE(workload, nullptr);
+		ASSERT_EQ(dyn_array_size(workload->pcbs), (size_t)30);
+		EXPECT_EQ(((ProcessControlBlock_t *)dyn_array_at(workload->pcbs, 0))->arrival, (uint64_t)0);
+		ScheduleResult_t result;
+		ASSERT_EQ(sched_run(workload->pcbs, &config, &result), true);
+		waits[k] = result.average_waiting_time;
+		sum += waits[k];
+		pcb_workload_destroy(workload);
+	}
+	const double mean = sum / 5;
+	double squares = 0.0;
+	for (const double wait : waits)
+	{
+		squares += (wait - mean) * (wait - mean);
+	}
+	EXPECT_NEAR(summary.metrics[MONTE_CARLO_WAITING_TIME].mean, mean, 1e-9);
+	EXPECT_NEAR(summary.metrics[MONTE_CARLO_WAITING_TIME].half_width, 2.776 * sqrt(squares / 4 / 5), 1e-9);
+
+	sweep.workloads = 1;
+	EXPECT_EQ(monte_carlo_sweep(&sweep, &summary), false);
+	config.algorithm = SCHEDULE_RR;
+	sweep.workloads = 5;
+	EXPECT_EQ(monte_carlo_sweep(&sweep, &summary), false);
+}
+
+// Handles on one file see each other's stores, and a later store under a key replaces the earlier one
+TEST(result_cache, StoreLookupAcrossHandles)
+{
+	const char *path = "result_cache_handles.bin";
+	remove(path);
+	ResultCache_t *first = result_cache_open(path);
+	ResultCache_t *second = result_cache_open(path);
+	ASSERT_NE(first, nullptr);
+	ASSERT_NE(second, nullptr);
+
+	ScheduleConfig_t config = make_config(SCHEDULE_RR);
+	config.quantum = 3;
+	ScheduleConfig_t other = config;
+	other.quantum = 4;
+	EXPECT_EQ(sched_config_hash(&config), sched_config_hash(&config));
+	EXPECT_NE(sched_config_hash(&config), sched_config_hash(&other));
+
+	const ResultCacheKey_t key = {0x1234, 80, sched_config_hash(&config)};
+	const ResultCacheKey_t other_key = {0x1234, 80, sched_config_hash(&other)};
+	ScheduleResult_t stored = {};
+	stored.average_waiting_time = 2.5;
+	stored.total_run_time = 40;
+	ScheduleResult_t found;
+	uint32_t flags = 0;
+	EXPECT_EQ(result_cache_lookup(second, &key, &found, &flags), false);
+	ASSERT_EQ(result_cache_store(first, &key, &stored, 3), true);
+	ASSERT_EQ(result_cache_lookup(second, &key, &found, &flags), true);
+	EXPECT_EQ(found.average_waiting_time, 2.5);
+	EXPECT_EQ(found.total_run_time, (uint64_t)40);
+	EXPECT_EQ(flags, (uint32_t)3);
+	EXPECT_EQ(result_cache_lookup(second, &other_key, &found, NULL), false);
+
+	stored.total_run_time = 41;
+	ASSERT_EQ(result_cache_store(second, &key, &stored, 1), true);
+	result_cache_close(first);
+	result_cache_close(second);
+
+	first = result_cache_open(path);
+	ASSERT_NE(first, nullptr);
+	ASSERT_EQ(result_cache_lookup(first, &key, &found, &flags), true);
+	EXPECT_EQ(found.total_run_time, (uint64_t)41);
+	EXPECT_EQ(flags, (uint32_t)1);
+	result_cache_close(first);
+	remove(path);
+}
+
+// Records cut short or damaged are skipped, and a file that isn't a cache is refused
+TEST(result_cache, SkipsTornRecords)
+{
+	const char *path = "result_cache_torn.bin";
+	remove(path);
+	ResultCache_t *cache = result_cache_open(path);
+	ASSERT_NE(cache, nullptr);
+	const ResultCacheKey_t keys[3] = {{1, 10, 7}, {2, 20, 7}, {3, 30, 7}};
+	ScheduleResult_t stored = {};
+	stored.total_run_time = 5;
+	ASSERT_EQ(result_cache_store(cache, &keys[0], &stored, 0), true);
+
+	// A store that crashed part way, the next one starts past it
+	FILE *file = fopen(path, "ab");
+	ASSERT_NE(file, nullptr);
+	fputs("torn", file);
+	fclose(file);
+	ASSERT_EQ(result_cache_store(cache, &keys[1], &stored, 0), true);
+	ASSERT_EQ(result_cache_store(cache, &keys[2], &stored, 0), true);
+	result_cache_close(cache);
+
+	// Flip a byte in the last record's result
+	file = fopen(path, "r+b");
+	ASSERT_NE(file, nullptr);
+	ASSERT_EQ(fseek(file, -40, SEEK_END), 0);
+	fputc(0xff, file);
+	fclose(file);
+
+	cache = result_cache_open(path);
+	ASSERT_NE(cache, nullptr);
+	ScheduleResult_t found;
+	EXPECT_EQ(result_cache_lookup(cache, &keys[0], &found, NULL), true);
+	EXPECT_EQ(result_cache_lookup(cache, &keys[1], &found, NULL), true);
+	EXPECT_EQ(found.total_run_time, (uint64_t)5);
+	EXPECT_EQ(result_cache_lookup(cache, &keys[2], &found, NULL), false);
+	result_cache_close(cache);
+
+	file = fopen(path, "wb");
+	ASSERT_NE(file, nullptr);
+	fputs("not a result cache", file);
+	fclose(file);
+	EXPECT_EQ(result_cache_open(path), nullptr);
+	EXPECT_EQ(result_cache_open(NULL), nullptr);
+	remove(path);
+}
+
+static void *run_priority_for_counters(void *arg)
+{
+	ScheduleResult_t result;
+	const ScheduleConfig_t config = make_config(SCHEDULE_PRIORITY);
+	sched_run((const dyn_array_t *)arg, &config, &result);
+	return NULL;
+}
+
+// The counters follow the schedule that ran on this thread, and no other thread's
+TEST(op_counters, CountThisThreadsRun)
+{
+	if (!op_counters_enabled())
+	{
+		GTEST_SKIP() << "built with OP_COUNTERS=OFF";
+	}
+	ProcessControlBlock_t pcbs[4] = {
+		{6, 1, 3, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 2, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 3, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 1, 20, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_import(pcbs, 4, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	op_counters_reset();
+	OpCounters_t counters;
+	op_counters_read(&counters);
+	for (size_t i = 0; i < OP_COUNTER_COUNT; ++i)
+	{
+		EXPECT_EQ(counters.counts[i], (uint64_t)0) << op_counter_name((OpCounter_t)i);
+	}
+
+	ScheduleResult_t result;
+	ASSERT_EQ(first_come_first_serve(ready_queue, &result), true);
+	op_counters_read(&counters);
+	EXPECT_GT(counters.counts[OP_COMPARISONS], (uint64_t)0);
+	EXPECT_GE(counters.counts[OP_ARRAY_ACCESSES], (uint64_t)4);
+	EXPECT_GE(counters.counts[OP_HEAP_OPERATIONS], (uint64_t)8);
+	EXPECT_EQ(counters.counts[OP_TICKS], result.total_run_time);
+	EXPECT_GE(counters.counts[OP_EVENTS], (uint64_t)4);
+	// The input is out of arrival order, ordering it is timed as sorting
+	EXPECT_GT(counters.counts[OP_SORT_NANOSECONDS], (uint64_t)0);
+
+	pthread_t thread;
+	ASSERT_EQ(pthread_create(&thread, NULL, run_priority_for_counters, ready_queue), 0);
+	pthread_join(thread, NULL);
+	OpCounters_t after;
+	op_counters_read(&after);
+	EXPECT_EQ(memcmp(&counters, &after, sizeof(counters)), 0);
+
+	op_counters_reset();
+	const ScheduleConfig_t config = make_config(SCHEDULE_PRIORITY);
+	ASSERT_EQ(sched_run(ready_queue, &config, &result), true);
+	op_counters_read(&counters);
+	EXPECT_GE(counters.counts[OP_HEAP_OPERATIONS], (uint64_t)8);
+	EXPECT_EQ(counters.counts[OP_TICKS], result.total_run_time);
+	EXPECT_EQ(op_counter_name(OP_COUNTER_COUNT), nullptr);
+	dyn_array_destroy(ready_queue);
+}
+
+// The simulator steps from event to event, not tick by tick, dyn_array counts what moves and grows
+TEST(op_counters, HotPaths)
+{
+	if (!op_counters_enabled())
+	{
+		GTEST_SKIP() << "built with OP_COUNTERS=OFF";
+	}
+	ProcessControlBlock_t pcbs[4] = {
+		{6, 1, 3, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{2, 2, 0, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{4, 3, 1, false, 0, PCB_NO_DEADLINE, NULL, 0},
+		{3, 1, 20, false, 0, PCB_NO_DEADLINE, NULL, 0}
+	};
+	dyn_array_t *ready_queue = dyn_array_import(pcbs, 4, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(ready_queue, nullptr);
+
+	op_counters_reset();
+	ScheduleResult_t result;
+	ASSERT_EQ(shortest_remaining_time_first(ready_queue, &result), true);
+	OpCounters_t counters;
+	op_counters_read(&counters);
+	EXPECT_EQ(counters.counts[OP_TICKS], result.total_run_time);
+	EXPECT_LT(counters.counts[OP_EVENTS], (uint64_t)15);
+	EXPECT_EQ(counters.counts[OP_MEMMOVE_BYTES], (uint64_t)0);
+
+	op_counters_reset();
+	dyn_array_t *array = dyn_array_create(16, sizeof(int), NULL);
+	ASSERT_NE(array, nullptr);
+	for (int i = 0; i < 17; ++i)
+	{
+		ASSERT_EQ(dyn_array_push_front(array, &i), true);
+	}
+	ASSERT_EQ(dyn_array_pop_back(array), true);
+	ASSERT_EQ(dyn_array_pop_front(array), true);
+	op_counters_read(&counters);
+	EXPECT_EQ(counters.counts[OP_REALLOCS], (uint64_t)1);
+	// Pushing in front of 1 to 16 ints, then popping the front of the 16 left
+	EXPECT_EQ(counters.counts[OP_MEMMOVE_BYTES], (uint64_t)((136 + 15) * sizeof(int)));
+	dyn_array_destroy(array);
+	dyn_array_destroy(ready_queue);
+}
+
+// Two PCB runs make far more than PCB_STREAM_FAN_IN of them, so they are merged in several passes
+TEST(pcb_stream, ArrivalOrderAndSameSchedule)
+{
+	const char *path = "pcb_stream_input.bin";
+	const size_t n = 300;
+	dyn_array_t *pcbs = dyn_array_create(n, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(pcbs, nullptr);
+	srand(46);
+	for (size_t i = 0; i < n; ++i)
+	{
+		// Few distinct arrivals, so ties have to come back in file order
+		const uint64_t arrival = (uint64_t)(rand() % 150);
+		ProcessControlBlock_t pcb = {(uint32_t)(1 + rand() % 9), (uint32_t)(rand() % 40), arrival, false, 0,
+									 i % 3 ? arrival + 10 + (uint64_t)(rand() % 40) : PCB_NO_DEADLINE, NULL, 0};
+		ASSERT_EQ(dyn_array_push_back(pcbs, &pcb), true);
+	}
+	ASSERT_EQ(save_process_control_blocks(path, pcbs), true);
+	dyn_array_t *loaded = load_process_control_blocks(path);
+	ASSERT_NE(loaded, nullptr);
+
+	PcbStream_t *stream = pcb_stream_open(path, 2, NULL);
+	ASSERT_NE(stream, nullptr);
+	EXPECT_EQ(pcb_stream_count(stream), (uint64_t)n);
+	EXPECT_EQ(pcb_stream_has_deadlines(stream), true);
+	std::vector<bool> seen(n, false);
+	ProcessControlBlock_t previous = {};
+	ProcessControlBlock_t pcb;
+	size_t count = 0;
+	while (pcb_stream_next(stream, &pcb))
+	{
+		ASSERT_LT(pcb.pid, n);
+		const ProcessControlBlock_t *original = (const ProcessControlBlock_t *)dyn_array_at(loaded, pcb.pid);
+		EXPECT_EQ(seen[pcb.pid], false);
+		seen[pcb.pid] = true;
+		EXPECT_EQ(pcb.arrival, original->arrival);
+		EXPECT_EQ(pcb.remaining_burst_time, original->remaining_burst_time);
+		EXPECT_EQ(pcb.deadline, original->deadline);
+		if (count++ > 0)
+		{
+			EXPECT_TRUE(previous.arrival < pcb.arrival || (previous.arrival == pcb.arrival && previous.pid < pcb.pid));
+		}
+		previous = pcb;
+	}
+	EXPECT_EQ(pcb_stream_failed(stream), false);
+	EXPECT_EQ(count, n);
+	pcb_stream_close(stream);
+
+	ScheduleConfig_t configs[3] = {make_config(SCHEDULE_RR), make_config(SCHEDULE_SRT),
+								   make_config(SCHEDULE_EDF_PREEMPTIVE)};
+	configs[0].quantum = 3;
+	configs[1].cpu_count = 2;
+	for (size_t c = 0; c < 3; ++c)
+	{
+		ScheduleResult_t expected;
+		ScheduleResult_t streamed;
+		ASSERT_EQ(sched_run(loaded, &configs[c], &expected), true);
+		stream = pcb_stream_open(path, 7, NULL);
+		ASSERT_NE(stream, nullptr);
+		ASSERT_EQ(pcb_stream_schedule(stream, &configs[c], &streamed), true);
+		pcb_stream_close(stream);
+		EXPECT_EQ(memcmp(&expected, &streamed, sizeof(ScheduleResult_t)), 0) << "config " << c;
+	}
+
+	dyn_array_destroy(loaded);
+	dyn_array_destroy(pcbs);
+	remove(path);
+}
+
+// A streamed run is the in-memory run of the same file, for every policy, with the input out of arrival order
+TEST(pcb_stream, MatchesInMemoryRun)
+{
+	const char *path = "pcb_stream_policies.bin";
+	const size_t n = 500;
+	dyn_array_t *pcbs = dyn_array_create(n, sizeof(ProcessControlBlock_t), NULL);
+	ASSERT_NE(pcbs, nullptr);
+	srand(4646);
+	for (size_t i = 0; i < n; ++i)
+	{
+		const uint64_t arrival = (uint64_t)(rand() % 1500);
+		ProcessControlBlock_t pcb = {(uint32_t)(1 + rand() % 12), (uint32_t)(rand() % 10), arrival, false, 0,
+									 arrival + 20 + (uint64_t)(rand() % 60), NULL, 0};
+		ASSERT_EQ(dyn_array_push_back(pcbs, &pcb), true);
+	}
+	ASSERT_EQ(save_process_control_blocks(path, pcbs), true);
+	dyn_array_t *loaded = load_process_control_blocks(path);
+	ASSERT_NE(loaded, nullptr);
+
+	for (int algorithm = SCHEDULE_FCFS; algorithm <= SCHEDULE_HRRN; ++algorithm)
+	{
+		const ScheduleConfig_t config = config_for((ScheduleAlgorithm_t)algorithm);
+		const char *name = schedule_algorithm_name(config.algorithm);
+		ScheduleResult_t expected, streamed;
+		ASSERT_TRUE(schedule_processes(loaded, &config, &expected)) << name;
+		PcbStream_t *stream = pcb_stream_open(path, 64, NULL);
+		ASSERT_NE(stream, nullptr);
+		ASSERT_TRUE(pcb_stream_schedule(stream, &config, &streamed)) << name;
+		pcb_stream_close(stream);
+		expect_same_result(streamed, expected, name);
+	}
+
+	dyn_array_destroy(loaded);
+	dyn_array_destroy(pcbs);
+	remove(path);
+}
+
+// The merge is a stable sort by arrival of the shards laid end to end, whatever order each shard is in
+TEST(pcb_shards, MergeByArrival)
+{
+	const char *paths[5] = {"pcb_shard_0.bin", "pcb_shard_1.bin", "pcb_shard_2.bin", "pcb_shard_3.bin",
+							"pcb_shard_4.bin"};
+	const uint32_t bursts[4] = {3, 2, 5, 1};
+	std::vector<ProcessControlBlock_t> expected;
+	srand(47);
+	for (size_t s = 0; s < 5; ++s)
+	{
+		// Shard 3 is empty, shard 1 has IO bursts
+		dyn_array_t *shard = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+		ASSERT_NE(shard, nullptr);
+		for (size_t i = 0; s != 3 && i < 40 + 10 * s; ++i)
+		{
+			ProcessControlBlock_t pcb = {(uint32_t)(1 + rand() % 9), (uint32_t)s, (uint64_t)(rand() % 60), false,
+										 (uint32_t)i, PCB_NO_DEADLINE, NULL, 0};
+			if (s == 1 && i % 2)
+			{
+				pcb.next_bursts = bursts + (i % 4 == 1 ? 0 : 2);
+				pcb.next_burst_count = 2;
+			}
+			ASSERT_EQ(dyn_array_push_back(shard, &pcb), true);
+			expected.push_back(pcb);
+		}
+		ASSERT_EQ(save_process_control_blocks(paths[s], shard), true);
+		dyn_array_destroy(shard);
+	}
+	std::stable_sort(expected.begin(), expected.end(),
+					 [](const ProcessControlBlock_t &a, const ProcessControlBlock_t &b) { return a.arrival < b.arrival; });
+
+	for (size_t threads = 1; threads <= 3; threads += 2)
+	{
+		PcbWorkload_t *merged = load_pcb_shards(paths, 5, threads);
+		ASSERT_NE(merged, nullptr);
+		ASSERT_EQ(dyn_array_size(merged->pcbs), expected.size());
+		for (size_t k = 0; k < expected.size(); ++k)
+		{
+			const ProcessControlBlock_t *pcb = (const ProcessControlBlock_t *)dyn_array_at(merged->pcbs, k);
+			EXPECT_EQ(pcb->pid, (uint32_t)k);
+			EXPECT_EQ(pcb->arrival, expected[k].arrival);
+			EXPECT_EQ(pcb->priority, expected[k].priority);
+			EXPECT_EQ(pcb->remaining_burst_time, expected[k].remaining_burst_time);
+			ASSERT_EQ(pcb->next_burst_count, expected[k].next_burst_count);
+			if (pcb->next_burst_count)
+			{
+				EXPECT_NE(pcb->next_bursts, expected[k].next_bursts);
+				EXPECT_EQ(pcb->next_bursts[0], expected[k].next_bursts[0]);
+				EXPECT_EQ(pcb->next_bursts[1], expected[k].next_bursts[1]);
+			}
+		}
+		pcb_workload_destroy(merged);
+	}
+
+	remove(paths[2]);
+	EXPECT_EQ(load_pcb_shards(paths, 5, 2), nullptr);
+	for (size_t s = 0; s < 5; ++s)
+	{
+		remove(paths[s]);
+	}
+}
+
+// bash runs 40us, is preempted by sched_x for 20us, runs 30us more and blocks; ftrace and perf lines mix
+TEST(trace_import, RunnableIntervalsBecomePcbs)
+{
+	const char *trace =
+		"# tracer: nop\n"
+		"  <idle>-0  [000] d..2.  100.000000: sched_wakeup: comm=bash pid=10 prio=120 target_cpu=000\n"
+		"  <idle>-0  [000] d..2.  100.000010: sched_switch: prev_comm=swapper/0 prev_pid=0 prev_prio=120 "
+		"prev_state=R ==> next_comm=bash next_pid=10 next_prio=120\n"
+		"  sched_x    20 [001]   100.000020:  sched:sched_wakeup: sched_x:20 [115] CPU:001\n"
+		"  bash    10 [000]   100.000050:  sched:sched_switch: bash:10 [120] R+ ==> sched_x:20 [115]\n"
+		"  bash-10  [000] d..2.  100.000060: sched_switch: prev_comm=bash prev_pid=10 broken\n"
+		"  sched_x-20  [000] d..2.  100.000070: sched_switch: prev_comm=sched_x prev_pid=20 prev_prio=115 "
+		"prev_state=S ==> next_comm=bash next_pid=10 next_prio=120\n"
+		"  bash-10  [000] d..2.  100.000100: sched_switch: prev_comm=bash prev_pid=10 prev_prio=120 "
+		"prev_state=D ==> next_comm=rt next_pid=30 next_prio=49\n"
+		"  rt-30  [000] d..2.  100.000125: sched_switch: prev_comm=rt prev_pid=30 prev_prio=49 prev_state=R ==> "
+		"next_comm=swapper/0 next_pid=0 next_prio=120";
+	FILE *input = tmpfile();
+	ASSERT_NE(input, nullptr);
+	fputs(trace, input);
+	rewind(input);
+
+	const char *path = "trace_import.bin";
+	TraceImportStats_t stats;
+	ASSERT_EQ(trace_import(input, path, 10000, true, &stats), true);
+	fclose(input);
+	EXPECT_EQ(stats.lines, (uint64_t)9);
+	EXPECT_EQ(stats.events, (uint64_t)7);
+	EXPECT_EQ(stats.skipped, (uint64_t)1);
+	EXPECT_EQ(stats.tasks, (uint64_t)3);
+	EXPECT_EQ(stats.pcbs, (uint64_t)3);
+
+	// In the order they end: sched_x, bash, then rt still runnable at the end of the trace
+	dyn_array_t *pcbs = load_process_control_blocks(path);
+	ASSERT_NE(pcbs, nullptr);
+	ASSERT_EQ(dyn_array_size(pcbs), (size_t)3);
+	const uint32_t bursts[3] = {2, 7, 3};
+	const uint32_t priorities[3] = {15, 20, 0};
+	const uint64_t arrivals[3] = {2, 0, 10};
+	for (size_t i = 0; i < 3; ++i)
+	{
+		const ProcessControlBlock_t *pcb = (const ProcessControlBlock_t *)dyn_array_at(pcbs, i);
+		EXPECT_EQ(pcb->remaining_burst_time, bursts[i]) << i;
+		EXPECT_EQ(pcb->priority, priorities[i]) << i;
+		EXPECT_EQ(pcb->arrival, arrivals[i]) << i;
+	}
+	dyn_array_destroy(pcbs);
+	remove(path);
+}
+
+// dyn_array_sort is a stable natural merge sort that remembers what it sorted by
+struct keyed_t
+{
+	uint32_t key;
+	uint32_t tag;
+};
+
+static size_t keyed_comparisons = 0;
+
+static int compare_keyed(const void *a, const void *b)
+{
+	++keyed_comparisons;
+	const uint32_t x = ((const keyed_t *)a)->key;
+	const uint32_t y = ((const keyed_t *)b)->key;
+	return x < y ? -1 : x > y;
+}
+
+TEST(dyn_array_sort, SortedInputIsLinearAndSortIsRemembered)
+{
+	const size_t n = 10000;
+	dyn_array_t *array = dyn_array_create(n, sizeof(keyed_t), NULL);
+	ASSERT_NE(array, nullptr);
+	for (size_t i = 0; i < n; ++i)
+	{
+		keyed_t object = {(uint32_t)(i / 3), (uint32_t)i};
+		ASSERT_TRUE(dyn_array_push_back(array, &object));
+	}
+
+	keyed_comparisons = 0;
+	op_counters_reset();
+	ASSERT_TRUE(dyn_array_sort(array, compare_keyed));
+	EXPECT_EQ(keyed_comparisons, n - 1);
+	// Each comparator call is counted, unless the counters are compiled out
+	OpCounters_t counters;
+	op_counters_read(&counters);
+	EXPECT_EQ(counters.counts[OP_COMPARISONS], op_counters_enabled() ? (uint64_t)(n - 1) : (uint64_t)0);
+	// Reading through export keeps the order known
+	EXPECT_EQ(((const keyed_t *)dyn_array_export(array))[0].key, (uint32_t)0);
+	keyed_comparisons = 0;
+	ASSERT_TRUE(dyn_array_sort(array, compare_keyed));
+	EXPECT_TRUE(dyn_array_is_sorted(array, compare_keyed));
+	EXPECT_EQ(keyed_comparisons, (size_t)0);
+
+	// Sorted inserts keep the array sorted, other inserts don't
+	keyed_t object = {5, (uint32_t)n};
+	ASSERT_TRUE(dyn_array_insert_sorted(array, &object, compare_keyed));
+	keyed_comparisons = 0;
+	EXPECT_TRUE(dyn_array_is_sorted(array, compare_keyed));
+	EXPECT_EQ(keyed_comparisons, (size_t)0);
+	ASSERT_TRUE(dyn_array_erase(array, 15));
+	object.key = 0;
+	ASSERT_TRUE(dyn_array_push_back(array, &object));
+	EXPECT_FALSE(dyn_array_is_sorted(array, compare_keyed));
+	ASSERT_TRUE(dyn_array_sort(array, compare_keyed));
+	EXPECT_EQ(((const keyed_t *)dyn_array_export(array))[0].key, (uint32_t)0);
+
+	// Keys changed through the pointers at hands out are sorted again
+	((keyed_t *)dyn_array_at(array, 0))->key = (uint32_t)n;
+	((keyed_t *)dyn_array_at(array, n - 1))->key = 0;
+	keyed_comparisons = 0;
+	EXPECT_FALSE(dyn_array_is_sorted(array, compare_keyed));
+	EXPECT_GT(keyed_comparisons, (size_t)0);
+	ASSERT_TRUE(dyn_array_sort(array, compare_keyed));
+	EXPECT_TRUE(dyn_array_is_sorted(array, compare_keyed));
+	EXPECT_EQ(((const keyed_t *)dyn_array_back(array))->key, (uint32_t)n);
+
+	// Descending input is one run, reversed
+	dyn_array_clear(array);
+	for (size_t i = 0; i < n; ++i)
+	{
+		keyed_t descending = {(uint32_t)(n - i), (uint32_t)i};
+		ASSERT_TRUE(dyn_array_push_back(array, &descending));
+	}
+	keyed_comparisons = 0;
+	ASSERT_TRUE(dyn_array_sort(array, compare_keyed));
+	EXPECT_EQ(keyed_comparisons, n - 1);
+	EXPECT_EQ(((const keyed_t *)dyn_array_back(array))->key, (uint32_t)n);
+	dyn_array_destroy(array);
+}
+
+TEST(dyn_array_sort, MatchesStableSort)
+{
+	srand(49);
+	for (size_t n : {1, 2, 31, 33, 100, 1000, 4097})
+	{
+		// Random keys with many ties, then the same with a few sorted runs spliced in
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			std::vector<keyed_t> expected(n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				expected[i].key = pass && i % 200 < 150 ? (uint32_t)(i / 4) : (uint32_t)(rand() % 64);
+				expected[i].tag = (uint32_t)i;
+			}
+			dyn_array_t *array = dyn_array_import(expected.data(), n, sizeof(keyed_t), NULL);
+			ASSERT_NE(array, nullptr);
+			std::stable_sort(expected.begin(), expected.end(),
+							 [](const keyed_t &a, const keyed_t &b) { return a.key < b.key; });
+			ASSERT_TRUE(dyn_array_sort(array, compare_keyed));
+			for (size_t i = 0; i < n; ++i)
+			{
+				const keyed_t *object = (const keyed_t *)dyn_array_at(array, i);
+				ASSERT_EQ(object->key, expected[i].key) << n << " " << i;
+				ASSERT_EQ(object->tag, expected[i].tag) << n << " " << i;
+			}
+			dyn_array_destroy(array);
+		}
+	}
+}
+
+// Scaling: each scheduler and the loader run at sizes n, 2n, 4n, 8n and their operation counts must grow
+// no faster than the complexity declared for them. Counts don't depend on the machine or its load, so an
+// accidental O(n^2) path fails here while still passing the small correctness tests.
+enum scaling_bound_t
+{
+	SCALING_LINEAR,
+	SCALING_LINEARITHMIC
+};
+
+static double scaling_growth(scaling_bound_t bound, size_t from, size_t to)
+{
+	const double ratio = (double)to / (double)from;
+	return bound == SCALING_LINEAR ? ratio : ratio * log2((double)to) / log2((double)from);
+}
+
+// n PCBs out of arrival order, arriving about as fast as they can be served so the ready queue stays short
+static dyn_array_t *make_scaling_workload(size_t n)
+{
+	dyn_array_t *pcbs = dyn_array_create(n, sizeof(ProcessControlBlock_t), NULL);
+	uint32_t seed = 50;
+	for (size_t i = 0; pcbs && i < n; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		ProcessControlBlock_t pcb = {};
+		pcb.remaining_burst_time = 1 + (seed >> 8) % 8;
+		pcb.priority = (seed >> 12) % 10;
+		pcb.arrival = 5 * i + (seed >> 16) % 64;
+		pcb.pid = (uint32_t)i;
+		pcb.deadline = pcb.arrival + 40;
+		if (!dyn_array_push_back(pcbs, &pcb))
+		{
+			dyn_array_destroy(pcbs);
+			return NULL;
+		}
+	}
+	return pcbs;
+}
+
+// Every counted operation but the sort timing
+static uint64_t scaling_operations(void)
+{
+	OpCounters_t counters;
+	op_counters_read(&counters);
+	uint64_t total = 0;
+	for (size_t i = 0; i < OP_COUNTER_COUNT; ++i)
+	{
+		total += i == OP_SORT_NANOSECONDS ? 0 : counters.counts[i];
+	}
+	return total;
+}
+
+// Counts must stay within 25% of the bound between neighbouring sizes
+static void check_scaling(const char *what, scaling_bound_t bound, const size_t *sizes, const uint64_t *operations,
+						  size_t count)
+{
+	for (size_t i = 1; i < count; ++i)
+	{
+		ASSERT_GT(operations[i - 1], (uint64_t)0) << what << " counted nothing at " << sizes[i - 1] << " PCBs";
+		const double growth = (double)operations[i] / (double)operations[i - 1];
+		EXPECT_LE(growth, 1.25 * scaling_growth(bound, sizes[i - 1], sizes[i]))
+			<< what << " operations from " << sizes[i - 1] << " to " << sizes[i] << " PCBs";
+	}
+}
+
+TEST(scaling, SchedulersGrowWithinTheirBounds)
+{
+	if (!op_counters_enabled())
+	{
+		GTEST_SKIP() << "built with OP_COUNTERS_DISABLED";
+	}
+	// Every policy runs on the simulator's heaps
+	const ScheduleAlgorithm_t algorithms[] = {
+		SCHEDULE_FCFS, SCHEDULE_SJF, SCHEDULE_PRIORITY, SCHEDULE_RR, SCHEDULE_SRT, SCHEDULE_PRIORITY_PREEMPTIVE,
+		SCHEDULE_MLFQ, SCHEDULE_CFS, SCHEDULE_EDF, SCHEDULE_EDF_PREEMPTIVE, SCHEDULE_HRRN,
+	};
+	const size_t sizes[] = {500, 1000, 2000, 4000};
+	const size_t size_count = sizeof(sizes) / sizeof(sizes[0]);
+
+	for (const ScheduleAlgorithm_t algorithm : algorithms)
+	{
+		ScheduleConfig_t config = {};
+		config.algorithm = algorithm;
+		config.quantum = 4;
+		config.aging_interval = 16;
+		config.levels = 3;
+		config.target_latency = 24;
+		config.min_granularity = 3;
+		uint64_t operations[size_count];
+		for (size_t i = 0; i < size_count; ++i)
+		{
+			dyn_array_t *workload = make_scaling_workload(sizes[i]);
+			ASSERT_NE(workload, nullptr);
+			ScheduleResult_t result;
+			op_counters_reset();
+			ASSERT_TRUE(schedule_processes(workload, &config, &result)) << algorithm;
+			operations[i] = scaling_operations();
+			dyn_array_destroy(workload);
+		}
+		char name[32];
+		snprintf(name, sizeof(name), "algorithm %d", (int)algorithm);
+		check_scaling(name, SCALING_LINEARITHMIC, sizes, operations, size_count);
+	}
+}
+
+TEST(scaling, LoaderIsLinear)
+{
+	if (!op_counters_enabled())
+	{
+		GTEST_SKIP() << "built with OP_COUNTERS_DISABLED";
+	}
+	// The loader's work is its read calls, the records it decodes and what it grows and moves to store them.
+	// Each record is decoded exactly once, and a loader moving what it already stored would grow its bytes
+	// moved quadratically.
+	const char *path = "scaling_pcbs.bin";
+	const size_t sizes[] = {20000, 40000, 80000, 160000};
+	const size_t size_count = sizeof(sizes) / sizeof(sizes[0]);
+	uint64_t operations[size_count];
+	for (size_t i = 0; i < size_count; ++i)
+	{
+		dyn_array_t *workload = make_scaling_workload(sizes[i]);
+		ASSERT_NE(workload, nullptr);
+		ASSERT_TRUE(save_process_control_blocks(path, workload));
+		dyn_array_destroy(workload);
+		op_counters_reset();
+		PcbWorkload_t *loaded = load_pcb_workload(path);
+		ASSERT_NE(loaded, nullptr);
+		ASSERT_EQ(dyn_array_size(loaded->pcbs), sizes[i]);
+		OpCounters_t counters;
+		op_counters_read(&counters);
+		EXPECT_EQ(counters.counts[OP_RECORDS_DECODED], (uint64_t)sizes[i]);
+		operations[i] = scaling_operations();
+		pcb_workload_destroy(loaded);
+	}
+	remove(path);
+	check_scaling("loader", SCALING_LINEAR, sizes, operations, size_count);
+}
+
 int main(int argc, char **argv)
 {
 	::testing::InitGoogleTest(&argc, argv);